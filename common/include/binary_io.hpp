@@ -0,0 +1,123 @@
+#ifndef WOW_SIMULATOR_BINARY_IO_HPP
+#define WOW_SIMULATOR_BINARY_IO_HPP
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Raw little helpers for the partial result files. Values are written as they are in memory, so a file is only meant
+// to be read back on the same kind of machine (all the targets we build for are little endian).
+class Binary_writer
+{
+public:
+    explicit Binary_writer(std::ostream& os) : os_(os) {}
+
+    template <typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be written as they are");
+        os_.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void write(const std::string& value)
+    {
+        write(static_cast<uint64_t>(value.size()));
+        os_.write(value.data(), static_cast<std::streamsize>(value.size()));
+    }
+
+    template <typename T>
+    void write(const std::vector<T>& values)
+    {
+        write(static_cast<uint64_t>(values.size()));
+        for (const auto& value : values)
+        {
+            write(value);
+        }
+    }
+
+    // written sorted by key, so the same content always gives the same bytes
+    template <typename Map>
+    void write_map(const Map& values)
+    {
+        const std::map<typename Map::key_type, typename Map::mapped_type> sorted(values.begin(), values.end());
+        write(static_cast<uint64_t>(sorted.size()));
+        for (const auto& value : sorted)
+        {
+            write(value.first);
+            write(value.second);
+        }
+    }
+
+    [[nodiscard]] bool good() const { return os_.good(); }
+
+private:
+    std::ostream& os_;
+};
+
+class Binary_reader
+{
+public:
+    explicit Binary_reader(std::istream& is) : is_(is) {}
+
+    template <typename T>
+    void read(T& value)
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read as they are");
+        is_.read(reinterpret_cast<char*>(&value), sizeof(T));
+    }
+
+    void read(std::string& value)
+    {
+        uint64_t size{};
+        read(size);
+        if (!good() || size > max_size) return fail();
+        value.resize(size);
+        is_.read(&value[0], static_cast<std::streamsize>(size));
+    }
+
+    template <typename T>
+    void read(std::vector<T>& values)
+    {
+        uint64_t size{};
+        read(size);
+        if (!good() || size > max_size) return fail();
+        values.resize(size);
+        for (auto& value : values)
+        {
+            read(value);
+        }
+    }
+
+    template <typename Map>
+    void read_map(Map& values)
+    {
+        uint64_t size{};
+        read(size);
+        if (!good() || size > max_size) return fail();
+        values.clear();
+        for (uint64_t i = 0; i < size && good(); i++)
+        {
+            typename Map::key_type key{};
+            typename Map::mapped_type value{};
+            read(key);
+            read(value);
+            values.emplace(std::move(key), std::move(value));
+        }
+    }
+
+    [[nodiscard]] bool good() const { return is_.good(); }
+
+private:
+    // anything larger is a corrupt file, not a real size
+    static constexpr uint64_t max_size = uint64_t{1} << 28u;
+
+    void fail() { is_.setstate(std::ios::failbit); }
+
+    std::istream& is_;
+};
+
+#endif // WOW_SIMULATOR_BINARY_IO_HPP
@@ -0,0 +1,40 @@
+#ifndef WOW_SIMULATOR_OPTION_INDEX_HPP
+#define WOW_SIMULATOR_OPTION_INDEX_HPP
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// The options and float options of a job, hashed once. Every lookup marks its key as known, as does declare() for
+// keys that are only read under some condition - whatever is left in unknown_keys() was given but isn't understood
+// by anything, usually a typo.
+class Option_index
+{
+public:
+    Option_index() = default;
+
+    Option_index(const std::vector<std::string>& options, const std::vector<std::string>& float_options_string,
+                 const std::vector<double>& float_options_val);
+
+    // a flag option, e.g. "use_slam"
+    bool has(const std::string& name);
+
+    // a float option, e.g. "fight_time_dd". the first one counts if it is given twice
+    double find(const std::string& name, double dflt = 0.0);
+
+    // like find, but warns if the option is missing
+    double value(const std::string& name);
+
+    void declare(const std::vector<std::string>& names);
+
+    // sorted
+    [[nodiscard]] std::vector<std::string> unknown_keys() const;
+
+private:
+    std::unordered_set<std::string> flags_{};
+    std::unordered_map<std::string, double> values_{};
+    std::unordered_set<std::string> known_{};
+};
+
+#endif // WOW_SIMULATOR_OPTION_INDEX_HPP
@@ -0,0 +1,47 @@
+#ifndef WOW_SIMULATOR_PARALLEL_HPP
+#define WOW_SIMULATOR_PARALLEL_HPP
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace Parallel
+{
+// number of worker threads to use, requested <= 0 means "one per hardware thread". always 1 for the website build
+int thread_count(int requested = 0);
+
+// calls func(i) for every i in [0, n), spread over up to n_threads threads. returns once all calls are done, the first
+// exception thrown by a call is rethrown here. inside a job of Task_graph::run the calls go to the graph's threads
+// instead, n_threads is ignored then
+void for_each_index(int n, const std::function<void(int)>& func, int n_threads = 0);
+
+// jobs of which some have to wait for others. run() starts every job as soon as the ones it depends on are done, up to
+// n_threads at a time. a job can only depend on jobs added before it, so running them in the order they were added is
+// always valid - that is what happens with a single thread. jobs should write to places of their own, then the result
+// does not depend on the order in which they happen to finish
+class Task_graph
+{
+public:
+    using Task_id = size_t;
+
+    Task_id add(std::function<void()> func, const std::vector<Task_id>& dependencies = {});
+
+    // returns once all jobs are done. a job that throws cancels the jobs depending on it (directly or not), the others
+    // still run. the first exception is rethrown here. the n_threads threads also run the for_each_index loops of the
+    // jobs, so there are never more than n_threads threads at work
+    void run(int n_threads = 0);
+
+private:
+    struct Task
+    {
+        std::function<void()> func;
+        std::vector<Task_id> dependents{};
+        size_t n_dependencies{};
+    };
+
+    std::vector<Task> tasks_{};
+};
+
+} // namespace Parallel
+
+#endif // WOW_SIMULATOR_PARALLEL_HPP
@@ -0,0 +1,66 @@
+#include "option_index.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+
+Option_index::Option_index(const std::vector<std::string>& options, const std::vector<std::string>& float_options_string,
+                           const std::vector<double>& float_options_val)
+{
+    if (float_options_string.size() != float_options_val.size())
+    {
+        std::cout << "Cant create option index with two vectors of different size!";
+        assert(float_options_string.size() == float_options_val.size());
+    }
+    flags_.insert(options.begin(), options.end());
+    values_.reserve(float_options_string.size());
+    for (size_t i = 0; i < float_options_string.size(); i++)
+    {
+        values_.emplace(float_options_string[i], float_options_val[i]);
+    }
+}
+
+bool Option_index::has(const std::string& name)
+{
+    known_.insert(name);
+    return flags_.count(name) > 0;
+}
+
+double Option_index::find(const std::string& name, double dflt)
+{
+    known_.insert(name);
+    auto it = values_.find(name);
+    return it != values_.end() ? it->second : dflt;
+}
+
+double Option_index::value(const std::string& name)
+{
+    known_.insert(name);
+    auto it = values_.find(name);
+    if (it == values_.end())
+    {
+        std::cout << "WARN: Could not find: " << name << std::endl;
+        return 0.0;
+    }
+    return it->second;
+}
+
+void Option_index::declare(const std::vector<std::string>& names)
+{
+    known_.insert(names.begin(), names.end());
+}
+
+std::vector<std::string> Option_index::unknown_keys() const
+{
+    std::vector<std::string> unknown{};
+    for (const auto& flag : flags_)
+    {
+        if (known_.count(flag) == 0) unknown.push_back(flag);
+    }
+    for (const auto& value : values_)
+    {
+        if (known_.count(value.first) == 0 && flags_.count(value.first) == 0) unknown.push_back(value.first);
+    }
+    std::sort(unknown.begin(), unknown.end());
+    return unknown;
+}
@@ -0,0 +1,259 @@
+#include "parallel.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <exception>
+
+#ifndef __EMSCRIPTEN__
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#endif
+
+namespace Parallel
+{
+int thread_count(int requested)
+{
+#ifdef __EMSCRIPTEN__
+    (void)requested;
+    return 1; // no pthreads in the wasm build
+#else
+    if (requested > 0) return requested;
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()), 1);
+#endif
+}
+
+#ifndef __EMSCRIPTEN__
+namespace
+{
+// a for_each_index called from a task of a running Task_graph. its indices are taken by the calling thread and by the
+//  graph's idle threads, so nested loops don't start threads of their own
+struct Loop
+{
+    const std::function<void(int)>* func;
+    int n;
+    int next{};
+    int n_done{};
+    std::exception_ptr error{};
+};
+
+struct Pool
+{
+    std::mutex mutex{};
+    std::condition_variable changed{};
+    std::deque<Loop*> open_loops{}; // with indices nobody took yet
+
+    // takes the next index of loop and runs it, with the lock released meanwhile
+    void run_index(Loop& loop, std::unique_lock<std::mutex>& lock)
+    {
+        const int i = loop.next++;
+        if (loop.next == loop.n) open_loops.erase(std::find(open_loops.begin(), open_loops.end(), &loop));
+
+        lock.unlock();
+        std::exception_ptr error{};
+        try
+        {
+            (*loop.func)(i);
+        }
+        catch (...)
+        {
+            error = std::current_exception();
+        }
+        lock.lock();
+
+        if (error && !loop.error) loop.error = error;
+        if (++loop.n_done == loop.n) changed.notify_all();
+    }
+
+    void run_loop(int n, const std::function<void(int)>& func)
+    {
+        Loop loop{&func, n};
+        std::unique_lock<std::mutex> lock(mutex);
+        open_loops.push_back(&loop);
+        changed.notify_all();
+
+        while (loop.next < loop.n)
+        {
+            run_index(loop, lock);
+        }
+        changed.wait(lock, [&loop]() { return loop.n_done == loop.n; });
+        if (loop.error) std::rethrow_exception(loop.error);
+    }
+};
+
+thread_local Pool* current_pool = nullptr;
+} // namespace
+#endif
+
+void for_each_index(int n, const std::function<void(int)>& func, int n_threads)
+{
+    if (n <= 0) return;
+
+#ifndef __EMSCRIPTEN__
+    if (current_pool)
+    {
+        current_pool->run_loop(n, func);
+        return;
+    }
+#endif
+
+    n_threads = std::min(thread_count(n_threads), n);
+    if (n_threads <= 1)
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            func(i);
+        }
+        return;
+    }
+
+#ifndef __EMSCRIPTEN__
+    std::atomic<int> next{0};
+    auto worker = [&]() {
+        for (int i = next++; i < n; i = next++)
+        {
+            func(i);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (int i = 0; i < n_threads - 1; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+#endif
+}
+
+Task_graph::Task_id Task_graph::add(std::function<void()> func, const std::vector<Task_id>& dependencies)
+{
+    const Task_id id = tasks_.size();
+    tasks_.push_back({std::move(func)});
+    for (auto dependency : dependencies)
+    {
+        assert(dependency < id);
+        tasks_[dependency].dependents.push_back(id);
+        ++tasks_[id].n_dependencies;
+    }
+    return id;
+}
+
+void Task_graph::run(int n_threads)
+{
+    // a task whose dependency failed (or was cancelled itself) is cancelled, its results would be built on nothing
+    std::vector<char> cancelled(tasks_.size());
+    std::exception_ptr error{};
+    auto finish = [&](Task_id id, bool failed) {
+        if (!failed && !cancelled[id]) return;
+        for (auto dependent : tasks_[id].dependents)
+        {
+            cancelled[dependent] = true;
+        }
+    };
+
+    n_threads = thread_count(n_threads);
+    if (n_threads <= 1 || tasks_.size() <= 1)
+    {
+        for (Task_id id = 0; id < tasks_.size(); ++id)
+        {
+            bool failed = false;
+            if (!cancelled[id])
+            {
+                try
+                {
+                    tasks_[id].func();
+                }
+                catch (...)
+                {
+                    if (!error) error = std::current_exception();
+                    failed = true;
+                }
+            }
+            finish(id, failed);
+        }
+        if (error) std::rethrow_exception(error);
+        return;
+    }
+
+#ifndef __EMSCRIPTEN__
+    // the threads run tasks and help with the loops those tasks start, loops first - they are what tasks wait for
+    Pool pool{};
+    std::deque<Task_id> ready{};
+    std::vector<size_t> waiting_for(tasks_.size());
+    size_t n_finished{};
+    for (Task_id id = 0; id < tasks_.size(); ++id)
+    {
+        waiting_for[id] = tasks_[id].n_dependencies;
+        if (waiting_for[id] == 0) ready.push_back(id);
+    }
+
+    auto worker = [&]() {
+        auto* const outer_pool = current_pool;
+        current_pool = &pool;
+
+        std::unique_lock<std::mutex> lock(pool.mutex);
+        while (true)
+        {
+            pool.changed.wait(lock, [&]() {
+                return !pool.open_loops.empty() || !ready.empty() || n_finished == tasks_.size();
+            });
+            if (!pool.open_loops.empty())
+            {
+                pool.run_index(*pool.open_loops.front(), lock);
+                continue;
+            }
+            if (ready.empty()) break;
+            const auto id = ready.front();
+            ready.pop_front();
+
+            std::exception_ptr task_error{};
+            if (!cancelled[id])
+            {
+                lock.unlock();
+                try
+                {
+                    tasks_[id].func();
+                }
+                catch (...)
+                {
+                    task_error = std::current_exception();
+                }
+                lock.lock();
+                if (task_error && !error) error = task_error;
+            }
+
+            finish(id, task_error != nullptr);
+            for (auto dependent : tasks_[id].dependents)
+            {
+                if (--waiting_for[dependent] == 0) ready.push_back(dependent);
+            }
+            ++n_finished;
+            pool.changed.notify_all();
+        }
+
+        current_pool = outer_pool;
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(n_threads - 1);
+    for (int i = 0; i < n_threads - 1; ++i)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    if (error) std::rethrow_exception(error);
+#endif
+}
+
+} // namespace Parallel
@@ -1,7 +1,15 @@
 #include "find_values.hpp"
+#include "option_index.hpp"
+#include "parallel.hpp"
 
 #include "gtest/gtest.h"
 
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <set>
+#include <thread>
+
 TEST(TestSuite, test_find_value_class)
 {
     std::vector<std::string> mult_armor_vec;
@@ -44,4 +52,94 @@ TEST(TestSuite, test_find_value_class)
         EXPECT_TRUE(fv.find("destroyer_greaves") == 8.0);
         EXPECT_TRUE(fv.find("warboots_of_obliteration") == 9.0);
     }
-}
\ No newline at end of file
+}
+
+TEST(TestSuite, test_option_index)
+{
+    Option_index options{{"use_slam", "fight_time_dd", "use_slma"},
+                         {"fight_time_dd", "initial_rage_dd", "fight_time_dd", "typo_dd"},
+                         {120.0, 20.0, 60.0, 1.0}};
+
+    EXPECT_TRUE(options.has("use_slam"));
+    EXPECT_FALSE(options.has("use_whirlwind"));
+    EXPECT_EQ(options.find("fight_time_dd"), 120.0);
+    EXPECT_EQ(options.value("initial_rage_dd"), 20.0);
+    EXPECT_EQ(options.find("execute_phase_percentage_dd", 15.0), 15.0);
+
+    EXPECT_EQ(options.unknown_keys(), (std::vector<std::string>{"typo_dd", "use_slma"}));
+
+    options.declare({"typo_dd"});
+    EXPECT_EQ(options.unknown_keys(), (std::vector<std::string>{"use_slma"}));
+}
+
+TEST(TestSuite, test_task_graph)
+{
+    for (int n_threads : {1, 4})
+    {
+        Parallel::Task_graph tasks{};
+        std::vector<int> results(5);
+        const auto a = tasks.add([&]() { results[0] = 2; });
+        const auto b = tasks.add([&]() { results[1] = 3; });
+        const auto c = tasks.add([&]() { results[2] = results[0] * results[1]; }, {a, b});
+        tasks.add([&]() { results[3] = results[2] + 1; }, {c});
+        tasks.add([&]() { results[4] = results[0] + 10; }, {a});
+        tasks.run(n_threads);
+
+        EXPECT_EQ(results, (std::vector<int>{2, 3, 6, 7, 12}));
+    }
+
+    // a failed task cancels everything built on it, the rest still runs
+    for (int n_threads : {1, 2})
+    {
+        Parallel::Task_graph failing{};
+        int after_failure{};
+        int after_cancelled{};
+        int independent{};
+        const auto first = failing.add([]() { throw std::runtime_error("task failed"); });
+        const auto second = failing.add([&]() { after_failure = 1; }, {first});
+        failing.add([&]() { after_cancelled = 1; }, {second});
+        failing.add([&]() { independent = 1; });
+        EXPECT_THROW(failing.run(n_threads), std::runtime_error);
+        EXPECT_EQ(after_failure, 0);
+        EXPECT_EQ(after_cancelled, 0);
+        EXPECT_EQ(independent, 1);
+    }
+}
+
+TEST(TestSuite, test_task_graph_shares_threads)
+{
+    // the loops inside the tasks run on the graph's threads, not on threads of their own
+    const int n_threads = 3;
+    std::mutex mutex;
+    std::set<std::thread::id> threads{};
+    std::atomic<int> n_calls{0};
+
+    Parallel::Task_graph tasks{};
+    for (int task = 0; task < 4; ++task)
+    {
+        tasks.add([&]() {
+            Parallel::for_each_index(50, [&](int) {
+                ++n_calls;
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+                std::lock_guard<std::mutex> lock(mutex);
+                threads.insert(std::this_thread::get_id());
+            }, 8);
+        });
+    }
+    tasks.run(n_threads);
+
+    EXPECT_EQ(n_calls, 200);
+    EXPECT_LE(threads.size(), static_cast<size_t>(n_threads));
+
+    // failures inside such a loop reach the task
+    Parallel::Task_graph failing{};
+    int after_failure{};
+    const auto loop = failing.add([]() {
+        Parallel::for_each_index(10, [](int i) {
+            if (i == 7) throw std::runtime_error("index failed");
+        });
+    });
+    failing.add([&]() { after_failure = 1; }, {loop});
+    EXPECT_THROW(failing.run(n_threads), std::runtime_error);
+    EXPECT_EQ(after_failure, 0);
+}
@@ -3,18 +3,32 @@
 
 #include "Armory.hpp"
 
+#include <functional>
+
+class Surrogate_model;
+
 class Item_optimizer
 {
 public:
     static bool no_weapons(const Weapon&) { return true; }
     static bool no_armors(const Armor&) { return true; }
 
+    // the items that fewer than keep_n_stronger_items others beat, by dominance or by the estimated stat difference.
+    //  items the estimate can't judge (procs, use effects, sets) always stay. the explanation of every removal is only
+    //  written out if debug_message is given. a fitted surrogate replaces the fixed stat estimate
     static std::vector<Weapon> remove_weaker_weapons(Weapon_socket weapon_socket, const std::vector<Weapon>& weapon_vec,
-                                              const Special_stats& special_stats, std::string& debug_message,
-                                              int keep_n_stronger_items, const std::function<bool(const Weapon&)>& filter = no_weapons);
+                                              const Special_stats& special_stats, std::string* debug_message,
+                                              int keep_n_stronger_items, const std::function<bool(const Weapon&)>& filter = no_weapons,
+                                              const Surrogate_model* surrogate = nullptr);
+
+    // what remove_weaker_weapons orders and compares the weapons by, in attack power: the stats (by the surrogate when
+    //  given) and the damage per second. differences times the surrogate's attack power weight are the dps it expects
+    static double estimated_weapon_ap(Weapon_socket weapon_socket, const Weapon& weapon,
+                                      const Special_stats& special_stats, const Surrogate_model* surrogate = nullptr);
 
     static std::vector<Armor> remove_weaker_items(const std::vector<Armor>& armors, const Special_stats& special_stats,
-                                           std::string& debug_message, int keep_n_stronger_items, const std::function<bool(const Armor&)>& filter = no_armors);
+                                           std::string* debug_message, int keep_n_stronger_items, const std::function<bool(const Armor&)>& filter = no_armors,
+                                           const Surrogate_model* surrogate = nullptr);
 };
 
 #endif // WOW_SIMULATOR_ITEM_OPTIMIZER_HPP
@@ -0,0 +1,54 @@
+#ifndef WOW_SIMULATOR_SURROGATE_MODEL_HPP
+#define WOW_SIMULATOR_SURROGATE_MODEL_HPP
+
+#include "Combat_simulator.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The dps of one character (gear, talents, buffs, target) around its current stats, as a linear function of the plain
+// stat fields items carry. The weights are fitted from simulations of the character itself (simulate_stat_gradient),
+// so they replace the fixed weights of item_heuristics when ordering and pruning upgrade candidates. Procs, use
+// effects and set bonuses are not part of it - candidates that have those have to be simulated anyway.
+class Surrogate_model
+{
+public:
+    // not fitted, the item heuristics are used instead
+    Surrogate_model() = default;
+
+    // costs about config.n_batches fights of the character. stays unfitted if attack power doesn't come out as a gain
+    static Surrogate_model fit(const Combat_simulator_config& config, const Character& character);
+
+    // the model stored in path for this fingerprint (of the character and the settings), otherwise a new fit that is
+    //  then stored there
+    static Surrogate_model load_or_fit(const std::string& path, uint64_t fingerprint,
+                                       const Combat_simulator_config& config, const Character& character);
+
+    [[nodiscard]] bool fitted() const { return !weights_.empty(); }
+
+    [[nodiscard]] double dps_diff(const Special_stats& from, const Special_stats& to) const;
+
+    // the same in attack power equivalents, with each gain counted at the low end of its weight's 95% interval and
+    //  each loss at the high end. like estimate_stat_diff, positive means better for sure
+    [[nodiscard]] double ap_diff_low(const Special_stats& from, const Special_stats& to) const;
+
+    // in attack power equivalents, without the margin
+    [[nodiscard]] double ap_diff(const Special_stats& from, const Special_stats& to) const;
+
+    // "ap", "crit", ..., in the order of weights()
+    [[nodiscard]] static std::vector<std::string> field_names();
+
+    // dps per unit of each field (crit and hit per %, haste per 1.0 of haste), and the 95% half widths
+    [[nodiscard]] const std::vector<double>& weights() const { return weights_; }
+    [[nodiscard]] const std::vector<double>& errors() const { return errors_; }
+
+    bool save(const std::string& path, uint64_t fingerprint) const;
+    [[nodiscard]] bool load(const std::string& path, uint64_t fingerprint);
+
+private:
+    std::vector<double> weights_{};
+    std::vector<double> errors_{};
+};
+
+#endif // WOW_SIMULATOR_SURROGATE_MODEL_HPP
@@ -2,6 +2,9 @@
 
 #include "item_heuristics.hpp"
 #include "string_helpers.hpp"
+#include "surrogate_model.hpp"
+
+#include <algorithm>
 
 struct Weapon_struct
 {
@@ -72,79 +75,132 @@ bool is_strictly_weaker_wep(const Weapon_struct& wep_struct1, const Weapon_struc
     return greater_eq && greater;
 }
 
+double estimate_wep_ap(const Weapon_struct& wep, bool main_hand)
+{
+    double wep_ap = wep.average_damage / wep.swing_speed * 14;
+    if (main_hand) wep_ap += 100 * (wep.swing_speed - 2.3);
+    return main_hand ? wep_ap : 0.5 * wep_ap;
+}
+
 double estimate_wep_stat_diff(const Weapon_struct& wep1, const Weapon_struct& wep2, bool main_hand)
 {
-    double wep_1_ap = wep1.average_damage / wep1.swing_speed * 14;
-    if (main_hand) wep_1_ap += 100 * (wep1.swing_speed - 2.3);
-    double wep_2_ap = wep2.average_damage / wep2.swing_speed * 14;
-    if (main_hand) wep_2_ap += 100 * (wep2.swing_speed - 2.3);
+    return estimate_wep_ap(wep2, main_hand) - estimate_wep_ap(wep1, main_hand);
+}
 
-    return main_hand ? wep_2_ap - wep_1_ap : 0.5 * (wep_2_ap - wep_1_ap);
+double surrogate_or_estimate_ap(const Surrogate_model* surrogate, const Special_stats& special_stats)
+{
+    return surrogate ? surrogate->ap_diff({}, special_stats) : estimate_special_stats_low(special_stats);
 }
 
-std::vector<Weapon> Item_optimizer::remove_weaker_weapons(const Weapon_socket weapon_socket,
-                                                          const std::vector<Weapon>& weapon_vec,
-                                                          const Special_stats& special_stats,
-                                                          std::string& debug_message, int keep_n_stronger_items,
-                                                          const std::function<bool(const Weapon&)>& filter)
+double surrogate_or_estimate_diff(const Surrogate_model* surrogate, const Special_stats& special_stats1,
+                                  const Special_stats& special_stats2)
 {
-    std::vector<Weapon_struct> wep_structs;
-    wep_structs.reserve(weapon_vec.size());
+    return surrogate ? surrogate->ap_diff_low(special_stats1, special_stats2) :
+                       estimate_stat_diff(special_stats1, special_stats2);
+}
 
-    for (const auto& w : weapon_vec)
+// Marks the items that have at least keep_n_stronger_items other items stronger than them. Every pair could be
+// compared, but the candidates are tried in the order of a rough score (strongest first) - a weak item then meets
+// enough stronger ones after a few comparisons, and only the few strongest items compare against all others. The
+// result is the same either way, is_stronger(item, candidate, reason) decides and fills in reason when it is non-null
+template <typename Item_struct, typename Score, typename Is_stronger>
+void mark_weaker_items(std::vector<Item_struct>& items, int keep_n_stronger_items, Score score,
+                       Is_stronger is_stronger, std::string* debug_message)
+{
+    std::vector<size_t> candidates{};
+    std::vector<double> scores(items.size());
+    for (size_t i = 0; i < items.size(); ++i)
     {
-        if (filter(w)) continue;
-        wep_structs.emplace_back(w, special_stats);
+        if (!items[i].can_be_estimated) continue;
+        candidates.push_back(i);
+        scores[i] = score(items[i]);
     }
+    std::stable_sort(candidates.begin(), candidates.end(), [&scores](size_t a, size_t b) { return scores[a] > scores[b]; });
 
-    for (auto& wep1 : wep_structs)
+    std::string reason{};
+    for (auto& item : items)
     {
-        if (!wep1.can_be_estimated) continue;
+        if (!item.can_be_estimated) continue;
 
-        auto stronger_found = 0;
-        for (const auto& wep2 : wep_structs)
+        int stronger_found = 0;
+        for (auto candidate : candidates)
         {
-            if (wep1 == wep2 || !wep2.can_be_estimated) continue;
+            if (&items[candidate] == &item) continue;
+            if (!is_stronger(item, items[candidate], debug_message ? &reason : nullptr)) continue;
 
-            if (wep1.type() == wep2.type() && is_strictly_weaker_wep(wep1, wep2, weapon_socket))
-            {
-                stronger_found++;
-                debug_message += String_helpers::string_with_precision(stronger_found) + "/" +
-                                 String_helpers::string_with_precision(keep_n_stronger_items) + " since <b>" +
-                                 wep2.name() + "</b> is better than <b>" + wep1.name() + "</b> in all aspects.<br>";
-            }
-            else
+            stronger_found++;
+            if (debug_message)
             {
-                auto stat_diff = estimate_stat_diff(wep1.special_stats, wep2.special_stats);
-                auto wep_stat_diff = estimate_wep_stat_diff(wep1, wep2, weapon_socket == Weapon_socket::main_hand);
-                if (stat_diff + wep_stat_diff > 0)
-                {
-                    stronger_found++;
-                    debug_message += String_helpers::string_with_precision(stronger_found) + "/" +
-                                     String_helpers::string_with_precision(keep_n_stronger_items) +
-                                     " since <b>" + wep2.name() + "</b> was estimated to be <b>" +
-                                     String_helpers::string_with_precision(stat_diff + wep_stat_diff, 3) +
-                                     " AP </b>better than <b>" + wep1.name() + "</b>.<br>";
-                }
+                *debug_message += String_helpers::string_with_precision(stronger_found) + "/" +
+                                  String_helpers::string_with_precision(keep_n_stronger_items) + reason;
             }
-
             if (stronger_found >= keep_n_stronger_items)
             {
-                wep1.remove = true;
-                debug_message += "REMOVED:<b> " + wep1.name() + "</b>.<br>";
+                item.remove = true;
+                if (debug_message) *debug_message += "REMOVED:<b> " + item.name() + "</b>.<br>";
                 break;
             }
         }
     }
+}
 
-    debug_message += "Weapons left:<br>";
+double Item_optimizer::estimated_weapon_ap(Weapon_socket weapon_socket, const Weapon& weapon,
+                                           const Special_stats& special_stats, const Surrogate_model* surrogate)
+{
+    const Weapon_struct wep{weapon, special_stats};
+    return surrogate_or_estimate_ap(surrogate, wep.special_stats) +
+           estimate_wep_ap(wep, weapon_socket == Weapon_socket::main_hand);
+}
+
+std::vector<Weapon> Item_optimizer::remove_weaker_weapons(const Weapon_socket weapon_socket,
+                                                          const std::vector<Weapon>& weapon_vec,
+                                                          const Special_stats& special_stats,
+                                                          std::string* debug_message, int keep_n_stronger_items,
+                                                          const std::function<bool(const Weapon&)>& filter,
+                                                          const Surrogate_model* surrogate)
+{
+    std::vector<Weapon_struct> wep_structs;
+    wep_structs.reserve(weapon_vec.size());
+
+    for (const auto& w : weapon_vec)
+    {
+        if (filter(w)) continue;
+        wep_structs.emplace_back(w, special_stats);
+    }
+
+    const bool main_hand = weapon_socket == Weapon_socket::main_hand;
+    auto score = [main_hand, surrogate](const Weapon_struct& wep) {
+        return surrogate_or_estimate_ap(surrogate, wep.special_stats) + estimate_wep_ap(wep, main_hand);
+    };
+    auto is_stronger = [weapon_socket, main_hand, surrogate](const Weapon_struct& wep1, const Weapon_struct& wep2, std::string* reason) {
+        if (wep1.type() == wep2.type() && is_strictly_weaker_wep(wep1, wep2, weapon_socket))
+        {
+            if (reason) *reason = " since <b>" + wep2.name() + "</b> is better than <b>" + wep1.name() + "</b> in all aspects.<br>";
+            return true;
+        }
+
+        auto stat_diff = surrogate_or_estimate_diff(surrogate, wep1.special_stats, wep2.special_stats);
+        auto wep_stat_diff = estimate_wep_stat_diff(wep1, wep2, main_hand);
+        if (stat_diff + wep_stat_diff <= 0) return false;
+
+        if (reason)
+        {
+            *reason = " since <b>" + wep2.name() + "</b> was estimated to be <b>" +
+                      String_helpers::string_with_precision(stat_diff + wep_stat_diff, 3) +
+                      " AP </b>better than <b>" + wep1.name() + "</b>.<br>";
+        }
+        return true;
+    };
+    mark_weaker_items(wep_structs, keep_n_stronger_items, score, is_stronger, debug_message);
+
+    if (debug_message) *debug_message += "Weapons left:<br>";
     std::vector<Weapon> filtered_weapons;
     filtered_weapons.reserve(keep_n_stronger_items);
     for (const auto& w : wep_structs)
     {
         if (w.remove) continue;
         filtered_weapons.push_back(w.weapon.get());
-        debug_message += "<b>" + w.name() + "</b><br>";
+        if (debug_message) *debug_message += "<b>" + w.name() + "</b><br>";
     }
 
     return filtered_weapons;
@@ -167,8 +223,9 @@ struct Armor_struct
 };
 
 std::vector<Armor> Item_optimizer::remove_weaker_items(const std::vector<Armor>& armors,
-                                                       const Special_stats& special_stats, std::string& debug_message,
-                                                       int keep_n_stronger_items, const std::function<bool(const Armor&)>& filter)
+                                                       const Special_stats& special_stats, std::string* debug_message,
+                                                       int keep_n_stronger_items, const std::function<bool(const Armor&)>& filter,
+                                                       const Surrogate_model* surrogate)
 {
     std::vector<Armor_struct> armor_structs;
     armor_structs.reserve(armors.size());
@@ -179,46 +236,28 @@ std::vector<Armor> Item_optimizer::remove_weaker_items(const std::vector<Armor>&
         armor_structs.emplace_back(a, special_stats);
     }
 
-    for (auto& armor1 : armor_structs)
-    {
-        if (!armor1.can_be_estimated) continue;
-
-        int stronger_found = 0;
-        for (const auto& armor2 : armor_structs)
+    auto score = [surrogate](const Armor_struct& armor) { return surrogate_or_estimate_ap(surrogate, armor.special_stats); };
+    auto is_stronger = [surrogate](const Armor_struct& armor1, const Armor_struct& armor2, std::string* reason) {
+        if (armor1.special_stats < armor2.special_stats)
         {
-            if (armor1 == armor2 || !armor2.can_be_estimated) continue;
+            if (reason) *reason = " since <b>" + armor2.name() + "</b> is better than <b>" + armor1.name() + "</b> in all aspects.<br>";
+            return true;
+        }
 
-            if (armor1.special_stats < armor2.special_stats)
-            {
-                stronger_found++;
-                debug_message += String_helpers::string_with_precision(stronger_found) + "/" +
-                                 String_helpers::string_with_precision(keep_n_stronger_items) + " since <b>" +
-                                 armor2.name() + "</b> is better than <b>" + armor1.name() +
-                                 "</b> in all aspects.<br>";
-            }
-            else
-            {
-                auto stat_diff = estimate_stat_diff(armor1.special_stats, armor2.special_stats);
-                if (stat_diff > 0)
-                {
-                    stronger_found++;
-                    debug_message += String_helpers::string_with_precision(stronger_found) + "/" +
-                                     String_helpers::string_with_precision(keep_n_stronger_items) +
-                                     " since <b>" + armor2.name() + "</b> was estimated to be <b>" +
-                                     String_helpers::string_with_precision(stat_diff, 3) +
-                                     " AP </b>better than <b>" + armor1.name() + "</b>.<br>";
-                }
-            }
-            if (stronger_found >= keep_n_stronger_items)
-            {
-                armor1.remove = true;
-                debug_message += "REMOVED:<b> " + armor1.name() + "</b>.<br>";
-                break;
-            }
+        auto stat_diff = surrogate_or_estimate_diff(surrogate, armor1.special_stats, armor2.special_stats);
+        if (stat_diff <= 0) return false;
+
+        if (reason)
+        {
+            *reason = " since <b>" + armor2.name() + "</b> was estimated to be <b>" +
+                      String_helpers::string_with_precision(stat_diff, 3) + " AP </b>better than <b>" +
+                      armor1.name() + "</b>.<br>";
         }
-    }
+        return true;
+    };
+    mark_weaker_items(armor_structs, keep_n_stronger_items, score, is_stronger, debug_message);
 
-    debug_message += "Armors left:<br>";
+    if (debug_message) *debug_message += "Armors left:<br>";
     std::vector<Armor> filtered_armors;
     filtered_armors.reserve(keep_n_stronger_items);
     for (const auto& a : armor_structs)
@@ -226,7 +265,7 @@ std::vector<Armor> Item_optimizer::remove_weaker_items(const std::vector<Armor>&
         if (a.remove) continue;
 
         filtered_armors.push_back(a.armor.get());
-        debug_message += "<b>" + a.name() + "</b><br>";
+        if (debug_message) *debug_message += "<b>" + a.name() + "</b><br>";
     }
     return filtered_armors;
 }
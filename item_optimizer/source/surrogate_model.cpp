@@ -0,0 +1,144 @@
+#include "surrogate_model.hpp"
+
+#include "Statistics.hpp"
+#include "binary_io.hpp"
+#include "stat_accumulator.hpp"
+#include "stat_gradient.hpp"
+
+#include <fstream>
+
+namespace
+{
+constexpr uint32_t surrogate_magic = 0x47525553; // "SURG"
+constexpr uint32_t surrogate_version = 1;
+
+struct Surrogate_field
+{
+    const char* name;
+    Stat_field field;
+    double step; // how far the fit pushes the stat, about what a good item slot adds
+};
+
+// attack power first, the other weights are converted to it
+constexpr Surrogate_field surrogate_fields[] = {
+    {"ap", Stat_field::attack_power, 100},
+    {"crit", Stat_field::critical_strike, 2},
+    {"hit", Stat_field::hit, 1.5},
+    {"expertise", Stat_field::expertise, 6},
+    {"haste", Stat_field::haste, 0.03},
+    {"arpen", Stat_field::gear_armor_pen, 350},
+    {"bonus_damage", Stat_field::bonus_damage, 17},
+};
+constexpr size_t n_surrogate_fields = sizeof(surrogate_fields) / sizeof(surrogate_fields[0]);
+} // namespace
+
+Surrogate_model Surrogate_model::fit(const Combat_simulator_config& config, const Character& character)
+{
+    std::vector<Special_stats> deltas{};
+    for (const auto& field : surrogate_fields)
+    {
+        Special_stats delta{};
+        Stat_accumulator::set_value(delta, field.field, field.step);
+        deltas.push_back(delta);
+    }
+
+    const auto gradient = simulate_stat_gradient(config, character, deltas);
+    if (gradient.gains.size() != n_surrogate_fields || gradient.gains[0] <= 0)
+    {
+        return {};
+    }
+
+    static const double q95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
+    Surrogate_model model{};
+    for (size_t i = 0; i < n_surrogate_fields; i++)
+    {
+        model.weights_.push_back(gradient.gains[i] / surrogate_fields[i].step);
+        model.errors_.push_back(q95 * gradient.standard_errors[i] / surrogate_fields[i].step);
+    }
+    return model;
+}
+
+Surrogate_model Surrogate_model::load_or_fit(const std::string& path, uint64_t fingerprint,
+                                             const Combat_simulator_config& config, const Character& character)
+{
+    Surrogate_model model{};
+    if (model.load(path, fingerprint)) return model;
+
+    model = fit(config, character);
+    if (model.fitted()) model.save(path, fingerprint);
+    return model;
+}
+
+double Surrogate_model::dps_diff(const Special_stats& from, const Special_stats& to) const
+{
+    double diff = 0;
+    for (size_t i = 0; i < weights_.size(); i++)
+    {
+        const auto field = surrogate_fields[i].field;
+        diff += weights_[i] * (Stat_accumulator::value_of(to, field) - Stat_accumulator::value_of(from, field));
+    }
+    return diff;
+}
+
+double Surrogate_model::ap_diff_low(const Special_stats& from, const Special_stats& to) const
+{
+    double diff = 0;
+    for (size_t i = 0; i < weights_.size(); i++)
+    {
+        const auto field = surrogate_fields[i].field;
+        const auto delta = Stat_accumulator::value_of(to, field) - Stat_accumulator::value_of(from, field);
+        diff += (delta > 0 ? weights_[i] - errors_[i] : weights_[i] + errors_[i]) * delta;
+    }
+    return diff / weights_[0];
+}
+
+double Surrogate_model::ap_diff(const Special_stats& from, const Special_stats& to) const
+{
+    return dps_diff(from, to) / weights_[0];
+}
+
+std::vector<std::string> Surrogate_model::field_names()
+{
+    std::vector<std::string> names{};
+    for (const auto& field : surrogate_fields)
+    {
+        names.emplace_back(field.name);
+    }
+    return names;
+}
+
+bool Surrogate_model::save(const std::string& path, uint64_t fingerprint) const
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    Binary_writer writer{file};
+    writer.write(surrogate_magic);
+    writer.write(surrogate_version);
+    writer.write(fingerprint);
+    writer.write(weights_);
+    writer.write(errors_);
+    return writer.good();
+}
+
+bool Surrogate_model::load(const std::string& path, uint64_t fingerprint)
+{
+    std::ifstream file(path, std::ios::binary);
+    Binary_reader reader{file};
+    uint32_t magic{};
+    uint32_t version{};
+    uint64_t stored_fingerprint{};
+    std::vector<double> weights{};
+    std::vector<double> errors{};
+    reader.read(magic);
+    reader.read(version);
+    reader.read(stored_fingerprint);
+    reader.read(weights);
+    reader.read(errors);
+    if (!reader.good() || magic != surrogate_magic || version != surrogate_version || stored_fingerprint != fingerprint ||
+        weights.size() != n_surrogate_fields || errors.size() != n_surrogate_fields || weights[0] <= 0)
+    {
+        return false;
+    }
+    weights_ = std::move(weights);
+    errors_ = std::move(errors);
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef WOW_SIMULATOR_CHECKPOINT_HPP
+#define WOW_SIMULATOR_CHECKPOINT_HPP
+
+#include "Distribution.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Remembers the dps distribution of every finished candidate simulation (an item, a talent, a stat weight) of a long
+// job in a file, so a job that died can pick up where it stopped. Candidates are simulated deterministically from the
+// seed, so resuming gives the same final results as an uninterrupted run. Results are appended and flushed one by one,
+// a record cut off by a crash is dropped when loading. The file belongs to one job: if the job fingerprint doesn't
+// match (other gear, settings or seed), it is started over. Candidates may be computed from several threads at once.
+class Checkpoint
+{
+public:
+    // disabled, every candidate is simulated
+    Checkpoint() = default;
+
+    Checkpoint(std::string path, uint64_t job_fingerprint);
+
+    // the stored result for key, or compute() which is then stored. compute() runs without holding the lock
+    Distribution get_or_compute(const std::string& key, const std::function<Distribution()>& compute);
+
+    // the job finished, the file isn't needed anymore
+    void remove();
+
+    [[nodiscard]] bool enabled() const { return !path_.empty(); }
+    [[nodiscard]] size_t n_resumed() const { return n_resumed_; }
+    [[nodiscard]] const std::string& path() const { return path_; }
+
+private:
+    void append(const std::string& key, const Distribution& distribution);
+
+    std::string path_{};
+    uint64_t job_fingerprint_{};
+    std::unordered_map<std::string, Distribution> results_{};
+    size_t n_resumed_{};
+    std::ofstream file_{};
+    std::mutex mutex_{};
+};
+
+#endif // WOW_SIMULATOR_CHECKPOINT_HPP
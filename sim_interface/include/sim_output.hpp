@@ -1,6 +1,8 @@
 #ifndef SIM_OUTPUT_HPP
 #define SIM_OUTPUT_HPP
 
+#include "sim_results.hpp"
+
 #include <string>
 #include <vector>
 
@@ -22,7 +24,12 @@ struct Sim_output
             std::string histogram_details,
             std::vector<double> mean_dps,
             std::vector<double> std_dps,
-            std::vector<std::string> messages)
+            std::vector<std::string> messages,
+            std::vector<double> dps_percentiles,
+            std::vector<double> fight_lengths,
+            std::vector<double> fight_length_dps,
+            std::string response_surface,
+            Sim_results results)
             :
             hist_x(std::move(hist_x)),
             hist_y(std::move(hist_y)),
@@ -37,7 +44,12 @@ struct Sim_output
             histogram_details(std::move(histogram_details)),
             mean_dps(std::move(mean_dps)),
             std_dps(std::move(std_dps)),
-            messages(std::move(messages)) {}
+            messages(std::move(messages)),
+            dps_percentiles(std::move(dps_percentiles)),
+            fight_lengths(std::move(fight_lengths)),
+            fight_length_dps(std::move(fight_length_dps)),
+            response_surface(std::move(response_surface)),
+            results(std::move(results)) {}
 
     std::vector<int> hist_x;
     std::vector<int> hist_y;
@@ -53,6 +65,11 @@ struct Sim_output
     std::vector<double> mean_dps{};
     std::vector<double> std_dps{};
     std::vector<std::string> messages;
+    std::vector<double> dps_percentiles{}; // 5th, 50th and 95th percentile of the dps per fight
+    std::vector<double> fight_lengths{}; // only with the fight_length_sweep option
+    std::vector<double> fight_length_dps{};
+    std::string response_surface{}; // json, only with the response_surface option
+    Sim_results results{}; // the numbers behind the strings above, those stay empty with the structured_output option
 };
 
 #endif // SIM_OUTPUT_HPP
@@ -0,0 +1,52 @@
+#ifndef WOW_SIMULATOR_SIM_OUTPUT_RENDERER_HPP
+#define WOW_SIMULATOR_SIM_OUTPUT_RENDERER_HPP
+
+#include "sim_results.hpp"
+
+#include <string>
+#include <vector>
+
+// Turns Sim_results into the strings and html snippets the website shows. Only used when the output is rendered at
+// all, batch clients read Sim_results directly.
+namespace Sim_output_renderer
+{
+// "name value", for aura uptimes and procs
+std::vector<std::string> named_values(const std::vector<Named_value>& values);
+
+// "name time duration"
+std::vector<std::string> use_effects(const std::vector<Use_effect_timing>& use_effects);
+
+// "name:mean:error"
+std::vector<std::string> stat_weights(const std::vector<Estimate>& stat_weights);
+
+// empty if there are none
+std::string unknown_options(const std::vector<std::string>& unknown_options);
+
+// empty without the control_variates option
+std::string adjusted_dps(const Sim_results& results);
+
+// empty without the search_use_effect_schedule option
+std::string schedule_search(const Sim_results& results);
+
+std::string character_stats(const Sim_results& results);
+
+std::string fight_stats(const Sim_results& results);
+
+std::string rage(const Sim_results& results);
+
+std::string talent_weights(const std::vector<Estimate>& talent_weights);
+
+std::string item_upgrades(const Sim_results& results);
+
+// empty without the surrogate_model option
+std::string surrogate_model(const Sim_results& results);
+
+std::string dpr(const std::vector<Dpr_result>& dpr);
+
+std::string notable_fights(const std::vector<Notable_fight>& notable_fights);
+
+std::string histogram_details(double mean, double std, const std::vector<double>& dps_percentiles);
+
+} // namespace Sim_output_renderer
+
+#endif // WOW_SIMULATOR_SIM_OUTPUT_RENDERER_HPP
@@ -0,0 +1,151 @@
+#ifndef WOW_SIMULATOR_SIM_RESULTS_HPP
+#define WOW_SIMULATOR_SIM_RESULTS_HPP
+
+#include "Item.hpp"
+
+#include <string>
+#include <vector>
+
+// The results of Sim_interface::simulate as plain numbers and records, for clients that don't want to parse the
+// rendered text in Sim_output. sim_output_renderer.hpp turns them into that text.
+
+struct Named_value
+{
+    std::string name;
+    double value;
+};
+
+// a mean with the half width of its 95% confidence interval
+struct Estimate
+{
+    std::string name;
+    double mean;
+    double error;
+};
+
+struct Use_effect_timing
+{
+    std::string name;
+    double time; // s into the fight
+    double duration;
+};
+
+struct Item_upgrade_result
+{
+    Socket socket;
+    bool first_item; // false for the second ring or trinket
+    std::string current_item;
+    std::string item;
+    double dps_diff;
+    double error;
+};
+
+struct Dpr_result
+{
+    std::string ability;
+    double damage_per_cast;
+    double rage_cost;
+};
+
+// a fight of the base run, Combat_simulator::replay_fight() shows its combat log
+struct Notable_fight
+{
+    std::string name; // "min", "p5", "median", "p95" or "max"
+    int batch;
+    double dps;
+};
+
+// how the surrogate model's dps differences compared to the simulated upgrades of the items it could judge. the
+//  pruned ones are a sample of the candidates it removed, simulated only for this
+struct Surrogate_validation
+{
+    int n_items;
+    double mean_error; // predicted - simulated
+    double rms_error;
+    double rms_dps_diff; // of the simulated upgrades themselves, for scale
+    int n_pruned;
+    double pruned_mean_error;
+    double pruned_rms_error;
+    int n_pruned_better; // simulated better than the weakest candidate kept for the same socket
+};
+
+// the character's total stats. the <weapon type>_expertise ones are only set for the weapon types the character
+//  uses, -1 otherwise (dagger and unarmed only when dual wielding, as there are no talents for those)
+enum class Character_stat
+{
+    strength,
+    agility,
+    hit,
+    expertise,
+    crit,
+    attack_power,
+    bonus_attack_power,
+    haste_factor,
+    sword_expertise,
+    axe_expertise,
+    dagger_expertise,
+    mace_expertise,
+    unarmed_expertise,
+    size,
+};
+
+// chances against the target, in %. the off-hand ones are only set when dual wielding
+enum class Fight_stat
+{
+    yellow_mh_miss,
+    white_mh_miss,
+    white_oh_miss,
+    white_oh_queued_miss,
+    yellow_mh_crit,
+    white_mh_crit,
+    white_mh_left_to_crit_cap,
+    yellow_oh_crit,
+    white_oh_crit,
+    white_oh_left_to_crit_cap,
+    glance_chance,
+    glancing_penalty,
+    mh_dodge,
+    oh_dodge,
+    size,
+};
+
+struct Sim_results
+{
+    std::vector<std::string> unknown_options{}; // given, but not used by anything - ignored
+
+    bool dual_wield{};
+
+    double dps_std{}; // of a single fight, Sim_output::std_dps is the one of the mean
+
+    // the mean dps with the luck of the crit, miss/dodge and proc rolls regressed out, and the share of the variance
+    //  that's left after that. only with the control_variates option, the name is empty otherwise
+    Estimate adjusted_dps{};
+    double adjusted_dps_variance_ratio{};
+
+    std::vector<double> character_stats{}; // indexed by Character_stat
+    std::vector<std::string> set_bonuses{};
+
+    std::vector<double> fight_stats{}; // indexed by Fight_stat
+
+    double rage_lost_capped{}; // per fight
+    double rage_lost_stance{};
+
+    std::vector<Named_value> aura_uptimes{}; // % of the fight
+    std::vector<Named_value> procs{};        // per fight
+    std::vector<Use_effect_timing> use_effects{};
+
+    // dps of the searched over the computed use effect schedule, simulated on the same fights. the searched one is
+    //  only used if that comes out positive. only with the search_use_effect_schedule option, the name is empty otherwise
+    Estimate schedule_search_gain{};
+
+    std::vector<Estimate> stat_weights{};   // dps per 10 points of the stat
+    std::vector<Estimate> talent_weights{}; // dps per talent point
+    std::vector<Item_upgrade_result> item_upgrades{}; // best first, per socket
+    bool uneven_weapon_specializations{};             // weapons were compared with unequal sword/mace/axe talents
+    std::vector<Estimate> surrogate_weights{};        // dps per unit of the stat, only with the surrogate_model option
+    Surrogate_validation surrogate_validation{};
+    std::vector<Dpr_result> dpr{};
+    std::vector<Notable_fight> notable_fights{}; // to pick fights for replay_fight_dd
+};
+
+#endif // WOW_SIMULATOR_SIM_RESULTS_HPP
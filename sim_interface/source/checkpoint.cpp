@@ -0,0 +1,87 @@
+#include "checkpoint.hpp"
+
+#include "binary_io.hpp"
+
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+constexpr uint32_t checkpoint_magic = 0x504b4357; // "WCKP"
+constexpr uint32_t checkpoint_version = 1;
+} // namespace
+
+Checkpoint::Checkpoint(std::string path, uint64_t job_fingerprint)
+    : path_(std::move(path)), job_fingerprint_(job_fingerprint)
+{
+    std::vector<std::string> keys{};
+    {
+        std::ifstream in(path_, std::ios::binary);
+        Binary_reader reader{in};
+        uint32_t magic{};
+        uint32_t version{};
+        uint64_t fingerprint{};
+        reader.read(magic);
+        reader.read(version);
+        reader.read(fingerprint);
+        if (reader.good() && magic == checkpoint_magic && version == checkpoint_version && fingerprint == job_fingerprint_)
+        {
+            while (true)
+            {
+                std::string key{};
+                Distribution distribution{};
+                reader.read(key);
+                distribution.load(reader);
+                if (!reader.good()) break;
+                if (results_.emplace(key, distribution).second) keys.push_back(key);
+            }
+        }
+    }
+    n_resumed_ = results_.size();
+
+    // written anew with only the complete records, so appending doesn't end up behind a cut off one
+    file_.open(path_, std::ios::binary | std::ios::trunc);
+    Binary_writer writer{file_};
+    writer.write(checkpoint_magic);
+    writer.write(checkpoint_version);
+    writer.write(job_fingerprint_);
+    for (const auto& key : keys)
+    {
+        writer.write(key);
+        results_.at(key).save(writer);
+    }
+    file_.flush();
+}
+
+Distribution Checkpoint::get_or_compute(const std::string& key, const std::function<Distribution()>& compute)
+{
+    if (!enabled()) return compute();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = results_.find(key);
+        if (it != results_.end()) return it->second;
+    }
+
+    auto distribution = compute();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (results_.emplace(key, distribution).second) append(key, distribution);
+    return distribution;
+}
+
+void Checkpoint::append(const std::string& key, const Distribution& distribution)
+{
+    Binary_writer writer{file_};
+    writer.write(key);
+    distribution.save(writer);
+    file_.flush();
+}
+
+void Checkpoint::remove()
+{
+    if (!enabled()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    file_.close();
+    std::remove(path_.c_str());
+    path_.clear();
+}
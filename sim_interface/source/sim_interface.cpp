@@ -4,8 +4,21 @@
 #include "Combat_simulator.hpp"
 #include "Item_optimizer.hpp"
 #include "Statistics.hpp"
+#include "checkpoint.hpp"
 #include "item_heuristics.hpp"
-
+#include "option_index.hpp"
+#include "parallel.hpp"
+#include "response_surface.hpp"
+#include "shard.hpp"
+#include "sim_output_renderer.hpp"
+#include "stat_gradient.hpp"
+#include "surrogate_model.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <optional>
 #include <sstream>
 
 static const double q95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
@@ -19,18 +32,14 @@ void print_results(const Combat_simulator& sim, bool print_uptimes_and_procs)
     auto g = 60 * f;
 
     std::cout << std::fixed << std::setprecision(2);
-    std::cout << "white (mh)    = " << f * dd.white_mh_damage << " (" << g * dd.white_mh_count << "x)" << std::endl;
-    if (dd.white_oh_count > 0) std::cout << "white (oh)    = " << f * dd.white_oh_damage << " (" << g * dd.white_oh_count << "x)" << std::endl;
-    if (dd.mortal_strike_count > 0) std::cout << "mortal strike = " << f * dd.mortal_strike_damage << " (" << g * dd.mortal_strike_count << "x)" << std::endl;
-    if (dd.cleave_count > 0) std::cout << "cleave        = " << f * dd.cleave_damage << " (" << g * dd.cleave_count << "x)" << std::endl;
-    if (dd.bloodthirst_count > 0) std::cout << "bloodthirst   = " << f * dd.bloodthirst_damage << " (" << g * dd.bloodthirst_count << "x)" << std::endl;
-    if (dd.whirlwind_count > 0) std::cout << "whirlwind     = " << f * dd.whirlwind_damage << " (" << g * dd.whirlwind_count << "x)" << std::endl;
-    if (dd.slam_count > 0) std::cout << "slam          = " << f * dd.slam_damage << " (" << g * dd.slam_count << "x)" << std::endl;
-    if (dd.heroic_strike_count > 0) std::cout << "heroic strike = " << f * dd.heroic_strike_damage << " (" << g * dd.heroic_strike_count << "x)" << std::endl;
-    if (dd.execute_count > 0) std::cout << "execute       = " << f * dd.execute_damage << " (" << g * dd.execute_count << "x)" << std::endl;
-    if (dd.deep_wounds_count > 0) std::cout << "deep wounds   = " << f * dd.deep_wounds_damage << " (" << g * dd.deep_wounds_count << "x)" << std::endl;
-    if (dd.overpower_count > 0) std::cout << "overpower     = " << f * dd.overpower_damage << " (" << g * dd.overpower_count << "x)" << std::endl;
-    if (dd.item_hit_effects_count > 0) std::cout << "hit effects   = " << f * dd.item_hit_effects_damage << " (" << g * dd.item_hit_effects_count << "x)" << std::endl;
+    for (size_t i = 0; i < n_damage_sources; i++)
+    {
+        if (dd.counts[i] > 0 || i == static_cast<size_t>(Damage_source::white_mh))
+        {
+            std::cout << std::left << std::setw(17) << damage_source_names[i] << " = " << f * dd.damage[i] << " ("
+                      << g * dd.counts[i] << "x)" << std::endl;
+        }
+    }
     std::cout << "----------------------" << std::endl;
     std::cout << "total         = " << f * dd.sum_damage_sources() << std::endl;
     std::cout << std::endl;
@@ -51,54 +60,80 @@ void print_results(const Combat_simulator& sim, bool print_uptimes_and_procs)
 }
 #endif
 
-struct Item_upgrade {
-    std::string name;
-    double mean_diff;
-    double std_diff;
+Estimate compute_item_upgrade(const Combat_simulator_config& config, const Character& character,
+                              const Distribution& base_dps, const std::string& item_name,
+                              Checkpoint& checkpoint, const std::string& key)
+{
+    static const double q999 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.999), 0.01);
 
-    // TODO(vigo) consider labelling "<b>Side</b>grade" (" Note: Similar item stats, difficult to draw conclusions.")
-    [[nodiscard]] std::string to_string() const
-    {
-        std::string s;
-        if (mean_diff >= 0)
-        {
-            s += "<br><b>Up</b>grade: <b>" + name + "</b> ( +<b>";
-        }
-        else
-        {
-            s += "<br><b>Down</b>grade: <b>" + name + "</b> ( <b>";
-        }
-        s += String_helpers::string_with_precision(mean_diff, 1) + " &plusmn ";
-        s += String_helpers::string_with_precision(std_diff * q95, 1) + "</b> DPS).";
-        return s;
-    }
+    const auto dps = checkpoint.get_or_compute(key, [&config, &character, &base_dps]() {
+        auto& sim = Combat_simulator::pooled(config);
+        sim.simulate(character, [&base_dps](const Distribution& d) {
+            if (d.samples() <= 500) return false;
+            auto mean_diff = d.mean() - base_dps.mean();
+            auto std_diff = std::sqrt(d.var_of_the_mean() + base_dps.var_of_the_mean());
+            if (d.samples() > 500 && mean_diff < 0 && mean_diff <= -std_diff * q999) return true;
+            if (d.samples() > 5000 && mean_diff >= 0 && mean_diff >= std_diff * q999) return true;
+            if (d.samples() >= 20000) return true;
+            return false;
+        });
+        return sim.get_dps_distribution();
+    });
+    auto mean_diff = dps.mean() - base_dps.mean();
+    auto std_diff = std::sqrt(dps.var_of_the_mean() + base_dps.var_of_the_mean());
+    return {item_name, mean_diff, q95 * std_diff};
+}
+
+// the upgrades of one socket, and the surrogate's guesses at those it could judge. pruned_predicted_and_simulated
+//  are candidates the surrogate pruned, simulated only to check it, and n_pruned_better counts those that came out
+//  better than the weakest candidate it kept
+struct Socket_upgrades
+{
+    std::vector<Item_upgrade_result> upgrades{};
+    std::vector<std::pair<double, double>> predicted_and_simulated{};
+    std::vector<std::pair<double, double>> pruned_predicted_and_simulated{};
+    int n_pruned_better{};
 };
 
-Item_upgrade compute_item_upgrade(const Combat_simulator_config& config, const Character& character,
-                                  const Distribution& base_dps, const std::string& item_name)
+constexpr size_t n_pruned_checked = 2;
+
+// a few of the candidates that pruning removed, spread over the list
+template <typename Item>
+std::vector<Item> pruned_sample(const std::vector<Item>& all, const std::vector<Item>& kept,
+                                const std::function<bool(const Item&)>& filter)
 {
-    static const double q999 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.999), 0.01);
+    std::vector<Item> pruned{};
+    for (const auto& item : all)
+    {
+        if (filter(item)) continue;
+        if (std::any_of(kept.begin(), kept.end(), [&item](const Item& k) { return k.name == item.name; })) continue;
+        pruned.push_back(item);
+    }
+    std::vector<Item> sample{};
+    const auto n = std::min(n_pruned_checked, pruned.size());
+    for (size_t i = 0; i < n; i++)
+    {
+        sample.push_back(pruned[i * pruned.size() / n]);
+    }
+    return sample;
+}
 
-    Combat_simulator sim(config);
-
-    auto mean_diff = 0.0;
-    auto std_diff = 0.0;
-    sim.simulate(character, [base_dps, &mean_diff, &std_diff](const Distribution& d) {
-        if (d.samples() <= 500) return false;
-        mean_diff = d.mean() - base_dps.mean();
-        std_diff = std::sqrt(d.var_of_the_mean() + base_dps.var_of_the_mean());
-        if (d.samples() > 500 && mean_diff < 0 && mean_diff <= -std_diff * q999) return true;
-        if (d.samples() > 5000 && mean_diff >= 0 && mean_diff >= std_diff * q999) return true;
-        if (d.samples() >= 20000) return true;
-        return false;
-    });
-    return {item_name, mean_diff, std_diff};
+void count_pruned_better(Socket_upgrades& socket_upgrades, const std::vector<Estimate>& kept)
+{
+    if (kept.empty()) return;
+    const auto weakest = std::min_element(kept.begin(), kept.end(), [](const auto& a, const auto& b) {
+        return a.mean < b.mean;
+    })->mean;
+    for (const auto& [predicted, simulated] : socket_upgrades.pruned_predicted_and_simulated)
+    {
+        if (simulated > weakest) socket_upgrades.n_pruned_better++;
+    }
 }
 
-void item_upgrades(std::string& item_strengths_string, const Combat_simulator_config& config, Character character_new,
-                   Armory& armory, const Distribution& base_dps, Socket socket, bool first_item)
+void item_upgrades(Socket_upgrades& socket_upgrades, const Combat_simulator_config& config, Character character_new,
+                   const Armory& armory, const Distribution& base_dps, Socket socket, bool first_item,
+                   Checkpoint& checkpoint, const Surrogate_model* surrogate)
 {
-    std::string dummy;
     const auto& armor_vec = armory.get_items_in_socket(socket);
 
     auto current_armor = character_new.get_item_from_socket(socket, first_item);
@@ -111,37 +146,56 @@ void item_upgrades(std::string& item_strengths_string, const Combat_simulator_co
         return a.name == current_armor.name || a.name == other_armor.name;
     };
 
-    auto items = Item_optimizer::remove_weaker_items(armor_vec, character_new.total_special_stats, dummy, 4, filter);
+    auto items = Item_optimizer::remove_weaker_items(armor_vec, character_new.total_special_stats, nullptr, 4, filter,
+                                                     surrogate);
 
-    std::vector<Item_upgrade> ius{};
+    auto only_stats = [](const Armor& a) {
+        return a.set_name == Set::none && a.hit_effects.empty() && a.use_effects.empty();
+    };
+    const auto current_stats = character_new.total_special_stats;
+    const auto key_prefix = "item/" + friendly_name(socket) + (first_item ? "/1/" : "/2/");
+    std::vector<Estimate> ius{};
     ius.reserve(items.size());
     for (const auto& item : items)
     {
         Armory::change_armor(character_new.armor, item, first_item);
         armory.compute_total_stats(character_new);
-        ius.emplace_back(compute_item_upgrade(config, character_new, base_dps, item.name));
+        ius.emplace_back(compute_item_upgrade(config, character_new, base_dps, item.name, checkpoint, key_prefix + item.name));
+        if (surrogate && only_stats(item) && only_stats(current_armor))
+        {
+            socket_upgrades.predicted_and_simulated.emplace_back(
+                surrogate->dps_diff(current_stats, character_new.total_special_stats), ius.back().mean);
+        }
     }
-    std::sort(ius.begin(), ius.end(), [](const auto& a, const auto& b) { return a.mean_diff > b.mean_diff; });
 
-    item_strengths_string += "Current " + friendly_name(socket) + ": <b>" + current_armor.name + "</b>";
-    if (ius.front().mean_diff < 0)
+    // pruned items never have procs or set bonuses, the surrogate judged all of them
+    if (surrogate && only_stats(current_armor))
     {
-        item_strengths_string += " is <b>BiS</b> in current configuration!";
+        for (const auto& item : pruned_sample<Armor>(armor_vec, items, filter))
+        {
+            Armory::change_armor(character_new.armor, item, first_item);
+            armory.compute_total_stats(character_new);
+            const auto iu = compute_item_upgrade(config, character_new, base_dps, item.name, checkpoint,
+                                                 key_prefix + "pruned/" + item.name);
+            socket_upgrades.pruned_predicted_and_simulated.emplace_back(
+                surrogate->dps_diff(current_stats, character_new.total_special_stats), iu.mean);
+        }
+        count_pruned_better(socket_upgrades, ius);
     }
+    std::sort(ius.begin(), ius.end(), [](const auto& a, const auto& b) { return a.mean > b.mean; });
+
     for (const auto& iu : ius)
     {
-        item_strengths_string += iu.to_string();
+        socket_upgrades.upgrades.push_back({socket, first_item, current_armor.name, iu.name, iu.mean, iu.error});
     }
-    item_strengths_string += "<br><br>";
 }
 
-void wep_upgrades(std::string& item_strengths_string, const Combat_simulator_config& config,
-                       Character character_new, Armory& armory, const Distribution& base_dps,
-                       Weapon_socket weapon_socket)
+void wep_upgrades(Socket_upgrades& socket_upgrades, const Combat_simulator_config& config,
+                       Character character_new, const Armory& armory, const Distribution& base_dps,
+                       Weapon_socket weapon_socket, Checkpoint& checkpoint, const Surrogate_model* surrogate)
 {
     auto socket = (weapon_socket == Weapon_socket::main_hand || weapon_socket == Weapon_socket::two_hand) ? Socket::main_hand : Socket::off_hand;
 
-    std::string dummy;
     const auto& wep_vec = armory.get_weapon_in_socket(weapon_socket);
 
     // Restrict Kael'thas Legendary weapons not to be suggested, or competing for "stronger items"
@@ -150,28 +204,56 @@ void wep_upgrades(std::string& item_strengths_string, const Combat_simulator_con
         return w.name == current_weapon.name || w.name == "devastation" || w.name == "warp_slicer" || w.name == "infinity_blade";
     };
 
-    auto items = Item_optimizer::remove_weaker_weapons(weapon_socket, wep_vec, character_new.total_special_stats, dummy, 10, filter);
+    auto items = Item_optimizer::remove_weaker_weapons(weapon_socket, wep_vec, character_new.total_special_stats, nullptr, 10,
+                                                       filter, surrogate);
 
-    std::vector<Item_upgrade> ius{};
+    // the surrogate covers the stats, the weapon damage goes by the estimate the candidates were pruned with. the
+    //  equipped weapon carries the enchant's effects, the armory's copy is the one to compare
+    auto only_stats = [](const Weapon& w) {
+        return w.set_name == Set::none && w.hit_effects.empty() && w.use_effects.empty();
+    };
+    const auto plain_weapon = std::find_if(wep_vec.begin(), wep_vec.end(), [&current_weapon](const Weapon& w) {
+        return w.name == current_weapon.name;
+    });
+    const bool predictable = surrogate && plain_weapon != wep_vec.end() && only_stats(*plain_weapon);
+    const auto current_stats = character_new.total_special_stats;
+    auto predicted_dps_diff = [&](const Weapon& weapon) {
+        return surrogate->weights()[0] *
+               (Item_optimizer::estimated_weapon_ap(weapon_socket, weapon, current_stats, surrogate) -
+                Item_optimizer::estimated_weapon_ap(weapon_socket, *plain_weapon, current_stats, surrogate));
+    };
+    const auto key_prefix = "weapon/" + std::to_string(static_cast<int>(weapon_socket)) + "/";
+    std::vector<Estimate> ius{};
     ius.reserve(items.size());
     for (const auto& item : items)
     {
         Armory::change_weapon(character_new.weapons, item, socket);
         armory.compute_total_stats(character_new);
-        ius.emplace_back(compute_item_upgrade(config, character_new, base_dps, item.name));
+        ius.emplace_back(compute_item_upgrade(config, character_new, base_dps, item.name, checkpoint, key_prefix + item.name));
+        if (predictable && only_stats(item))
+        {
+            socket_upgrades.predicted_and_simulated.emplace_back(predicted_dps_diff(item), ius.back().mean);
+        }
     }
-    std::sort(ius.begin(), ius.end(), [](const auto& a, const auto& b) { return a.mean_diff > b.mean_diff; });
 
-    item_strengths_string += "Current " + friendly_name(socket) + ": " + "<b>" + current_weapon.name + "</b>";
-    if (ius.front().mean_diff < 0)
+    if (predictable)
     {
-        item_strengths_string += " is <b>BiS</b> in current configuration!";
+        for (const auto& item : pruned_sample<Weapon>(wep_vec, items, filter))
+        {
+            Armory::change_weapon(character_new.weapons, item, socket);
+            armory.compute_total_stats(character_new);
+            const auto iu = compute_item_upgrade(config, character_new, base_dps, item.name, checkpoint,
+                                                 key_prefix + "pruned/" + item.name);
+            socket_upgrades.pruned_predicted_and_simulated.emplace_back(predicted_dps_diff(item), iu.mean);
+        }
+        count_pruned_better(socket_upgrades, ius);
     }
+    std::sort(ius.begin(), ius.end(), [](const auto& a, const auto& b) { return a.mean > b.mean; });
+
     for (const auto& iu : ius)
     {
-        item_strengths_string += iu.to_string();
+        socket_upgrades.upgrades.push_back({socket, true, current_weapon.name, iu.name, iu.mean, iu.error});
     }
-    item_strengths_string += "<br><br>";
 }
 
 struct Stat_weight
@@ -183,9 +265,9 @@ struct Stat_weight
 
 Stat_weight compute_stat_weight(const Combat_simulator_config& config, Character& char_plus,
                                 double permute_amount, double permute_factor,
-                                const Distribution& base_dps)
+                                const Distribution& base_dps, Checkpoint& checkpoint, const std::string& key)
 {
-    auto new_dps = Combat_simulator::simulate(config, char_plus);
+    auto new_dps = checkpoint.get_or_compute(key, [&config, &char_plus]() { return Combat_simulator::simulate(config, char_plus); });
 
     auto mean_diff = (new_dps.mean() - base_dps.mean()) / permute_factor;
     auto std_of_the_mean_diff = std::sqrt(new_dps.var_of_the_mean() + base_dps.var_of_the_mean()) / permute_factor;
@@ -197,31 +279,12 @@ std::vector<double> get_damage_sources(const Damage_sources& damage_sources_vect
 {
     const auto total_damage = damage_sources_vector.sum_damage_sources();
 
-    return {
-        damage_sources_vector.white_mh_damage / total_damage,
-        damage_sources_vector.white_oh_damage / total_damage,
-        damage_sources_vector.bloodthirst_damage / total_damage,
-        damage_sources_vector.execute_damage / total_damage,
-        damage_sources_vector.heroic_strike_damage / total_damage,
-        damage_sources_vector.cleave_damage / total_damage,
-        damage_sources_vector.whirlwind_damage / total_damage,
-        damage_sources_vector.hamstring_damage / total_damage,
-        damage_sources_vector.deep_wounds_damage / total_damage,
-        damage_sources_vector.item_hit_effects_damage / total_damage,
-        damage_sources_vector.overpower_damage / total_damage,
-        damage_sources_vector.slam_damage / total_damage,
-        damage_sources_vector.mortal_strike_damage / total_damage,
-        damage_sources_vector.sweeping_strikes_damage / total_damage,
-    };
-}
-
-std::string print_stat(const std::string& stat_name, double amount, double bonus_amount = -1)
-{
-    std::ostringstream stream;
-    stream << stat_name << std::setprecision(4) << "<b>" << amount;
-    if (bonus_amount > 0) stream << " + " << std::setprecision(4) << bonus_amount;
-    stream << "</b><br>";
-    return stream.str();
+    std::vector<double> fractions(n_damage_sources);
+    for (size_t i = 0; i < n_damage_sources; i++)
+    {
+        fractions[i] = damage_sources_vector.damage[i] / total_damage;
+    }
+    return fractions;
 }
 
 std::string print_cmp_stat(const std::string& stat_name, double amount1, double amount2)
@@ -288,535 +351,533 @@ std::string get_character_stat(const Character& char1, const Character& char2)
     return out_string;
 }
 
-std::string get_character_stat(const Character& character)
+std::vector<double> get_character_stats(const Character& character)
 {
-    std::string out_string = "<b>Character stats:</b> <br />";
-    out_string += print_stat("Strength: ", character.total_attributes.strength);
-    out_string += print_stat("Agility: ", character.total_attributes.agility);
-    out_string += print_stat("Hit: ", character.total_special_stats.hit);
-    out_string += print_stat("Expertise (before rounding down): ", character.total_special_stats.expertise);
-    out_string += print_stat("Crit (spellbook): ", character.total_special_stats.critical_strike);
-    out_string += print_stat("Attack Power: ", character.total_special_stats.attack_power, character.total_special_stats.bonus_attack_power);
-    out_string += print_stat("Haste factor: ", 1 + character.total_special_stats.haste);
+    const auto& ss = character.total_special_stats;
+    std::vector<double> stats(static_cast<size_t>(Character_stat::size), -1.0);
+    auto set_stat = [&stats](Character_stat stat, double value) { stats[static_cast<size_t>(stat)] = value; };
+    set_stat(Character_stat::strength, character.total_attributes.strength);
+    set_stat(Character_stat::agility, character.total_attributes.agility);
+    set_stat(Character_stat::hit, ss.hit);
+    set_stat(Character_stat::expertise, ss.expertise);
+    set_stat(Character_stat::crit, ss.critical_strike);
+    set_stat(Character_stat::attack_power, ss.attack_power);
+    set_stat(Character_stat::bonus_attack_power, ss.bonus_attack_power);
+    set_stat(Character_stat::haste_factor, 1 + ss.haste);
+    if (character.has_weapon_of_type(Weapon_type::sword))
+    {
+        set_stat(Character_stat::sword_expertise, ss.sword_expertise);
+    }
+    if (character.has_weapon_of_type(Weapon_type::axe))
+    {
+        set_stat(Character_stat::axe_expertise, ss.axe_expertise);
+    }
+    if (character.has_weapon_of_type(Weapon_type::mace))
+    {
+        set_stat(Character_stat::mace_expertise, ss.mace_expertise);
+    }
     if (character.is_dual_wield())
     {
-        if (character.has_weapon_of_type(Weapon_type::sword))
-        {
-            out_string += print_stat("Sword bonus expertise: ", character.total_special_stats.sword_expertise);
-        }
-        if (character.has_weapon_of_type(Weapon_type::axe))
-        {
-            out_string += print_stat("Axe bonus expertise: ", character.total_special_stats.axe_expertise);
-        }
+        // no talents for those, shown so that the list covers both hands
         if (character.has_weapon_of_type(Weapon_type::dagger))
         {
-            out_string += print_stat("Dagger bonus expertise: ", 0);
-        }
-        if (character.has_weapon_of_type(Weapon_type::mace))
-        {
-            out_string += print_stat("Mace bonus expertise: ", character.total_special_stats.mace_expertise);
+            set_stat(Character_stat::dagger_expertise, 0);
         }
         if (character.has_weapon_of_type(Weapon_type::unarmed))
         {
-            out_string += print_stat("Unarmed bonus expertise: ", 0);
-        }
-    }
-    else
-    {
-        if (character.has_weapon_of_type(Weapon_type::sword))
-        {
-            out_string += print_stat("Two Hand Sword expertise: ", character.total_special_stats.sword_expertise);
-        }
-        if (character.has_weapon_of_type(Weapon_type::axe))
-        {
-            out_string += print_stat("Two Hand Axe expertise: ", character.total_special_stats.axe_expertise);
-        }
-        if (character.has_weapon_of_type(Weapon_type::mace))
-        {
-            out_string += print_stat("Two Hand Mace expertise: ", character.total_special_stats.mace_expertise);
+            set_stat(Character_stat::unarmed_expertise, 0);
         }
     }
-
-    out_string += "<br>";
-
-    out_string += "Set bonuses:<br>";
-    for (const auto& bonus : character.set_bonuses)
-    {
-        out_string += "<b>" + bonus.name + "</b><br>";
-    }
-
-    return out_string;
+    return stats;
 }
 
-std::string compute_talent_weight(const Combat_simulator_config& config, const Character& character,
-                                  const Distribution& init_dps, const std::string& talent_name,
-                                  int Character::talents_t::*talent, int n_points)
+Estimate compute_talent_weight(const Combat_simulator_config& config, const Character& character,
+                               const Distribution& init_dps, const std::string& talent_name,
+                               int Character::talents_t::*talent, int n_points, Checkpoint& checkpoint)
 {
     Armory armory;
 
+    auto with_points = [&](int points) {
+        return checkpoint.get_or_compute("talent/" + talent_name + "/" + std::to_string(points), [&]() {
+            auto copy = character;
+            copy.talents.*talent = points;
+            armory.compute_total_stats(copy);
+            return Combat_simulator::simulate(config, copy);
+        });
+    };
+
     auto without = init_dps;
     if (character.talents.*talent > 0)
     {
-        auto copy = character;
-        copy.talents.*talent = 0;
-        armory.compute_total_stats(copy);
-        without = Combat_simulator::simulate(config, copy);
+        without = with_points(0);
     }
 
     auto with = init_dps;
     if (character.talents.*talent < n_points)
     {
-        auto copy = character;
-        copy.talents.*talent = n_points;
-        armory.compute_total_stats(copy);
-        with = Combat_simulator::simulate(config, copy);
+        with = with_points(n_points);
     }
 
     auto mean_diff = (with.mean() - without.mean()) / n_points;
     auto std_of_the_mean_diff = std::sqrt(with.var_of_the_mean() + without.var_of_the_mean()) / n_points;
 
-    return "<br>Talent: <b>" + talent_name + "</b><br>Value: <b>" +
-           String_helpers::string_with_precision(mean_diff, 4) + " &plusmn " +
-           String_helpers::string_with_precision(q95 * std_of_the_mean_diff, 3) + " DPS</b><br>";
+    return {talent_name, mean_diff, q95 * std_of_the_mean_diff};
 }
 
-std::string compute_talent_weights(const Combat_simulator_config& config, const Character& character, const Distribution& base_dps)
+std::vector<Estimate> compute_talent_weights(const Combat_simulator_config& config, const Character& character, const Distribution& base_dps,
+                                   Checkpoint& checkpoint)
 {
-    std::string talents_info = "<br><b>Value per 1 talent point:</b>";
+    std::vector<Estimate> talent_weights{};
 
     if (config.combat.use_heroic_strike)
     {
         if (config.number_of_extra_targets > 0 && config.combat.cleave_if_adds)
         {
-            talents_info += compute_talent_weight(config, character, base_dps, "Improved Cleave",
-                                                  &Character::talents_t::improved_cleave, 3);
+            talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Cleave",
+                                                           &Character::talents_t::improved_cleave, 3, checkpoint));
         }
         else
         {
-            talents_info += compute_talent_weight(config, character, base_dps, "Improved Heroic Strike",
-                                                  &Character::talents_t::improved_heroic_strike, 3);
+            talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Heroic Strike",
+                                                           &Character::talents_t::improved_heroic_strike, 3, checkpoint));
         }
     }
 
     if (config.combat.use_whirlwind)
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Improved Whirlwind",
-                                              &Character::talents_t::improved_whirlwind, 2);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Whirlwind",
+                                                       &Character::talents_t::improved_whirlwind, 2, checkpoint));
     }
 
     if (config.combat.use_mortal_strike)
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Improved Mortal Strike",
-                                              &Character::talents_t::improved_mortal_strike, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Mortal Strike",
+                                                       &Character::talents_t::improved_mortal_strike, 5, checkpoint));
     }
 
     if (config.combat.use_slam)
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Improved Slam",
-                                              &Character::talents_t::improved_slam, 2);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Slam",
+                                                       &Character::talents_t::improved_slam, 2, checkpoint));
     }
 
     if (config.combat.use_overpower)
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Improved Overpower",
-                                              &Character::talents_t::improved_overpower, 2);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Overpower",
+                                                       &Character::talents_t::improved_overpower, 2, checkpoint));
     }
 
     if (config.execute_phase_percentage_ > 0)
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Improved Execute",
-                                              &Character::talents_t::improved_execute, 2);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Execute",
+                                                       &Character::talents_t::improved_execute, 2, checkpoint));
     }
 
     if (character.is_dual_wield())
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Dual Wield Specialization",
-                                              &Character::talents_t::dual_wield_specialization, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Dual Wield Specialization",
+                                                       &Character::talents_t::dual_wield_specialization, 5, checkpoint));
     }
 
     if (character.is_dual_wield())
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "One-Handed Weapon Specialization",
-                                              &Character::talents_t::one_handed_weapon_specialization, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "One-Handed Weapon Specialization",
+                                                       &Character::talents_t::one_handed_weapon_specialization, 5, checkpoint));
     }
 
     if (!character.is_dual_wield())
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Two-Handed Weapon Specialization",
-                                              &Character::talents_t::two_handed_weapon_specialization, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Two-Handed Weapon Specialization",
+                                                       &Character::talents_t::two_handed_weapon_specialization, 5, checkpoint));
     }
 
     if (config.use_death_wish)
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Death Wish",
-                                              &Character::talents_t::death_wish, 1);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Death Wish",
+                                                       &Character::talents_t::death_wish, 1, checkpoint));
     }
 
     if (character.has_weapon_of_type(Weapon_type::sword))
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Sword Specialization",
-                                              &Character::talents_t::sword_specialization, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Sword Specialization",
+                                                       &Character::talents_t::sword_specialization, 5, checkpoint));
     }
 
     if (character.has_weapon_of_type(Weapon_type::mace))
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Mace Specialization",
-                                              &Character::talents_t::mace_specialization, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Mace Specialization",
+                                                       &Character::talents_t::mace_specialization, 5, checkpoint));
     }
 
     if (character.has_weapon_of_type(Weapon_type::axe))
     {
-        talents_info += compute_talent_weight(config, character, base_dps, "Poleaxe Specialization",
-                                              &Character::talents_t::poleaxe_specialization, 5);
+        talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Poleaxe Specialization",
+                                                       &Character::talents_t::poleaxe_specialization, 5, checkpoint));
     }
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Flurry",
-                                          &Character::talents_t::flurry, 5);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Flurry",
+                                                   &Character::talents_t::flurry, 5, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Cruelty",
-                                          &Character::talents_t::cruelty, 5);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Cruelty",
+                                                   &Character::talents_t::cruelty, 5, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Impale",
-                                          &Character::talents_t::impale, 2);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Impale",
+                                                   &Character::talents_t::impale, 2, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Rampage",
-                                          &Character::talents_t::rampage, 1);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Rampage",
+                                                   &Character::talents_t::rampage, 1, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Weapon Mastery",
-                                          &Character::talents_t::weapon_mastery, 2);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Weapon Mastery",
+                                                   &Character::talents_t::weapon_mastery, 2, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Precision",
-                                          &Character::talents_t::precision, 3);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Precision",
+                                                   &Character::talents_t::precision, 3, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Improved Berserker Stance",
-                                          &Character::talents_t::improved_berserker_stance, 5);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Improved Berserker Stance",
+                                                   &Character::talents_t::improved_berserker_stance, 5, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Unbridled Wrath",
-                                          &Character::talents_t::unbridled_wrath, 5);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Unbridled Wrath",
+                                                   &Character::talents_t::unbridled_wrath, 5, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Anger Management",
-                                          &Character::talents_t::anger_management, 1);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Anger Management",
+                                                   &Character::talents_t::anger_management, 1, checkpoint));
 
-    talents_info += compute_talent_weight(config, character, base_dps, "Endless Rage",
-                                          &Character::talents_t::endless_rage, 1);
+    talent_weights.push_back(compute_talent_weight(config, character, base_dps, "Endless Rage",
+                                                   &Character::talents_t::endless_rage, 1, checkpoint));
 
-    return talents_info;
+    return talent_weights;
 }
 
 void compute_dpr(const Character& character, const Combat_simulator& simulator,
-                 const Distribution& base_dps, const Damage_sources& dmg_dist, std::string& dpr_info)
+                 const Distribution& base_dps, const Damage_sources& dmg_dist, std::vector<Dpr_result>& dpr)
 {
+    using Dpr_flag = bool Combat_simulator_config::dpr_t::*;
+
     auto config = simulator.config;
     config.n_batches = 10000;
 
-    dpr_info = "<br><b>Ability damage per rage:</b><br>";
-    dpr_info += "DPR for ability X is computed as following:<br> "
-                "((Normal DPS) - (DPS where ability X costs rage but has no effect)) / (rage cost of ability "
-                "X)<br>";
-    if (config.combat.use_bloodthirst)
+    auto avg_casts = [&](Damage_source source) {
+        return static_cast<double>(dmg_dist.get_count(source)) / base_dps.samples();
+    };
+
+    // collect the abilities first, so that all ablated runs (and an unablated reference run) can go at once.
+    //  they share config.seed, i.e. batch i sees the same random stream in every run, which makes the paired
+    //  differences much less noisy than comparing against the base run
+    std::vector<Dpr_flag> ablations;
+    if (config.combat.use_bloodthirst && avg_casts(Damage_source::bloodthirst) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_bt_);
+    if (config.combat.use_mortal_strike && avg_casts(Damage_source::mortal_strike) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_ms_);
+    if (config.combat.use_whirlwind && avg_casts(Damage_source::whirlwind) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_ww_);
+    if (config.combat.use_slam && avg_casts(Damage_source::slam) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_sl_);
+    if (config.combat.use_heroic_strike && avg_casts(Damage_source::heroic_strike) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_hs_);
+    if (config.combat.cleave_if_adds && avg_casts(Damage_source::cleave) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_cl_);
+    if (config.combat.use_hamstring && avg_casts(Damage_source::hamstring) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_ha_);
+    if (config.combat.use_overpower && avg_casts(Damage_source::overpower) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_op_);
+    if (avg_casts(Damage_source::execute) >= 1.0) ablations.push_back(&Combat_simulator_config::dpr_t::compute_dpr_ex_);
+
+    std::vector<Distribution> dps(ablations.size() + 1); // dps[0] is the reference
+    Parallel::for_each_index(static_cast<int>(dps.size()), [&](int i) {
+        auto job_config = config;
+        if (i > 0) job_config.dpr_settings.*ablations[i - 1] = true;
+        dps[i] = Combat_simulator::simulate(job_config, character);
+    }, Parallel::thread_count(config.n_threads));
+
+    // total damage lost per fight when the ability does nothing, empty if it wasn't simulated
+    auto damage_lost = [&](Dpr_flag flag) -> std::optional<double> {
+        auto it = std::find(ablations.begin(), ablations.end(), flag);
+        if (it == ablations.end()) return {};
+        return (dps[0].mean() - dps[1 + (it - ablations.begin())].mean()) * config.sim_time;
+    };
+
+    const double avg_mh_dmg = dmg_dist.get_damage(Damage_source::white_mh) / dmg_dist.get_count(Damage_source::white_mh);
+    const double avg_mh_rage_lost = avg_mh_dmg * 3.75 / 274.7 + (3.5 * character.weapons[0].swing_speed / 2);
+
+    auto dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_bt_);
+    if (dmg_tot)
     {
-        double avg_bt_casts = static_cast<double>(dmg_dist.bloodthirst_count) / base_dps.samples();
-        if (avg_bt_casts >= 1.0)
-        {
-            double bloodthirst_rage = 30 - 5 * character.has_set_bonus(Set::destroyer, 4);
-            config.dpr_settings.compute_dpr_bt_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_hit = dmg_tot / avg_bt_casts;
-            double dmg_per_rage = dmg_per_hit / bloodthirst_rage;
-            dpr_info += "<b>Bloodthirst</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hit, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision(bloodthirst_rage, 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_bt_ = false;
-        }
+        double bloodthirst_rage = 30 - 5 * character.has_set_bonus(Set::destroyer, 4);
+        dpr.push_back({"Bloodthirst", *dmg_tot / avg_casts(Damage_source::bloodthirst), bloodthirst_rage});
     }
-    if (config.combat.use_mortal_strike)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_ms_);
+    if (dmg_tot)
     {
-        double avg_ms_casts = static_cast<double>(dmg_dist.mortal_strike_count) / base_dps.samples();
-        if (avg_ms_casts >= 1.0)
-        {
-            double mortal_strike_rage = 30 - 5 * character.has_set_bonus(Set::destroyer, 4);
-            config.dpr_settings.compute_dpr_ms_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_hit = dmg_tot / avg_ms_casts;
-            double dmg_per_rage = dmg_per_hit / mortal_strike_rage;
-            dpr_info += "<b>Mortal Strike</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hit, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision(mortal_strike_rage, 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_ms_ = false;
-        }
+        double mortal_strike_rage = 30 - 5 * character.has_set_bonus(Set::destroyer, 4);
+        dpr.push_back({"Mortal Strike", *dmg_tot / avg_casts(Damage_source::mortal_strike), mortal_strike_rage});
     }
-    if (config.combat.use_whirlwind)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_ww_);
+    if (dmg_tot)
     {
-        double avg_ww_casts = static_cast<double>(dmg_dist.whirlwind_count) / base_dps.samples();
-        if (avg_ww_casts >= 1.0)
-        {
-            double whirlwind_rage = 25 - 5 * character.has_set_bonus(Set::warbringer, 2);
-            config.dpr_settings.compute_dpr_ww_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_hit = dmg_tot / avg_ww_casts;
-            double dmg_per_rage = dmg_per_hit / whirlwind_rage;
-            dpr_info += "<b>Whirlwind</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hit, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision(whirlwind_rage, 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_ww_ = false;
-        }
+        double whirlwind_rage = 25 - 5 * character.has_set_bonus(Set::warbringer, 2);
+        dpr.push_back({"Whirlwind", *dmg_tot / avg_casts(Damage_source::whirlwind), whirlwind_rage});
     }
-    if (config.combat.use_slam)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_sl_);
+    if (dmg_tot)
     {
-        double avg_sl_casts = static_cast<double>(dmg_dist.slam_count) / base_dps.samples();
-        if (avg_sl_casts >= 1.0)
-        {
-            config.dpr_settings.compute_dpr_sl_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double avg_mh_dmg =
-                static_cast<double>(dmg_dist.white_mh_damage) / static_cast<double>(dmg_dist.white_mh_count);
-            double avg_mh_rage_lost = avg_mh_dmg * 3.75 / 274.7 + (3.5 * character.weapons[0].swing_speed / 2);
-            double sl_cast_time = 1.5 - 0.5 * character.talents.improved_slam + 0.001 * config.combat.slam_latency;
-            double dmg_per_hit = dmg_tot / avg_sl_casts;
-            double dmg_per_rage = dmg_per_hit / (15.0 + avg_mh_rage_lost * sl_cast_time / character.weapons[0].swing_speed);
-            dpr_info += "<b>Slam</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hit, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision(15.0 + avg_mh_rage_lost * sl_cast_time / character.weapons[0].swing_speed, 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_sl_ = false;
-        }
+        double sl_cast_time = 1.5 - 0.5 * character.talents.improved_slam + 0.001 * config.combat.slam_latency;
+        double slam_rage = 15.0 + avg_mh_rage_lost * sl_cast_time / character.weapons[0].swing_speed;
+        dpr.push_back({"Slam", *dmg_tot / avg_casts(Damage_source::slam), slam_rage});
     }
-    if (config.combat.use_heroic_strike)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_hs_);
+    if (dmg_tot)
     {
-        double avg_hs_casts = static_cast<double>(dmg_dist.heroic_strike_count) / base_dps.samples();
-        if (avg_hs_casts >= 1.0)
-        {
-            double heroic_strike_rage = 15 - character.talents.improved_heroic_strike;
-            config.dpr_settings.compute_dpr_hs_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_hs = dmg_tot / avg_hs_casts;
-            double avg_mh_dmg =
-                static_cast<double>(dmg_dist.white_mh_damage) / static_cast<double>(dmg_dist.white_mh_count);
-            double avg_mh_rage_lost = avg_mh_dmg * 3.75 / 274.7 + (3.5 * character.weapons[0].swing_speed / 2);
-            double dmg_per_rage = dmg_per_hs / (heroic_strike_rage + avg_mh_rage_lost);
-            dpr_info += "<b>Heroic Strike</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hs, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision((heroic_strike_rage + avg_mh_rage_lost), 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_hs_ = false;
-        }
+        double heroic_strike_rage = 15 - character.talents.improved_heroic_strike;
+        dpr.push_back({"Heroic Strike", *dmg_tot / avg_casts(Damage_source::heroic_strike), heroic_strike_rage + avg_mh_rage_lost});
     }
-    if (config.combat.cleave_if_adds)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_cl_);
+    if (dmg_tot)
     {
-        double avg_cl_casts = static_cast<double>(dmg_dist.cleave_count) / base_dps.samples();
-        if (avg_cl_casts >= 1.0)
-        {
-            config.dpr_settings.compute_dpr_cl_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_hs = dmg_tot / avg_cl_casts;
-            double avg_mh_dmg =
-                static_cast<double>(dmg_dist.white_mh_damage) / static_cast<double>(dmg_dist.white_mh_count);
-            double avg_mh_rage_lost = avg_mh_dmg * 3.75 / 274.7 + (3.5 * character.weapons[0].swing_speed / 2);
-            double dmg_per_rage = dmg_per_hs / (20 + avg_mh_rage_lost);
-            dpr_info += "<b>Cleave</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hs, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision((20 + avg_mh_rage_lost), 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_cl_ = false;
-        }
+        dpr.push_back({"Cleave", *dmg_tot / avg_casts(Damage_source::cleave), 20 + avg_mh_rage_lost});
     }
-    if (config.combat.use_hamstring)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_ha_);
+    if (dmg_tot)
     {
-        double avg_ha_casts = static_cast<double>(dmg_dist.hamstring_count) / base_dps.samples();
-        if (avg_ha_casts >= 1.0)
-        {
-            config.dpr_settings.compute_dpr_ha_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_ha = dmg_tot / avg_ha_casts;
-            double dmg_per_rage = dmg_per_ha / 10;
-            dpr_info += "<b>Hamstring</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_ha, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision(10, 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_ha_ = false;
-        }
+        dpr.push_back({"Hamstring", *dmg_tot / avg_casts(Damage_source::hamstring), 10});
     }
-    if (config.combat.use_overpower)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_op_);
+    if (dmg_tot)
     {
-        double avg_op_casts = static_cast<double>(dmg_dist.overpower_count) / base_dps.samples();
-        if (avg_op_casts >= 1.0)
-        {
-            config.dpr_settings.compute_dpr_op_ = true;
-            auto dpr_dps = Combat_simulator::simulate(config, character);
-            double delta_dps = base_dps.mean() - dpr_dps.mean();
-            double dmg_tot = delta_dps * config.sim_time;
-            double dmg_per_hit = dmg_tot / avg_op_casts;
-            double overpower_cost =
-                simulator.get_rage_lost_stance() / double(base_dps.samples()) / avg_op_casts + 5.0;
-            double dmg_per_rage = dmg_per_hit / overpower_cost;
-            dpr_info += "<b>Overpower</b>: <br>Damage per cast: <b>" +
-                        String_helpers::string_with_precision(dmg_per_hit, 4) + "</b><br>Average rage cost: <b>" +
-                        String_helpers::string_with_precision(overpower_cost, 3) + "</b><br>DPR: <b>" +
-                        String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-            config.dpr_settings.compute_dpr_op_ = false;
-        }
+        double avg_op_casts = avg_casts(Damage_source::overpower);
+        double overpower_cost = simulator.get_rage_lost_stance() / double(base_dps.samples()) / avg_op_casts + 5.0;
+        dpr.push_back({"Overpower", *dmg_tot / avg_op_casts, overpower_cost});
     }
-
-    double avg_ex_casts = static_cast<double>(dmg_dist.execute_count) / base_dps.samples();
-    if (avg_ex_casts >= 1.0)
+    dmg_tot = damage_lost(&Combat_simulator_config::dpr_t::compute_dpr_ex_);
+    if (dmg_tot)
     {
-        config.dpr_settings.compute_dpr_ex_ = true;
-        auto dpr_dps = Combat_simulator::simulate(config, character);
-        double delta_dps = base_dps.mean() - dpr_dps.mean();
-        double dmg_tot = delta_dps * config.sim_time;
-        double dmg_per_hit = dmg_tot / avg_ex_casts;
+        double avg_ex_casts = avg_casts(Damage_source::execute);
         double execute_rage_cost = std::vector<int>{15, 13, 10}[character.talents.improved_execute];
         double execute_cost = simulator.get_avg_rage_spent_executing() / avg_ex_casts + execute_rage_cost;
-        double dmg_per_rage = dmg_per_hit / execute_cost;
-        dpr_info += "<b>Execute</b>: <br>Damage per cast: <b>" +
-                    String_helpers::string_with_precision(dmg_per_hit, 4) + "</b><br>Average rage cost: <b>" +
-                    String_helpers::string_with_precision(execute_cost, 3) + "</b><br>DPR: <b>" +
-                    String_helpers::string_with_precision(dmg_per_rage, 4) + "</b><br>";
-        config.dpr_settings.compute_dpr_ex_ = false;
+        dpr.push_back({"Execute", *dmg_tot / avg_ex_casts, execute_cost});
     }
 }
 
-std::vector<std::string> compute_stat_weights(const Combat_simulator_config& config, const Character& character, const Distribution& base_dps, const std::vector<std::string>& stat_weights)
+// how much of each stat gets added to find its weight, and by what the dps difference is divided to get the weight
+// per 10 points of the stat. returns false for unsupported stats
+bool stat_weight_permutation(const std::string& stat_weight, const Special_stats& total_special_stats,
+                             Special_stats& delta, double& permute_factor)
 {
     const auto rating_factor = 52.0 / 82;
 
-    std::vector<std::string> sw_strings{};
-    sw_strings.reserve(stat_weights.size());
+    delta = {};
+    if (stat_weight == "strength")
+    {
+        delta = Attributes{50, 0}.to_special_stats(total_special_stats);
+        permute_factor = 5;
+    }
+    else if (stat_weight == "agility")
+    {
+        delta = Attributes{0, 50}.to_special_stats(total_special_stats);
+        permute_factor = 5;
+    }
+    else if (stat_weight == "ap")
+    {
+        delta.attack_power = 100;
+        permute_factor = 10;
+    }
+    else if (stat_weight == "crit")
+    {
+        delta.critical_strike = rating_factor / 14 * 50;
+        permute_factor = 5;
+    }
+    else if (stat_weight == "hit")
+    {
+        delta.hit = rating_factor / 10 * 25;
+        permute_factor = 2.5;
+    }
+    else if (stat_weight == "expertise")
+    {
+        // to prevent truncation, we use 6 expertise here, slightly less than for hit (~23.65 expertise rating)
+        delta.expertise = 6;
+        permute_factor = 6 * 0.25 / rating_factor;
+    }
+    else if (stat_weight == "haste")
+    {
+        delta.haste = rating_factor / 10 * 0.01 * 50;
+        permute_factor = 5;
+    }
+    else if (stat_weight == "arpen")
+    {
+        delta.gear_armor_pen = 350;
+        permute_factor = 35;
+    }
+    else if (stat_weight == "bonus_damage")
+    {
+        delta.bonus_damage = 17;
+        permute_factor = 1.7;
+    }
+    else
+    {
+        return false;
+    }
+    return true;
+}
+
+std::vector<Estimate> compute_stat_weights(const Combat_simulator_config& config, const Character& character, const Distribution& base_dps, const std::vector<std::string>& stat_weights,
+                                              Checkpoint& checkpoint)
+{
+    std::vector<Estimate> weights{};
+    weights.reserve(stat_weights.size());
 
     for (const auto& stat_weight : stat_weights)
     {
-        Character char_plus = character;
-        Stat_weight sw{};
-        if (stat_weight == "strength")
-        {
-            char_plus.total_special_stats += Attributes{50, 0}.to_special_stats(char_plus.total_special_stats);
-            sw = compute_stat_weight(config, char_plus, 10, 5, base_dps);
-        }
-        else if (stat_weight == "agility")
-        {
-            char_plus.total_special_stats += Attributes{0, 50}.to_special_stats(char_plus.total_special_stats);
-            sw = compute_stat_weight(config, char_plus, 10, 5, base_dps);
-        }
-        else if (stat_weight == "ap")
-        {
-            char_plus.total_special_stats += {0, 0, 100};
-            sw = compute_stat_weight(config, char_plus, 10, 10, base_dps);
-        }
-        else if (stat_weight == "crit")
-        {
-            char_plus.total_special_stats.critical_strike += rating_factor / 14 * 50;
-            sw = compute_stat_weight(config, char_plus, 10, 5, base_dps);
-        }
-        else if (stat_weight == "hit")
-        {
-            char_plus.total_special_stats.hit += rating_factor / 10 * 25;
-            sw = compute_stat_weight(config, char_plus, 10, 2.5, base_dps);
-        }
-        else if (stat_weight == "expertise")
+        Special_stats delta{};
+        double permute_factor{};
+        if (!stat_weight_permutation(stat_weight, character.total_special_stats, delta, permute_factor))
         {
-            // to prevent truncation, we use 6 expertise here, slightly less than for hit (~23.65 expertise rating)
-            char_plus.total_special_stats.expertise += 6;
-            sw = compute_stat_weight(config, char_plus, 10, 6 * 0.25 / rating_factor, base_dps);
-        }
-        else if (stat_weight == "haste")
-        {
-            char_plus.total_special_stats.haste += rating_factor / 10 * 0.01 * 50;
-            sw = compute_stat_weight(config, char_plus, 10, 5, base_dps);
+            std::cout << "stat_weight '" << stat_weight << "' is not supported, continuing" << std::endl;
+            continue;
         }
-        else if (stat_weight == "arpen")
+        Character char_plus = character;
+        char_plus.total_special_stats += delta;
+        Stat_weight sw = compute_stat_weight(config, char_plus, 10, permute_factor, base_dps, checkpoint, "stat_weight/" + stat_weight);
+        weights.push_back({stat_weight, sw.mean, sw.std_of_the_mean});
+    }
+    return weights;
+}
+
+// All stat weights from a single set of fights, see simulate_stat_gradient
+std::vector<Estimate> compute_stat_weights_gradient(const Combat_simulator_config& config, const Character& character, const std::vector<std::string>& stat_weights)
+{
+    std::vector<std::string> names{};
+    std::vector<Special_stats> deltas{};
+    std::vector<double> permute_factors{};
+    for (const auto& stat_weight : stat_weights)
+    {
+        Special_stats delta{};
+        double permute_factor{};
+        if (!stat_weight_permutation(stat_weight, character.total_special_stats, delta, permute_factor))
         {
-            char_plus.total_special_stats.gear_armor_pen += 350;
-            sw = compute_stat_weight(config, char_plus, 10, 35, base_dps);
+            std::cout << "stat_weight '" << stat_weight << "' is not supported, continuing" << std::endl;
+            continue;
         }
-        else if (stat_weight == "bonus_damage")
+        names.emplace_back(stat_weight);
+        deltas.emplace_back(delta);
+        permute_factors.emplace_back(permute_factor);
+    }
+    if (names.empty())
+    {
+        return {};
+    }
+
+    const auto gradient = simulate_stat_gradient(config, character, deltas);
+
+    std::vector<Estimate> weights{};
+    weights.reserve(names.size());
+    for (size_t j = 0; j < names.size(); j++)
+    {
+        weights.push_back({names[j], gradient.gains[j] / permute_factors[j], q95 * gradient.standard_errors[j] / permute_factors[j]});
+    }
+    return weights;
+}
+
+static const std::vector<std::string> response_surface_stats{"hit", "crit", "expertise", "haste", "arpen", "ap"};
+
+// Axes are picked up from response_surface_<stat>_min_dd / _max_dd / _levels_dd for the stats the response surface
+// knows. With response_surface_points_dd > 0 the points come from a latin hypercube, otherwise from the full grid.
+// Returns the surface as json and fills info with the fitted terms
+std::vector<Stat_axis> response_surface_axes(Option_index& options)
+{
+    std::vector<Stat_axis> axes{};
+    for (const auto& name : response_surface_stats)
+    {
+        const double min = options.find("response_surface_" + name + "_min_dd", 0.0);
+        const double max = options.find("response_surface_" + name + "_max_dd", 0.0);
+        if (max > min)
         {
-            char_plus.total_special_stats.bonus_damage += 17;
-            sw = compute_stat_weight(config, char_plus, 10, 1.7, base_dps);
+            const int levels = static_cast<int>(options.find("response_surface_" + name + "_levels_dd", 5.0));
+            axes.push_back({name, *stat_axis_field(name), min, max, std::max(levels, 1)});
         }
-        else
+    }
+    return axes;
+}
+
+// n_points > 0: that many points of a latin hypercube design, otherwise the full grid
+std::string compute_response_surface(const Combat_simulator_config& config, const Character& character,
+                                     const std::vector<Stat_axis>& axes, int n_points, std::string& info)
+{
+    if (axes.empty())
+    {
+        std::cout << "response_surface: no stat ranges given, continuing" << std::endl;
+        return {};
+    }
+
+    Response_surface surface{axes};
+    surface.run(config, character, n_points > 0 ? surface.latin_hypercube_design(n_points, config.seed) : surface.grid_design());
+
+    info = "<b>Response surface (" + std::to_string(surface.points().size()) + " points):</b><br>";
+    if (surface.coefficients().empty())
+    {
+        info += "Too few points to fit a quadratic surface.<br><br>";
+    }
+    else
+    {
+        info += "DPS = sum of terms, each stat scaled to -1 at its min and 1 at its max.<br>";
+        const auto names = surface.term_names();
+        for (size_t i = 0; i < names.size(); i++)
         {
-            std::cout << "stat_weight '" << stat_weight << "' is not supported, continuing" << std::endl;
-            continue;
+            info += names[i] + ": <b>" + String_helpers::string_with_precision(surface.coefficients()[i], 4) +
+                    " +- " + String_helpers::string_with_precision(q95 * surface.standard_errors()[i], 3) + "</b><br>";
         }
-        sw_strings.emplace_back(stat_weight + ":" + std::to_string(sw.mean) + ":" + std::to_string(sw.std_of_the_mean));
+        info += "<br>";
     }
-    return sw_strings;
+    return surface.to_json();
 }
 
-std::vector<std::string> parse_buff_options(Armory& armory, const Sim_input& input)
+std::vector<std::string> parse_buff_options(Armory& armory, const Sim_input& input, Option_index& options)
 {
     auto temp_buffs = input.buffs;
 
     // Separate case for options which in reality are buffs. Add them to the buff list
-    if (String_helpers::find_string(input.options, "mighty_rage_potion"))
+    if (options.has("mighty_rage_potion"))
     {
         temp_buffs.emplace_back("mighty_rage_potion");
     }
-    else if (String_helpers::find_string(input.options, "haste_potion"))
+    else if (options.has("haste_potion"))
     {
         temp_buffs.emplace_back("haste_potion");
     }
-    else if (String_helpers::find_string(input.options, "insane_strength_potion"))
+    else if (options.has("insane_strength_potion"))
     {
         temp_buffs.emplace_back("insane_strength_potion");
     }
-    else if (String_helpers::find_string(input.options, "heroic_potion"))
+    else if (options.has("heroic_potion"))
     {
         temp_buffs.emplace_back("heroic_potion");
     }
-    if (String_helpers::find_string(input.options, "drums_of_battle"))
+    if (options.has("drums_of_battle"))
     {
         temp_buffs.emplace_back("drums_of_battle");
     }
-    if (String_helpers::find_string(input.options, "bloodlust"))
+    if (options.has("bloodlust"))
     {
         temp_buffs.emplace_back("bloodlust");
     }
-    if (String_helpers::find_string(input.options, "fungal_bloom"))
+    if (options.has("fungal_bloom"))
     {
         temp_buffs.emplace_back("fungal_bloom");
     }
-    if (String_helpers::find_string(input.options, "expose_weakness"))
+    if (options.has("expose_weakness"))
     {
-        auto expose_weakness_val = String_helpers::find_value(input.float_options_string, input.float_options_val, "expose_weakness_dd");
+        auto expose_weakness_val = options.value("expose_weakness_dd");
         armory.buffs.expose_weakness.special_stats.bonus_attack_power = 0.25 * expose_weakness_val;
         temp_buffs.emplace_back("expose_weakness");
     }
-    if (String_helpers::find_string(input.options, "full_polarity"))
+    if (options.has("full_polarity"))
     {
-        auto full_polarity_val = String_helpers::find_value(input.float_options_string, input.float_options_val, "full_polarity_dd");
+        auto full_polarity_val = options.value("full_polarity_dd");
         armory.buffs.full_polarity.special_stats.damage_mod_physical = full_polarity_val / 100.0;
         armory.buffs.full_polarity.special_stats.damage_mod_spell = full_polarity_val / 100.0;
         temp_buffs.emplace_back("full_polarity");
     }
-    if (String_helpers::find_string(input.options, "ferocious_inspiration"))
+    if (options.has("ferocious_inspiration"))
     {
-        auto ferocious_inspiration_val = String_helpers::find_value(input.float_options_string, input.float_options_val, "ferocious_inspiration_dd");
+        auto ferocious_inspiration_val = options.value("ferocious_inspiration_dd");
         auto damage_mod = std::pow(1.03, std::round(ferocious_inspiration_val / 3)) - 1;
         armory.buffs.ferocious_inspiration.special_stats.damage_mod_physical = damage_mod;
         armory.buffs.ferocious_inspiration.special_stats.damage_mod_spell = damage_mod;
         temp_buffs.emplace_back("ferocious_inspiration");
     }
-    if (String_helpers::find_string(input.options, "battle_squawk"))
+    if (options.has("battle_squawk"))
     {
-        auto battle_squawk_val = String_helpers::find_value(input.float_options_string, input.float_options_val, "battle_squawk_dd");
+        auto battle_squawk_val = options.value("battle_squawk_dd");
         auto attack_speed = std::pow(1.05, std::round(battle_squawk_val / 5)) - 1;
         armory.buffs.battle_squawk.special_stats.attack_speed = attack_speed;
         temp_buffs.emplace_back("battle_squawk");
@@ -825,17 +886,190 @@ std::vector<std::string> parse_buff_options(Armory& armory, const Sim_input& inp
     return temp_buffs;
 }
 
+// The options Sim_interface reads itself, most of them only in some modes. The config's options are known from
+// parsing the config
+std::vector<std::string> interface_option_keys()
+{
+    std::vector<std::string> keys{
+        "mighty_rage_potion", "haste_potion", "insane_strength_potion", "heroic_potion", "drums_of_battle", "bloodlust",
+        "fungal_bloom", "expose_weakness", "expose_weakness_dd", "full_polarity", "full_polarity_dd",
+        "ferocious_inspiration", "ferocious_inspiration_dd", "battle_squawk", "battle_squawk_dd",
+        "shard", "shard_count_dd", "shard_index_dd", "checkpoint", "structured_output", "compute_dpr",
+        "talents_stat_weights", "n_simulations_talent_dd", "suggestion_disclaimer", "item_strengths", "wep_strengths",
+        "surrogate_model", "surrogate_cache", "replay_fight_dd", "replay_notable_fights",
+        "n_simulations_stat_dd", "stat_weights_gradient", "response_surface", "response_surface_points_dd", "debug_on",
+        // still sent by the website, but not used anymore
+        "hs_rage_thresh_exec_phase_dd", "re_queue_abilities_dd", "extra_target_level_dd", "can_trigger_enrage",
+        "ability_queue",
+    };
+    for (const auto& name : response_surface_stats)
+    {
+        for (const std::string suffix : {"_min_dd", "_max_dd", "_levels_dd"})
+        {
+            keys.emplace_back("response_surface_" + name + suffix);
+        }
+    }
+    return keys;
+}
+
+std::vector<std::string> check_options(Option_index& options)
+{
+    static const auto known_keys = interface_option_keys();
+    options.declare(known_keys);
+    auto unknown = options.unknown_keys();
+    for (const auto& key : unknown)
+    {
+        std::cout << "WARN: Unknown option: " << key << std::endl;
+    }
+    return unknown;
+}
+
+// FNV-1a
+struct Fingerprint
+{
+    void add_bytes(const void* data, size_t size)
+    {
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ static_cast<const unsigned char*>(data)[i]) * 0x100000001b3u;
+        }
+    }
+
+    void add_strings(const std::vector<std::string>& strings)
+    {
+        for (const auto& string : strings)
+        {
+            add_bytes(string.data(), string.size() + 1);
+        }
+        add_bytes("|", 1);
+    }
+
+    uint64_t hash{0xcbf29ce484222325u};
+};
+
+// everything the user put in, a checkpoint is only resumed by the very same job
+uint64_t job_fingerprint(const Sim_input& input)
+{
+    Fingerprint fingerprint{};
+    for (const auto* strings : {&input.race, &input.armor, &input.weapons, &input.buffs, &input.enchants, &input.gems,
+                                &input.stat_weights, &input.options, &input.float_options_string, &input.talent_string,
+                                &input.compare_armor, &input.compare_weapons})
+    {
+        fingerprint.add_strings(*strings);
+    }
+    fingerprint.add_bytes(input.float_options_val.data(), input.float_options_val.size() * sizeof(double));
+    fingerprint.add_bytes(input.talent_val.data(), input.talent_val.size() * sizeof(int));
+    return fingerprint.hash;
+}
+
+// the job a shard belongs to, the same for all of its shards
+uint64_t shard_job_fingerprint(const Sim_input& input)
+{
+    Sim_input job = input;
+    for (size_t i = job.float_options_string.size(); i-- > 0;)
+    {
+        const auto& key = job.float_options_string[i];
+        if ((key == "shard_index_dd" || key == "shard_count_dd") && i < job.float_options_val.size())
+        {
+            job.float_options_string.erase(job.float_options_string.begin() + i);
+            job.float_options_val.erase(job.float_options_val.begin() + i);
+        }
+    }
+    return job_fingerprint(job);
+}
+
+// options that only say what the job computes or how, not how the fight goes
+bool is_job_control_option(const std::string& key)
+{
+    static const std::vector<std::string> prefixes{
+        "shard", "checkpoint", "structured_output", "compute_dpr", "talents_stat_weights", "n_simulations_",
+        "suggestion_disclaimer", "item_strengths", "wep_strengths", "surrogate_", "replay_",
+        "stat_weights_gradient", "response_surface", "debug_on", "n_threads_dd", "target_precision_dd",
+        "control_variates", "antithetic_batches", "fight_length_sweep",
+    };
+    for (const auto& prefix : prefixes)
+    {
+        if (key.compare(0, prefix.size(), prefix) == 0) return true;
+    }
+    return false;
+}
+
+// the character (gear, enchants, gems, talents, buffs) and the fight settings, but not the job options. the surrogate
+//  model only holds around the stats it was fitted at, jobs that ask for other results of the same character reuse it
+uint64_t surrogate_fingerprint(const Sim_input& input)
+{
+    Fingerprint fingerprint{};
+    for (const auto* strings : {&input.race, &input.armor, &input.weapons, &input.buffs, &input.enchants, &input.gems,
+                                &input.talent_string})
+    {
+        fingerprint.add_strings(*strings);
+    }
+    fingerprint.add_bytes(input.talent_val.data(), input.talent_val.size() * sizeof(int));
+    for (const auto& option : input.options)
+    {
+        if (!is_job_control_option(option)) fingerprint.add_bytes(option.data(), option.size() + 1);
+    }
+    for (size_t i = 0; i < input.float_options_string.size() && i < input.float_options_val.size(); i++)
+    {
+        const auto& key = input.float_options_string[i];
+        if (is_job_control_option(key)) continue;
+        fingerprint.add_bytes(key.data(), key.size() + 1);
+        fingerprint.add_bytes(&input.float_options_val[i], sizeof(double));
+    }
+    return fingerprint.hash;
+}
+
+// files that belong to one job (or one kind of job) are named after its fingerprint, so jobs don't share them
+std::string fingerprint_path(const std::string& prefix, uint64_t fingerprint)
+{
+    std::ostringstream path;
+    path << prefix << "_" << std::hex << std::setw(16) << std::setfill('0') << fingerprint << ".bin";
+    return path.str();
+}
+
 Sim_output Sim_interface::simulate(const Sim_input& input)
 {
     Armory armory;
+    Option_index options{input.options, input.float_options_string, input.float_options_val};
 
-    const auto& temp_buffs = parse_buff_options(armory, input);
+    const auto& temp_buffs = parse_buff_options(armory, input, options);
 
     const Character character = character_setup(armory, input.race[0], input.armor, input.weapons, temp_buffs,
                                                 input.talent_string, input.talent_val, input.enchants, input.gems);
 
     // Simulator & Combat settings
-    Combat_simulator_config config{input};
+    Combat_simulator_config config{input, options};
+
+    const auto unknown_options = check_options(options);
+
+    // the searched use effect schedule only goes by a model of the damage, it is kept only if it does significantly
+    //  better in simulation as well. decided before anything else runs, so that every simulation below uses the same
+    //  schedule. shard workers don't decide again, the job that splits the work passes its decision in the option
+    Estimate schedule_search_gain{};
+    if (config.search_use_effect_schedule && !options.has("shard"))
+    {
+        const auto gain = Combat_simulator::schedule_search_gain(config, character);
+        config.search_use_effect_schedule = gain.mean() - q95 * gain.std_of_the_mean() > 0;
+        schedule_search_gain = {"schedule_search", gain.mean(), q95 * gain.std_of_the_mean()};
+    }
+
+    if (options.has("shard"))
+    {
+        // worker mode: only the batches of this shard, the partial result goes to a file for merge_shards
+        const int shard_count = std::max(1, static_cast<int>(options.find("shard_count_dd", 1.0)));
+        const int shard_index = std::min(std::max(static_cast<int>(options.find("shard_index_dd", 0.0)), 0), shard_count - 1);
+        const auto shard = shard_range(config.seed, config.n_batches, shard_index, shard_count);
+        const auto job_id = shard_job_fingerprint(input) ^ static_cast<uint64_t>(config.seed);
+        const auto path = fingerprint_path("shard_" + std::to_string(shard_index) + "_of_" + std::to_string(shard_count), job_id);
+
+        Sim_output output{};
+        output.messages.emplace_back(run_shard(config, character, shard, path) ?
+                                         "Wrote batches [" + std::to_string(shard.first_batch) + ", " +
+                                             std::to_string(shard.first_batch + shard.n_batches) + ") to " + path :
+                                         "Could not write " + path);
+        return output;
+    }
+
     Combat_simulator simulator(config);
 
     for (const auto& wep : character.weapons)
@@ -849,43 +1083,332 @@ Sim_output Sim_interface::simulate(const Sim_input& input)
     const auto white_oh_ht = simulator.get_hit_probabilities_white_oh();
     const auto white_oh_ht_queued = simulator.get_hit_probabilities_white_oh_queued();
 
-    simulator.simulate(character, true);
+    // the follow-up simulations (talents, items, stat weights) are what takes long, those can be resumed
+    const auto job_id = job_fingerprint(input) ^ static_cast<uint64_t>(config.seed);
+    Checkpoint checkpoint = options.has("checkpoint") ? Checkpoint{fingerprint_path("checkpoint", job_id), job_id} : Checkpoint{};
+    std::string checkpoint_info{};
+    if (checkpoint.n_resumed() > 0)
+    {
+        checkpoint_info = "Resumed " + std::to_string(checkpoint.n_resumed()) + " finished simulations from " +
+                          checkpoint.path() + ".<br><br>";
+    }
+
+    // only batch clients that read Sim_output::results want this, everybody else gets the rendered strings as well
+    const bool structured_output = options.has("structured_output");
+
+    Sim_results results{};
+
+    // the stages used to run one after another on the same config, each of them sees the batch count the stages
+    // before it had set
+    auto talent_config = config;
+    if (options.has("talents_stat_weights"))
+    {
+        talent_config.n_batches = static_cast<int>(options.value("n_simulations_talent_dd"));
+    }
+    auto stat_config = talent_config;
+    if (!input.stat_weights.empty() || options.has("response_surface"))
+    {
+        stat_config.n_batches = static_cast<int>(options.value("n_simulations_stat_dd"));
+    }
+
+    // every simulation below gets a task of its own, only those that compare against the base dps wait for it.
+    // the tasks fill separate variables, which are put together in a fixed order once all are done. they don't read
+    // options - lookups record the key in the index, the options they need are read here
+    Parallel::Task_graph tasks{};
+    Distribution base_dps{};
+    const auto base_task = tasks.add([&]() {
+        simulator.simulate_parallel(character, true);
+        base_dps = simulator.get_dps_distribution();
+    });
+
+    // dps vs. fight length, from the base run if it was long enough, otherwise from one run at the longest length
+    std::vector<double> fight_lengths{};
+    std::vector<double> fight_length_dps{};
+    std::string fight_length_info{};
+    if (!config.fight_length_sweep.empty())
+    {
+        auto long_config = config;
+        long_config.sim_time = std::max(config.sim_time, config.fight_length_sweep.back());
+        const bool reuse_base = long_config.sim_time <= config.sim_time;
+        tasks.add([&, long_config, reuse_base]() {
+            Combat_simulator long_simulator(long_config);
+            const Combat_simulator* sweep_simulator = &simulator;
+            if (!reuse_base)
+            {
+                long_simulator.simulate_parallel(character);
+                sweep_simulator = &long_simulator;
+            }
+
+            fight_lengths = sweep_simulator->get_fight_lengths();
+            fight_length_info = "<b>DPS by fight length:</b><br>";
+            for (size_t i = 0; i < fight_lengths.size(); ++i)
+            {
+                const auto& dps = sweep_simulator->get_fight_length_dps()[i];
+                fight_length_dps.push_back(dps.mean());
+                fight_length_info += String_helpers::string_with_precision(fight_lengths[i], 4) + " s: <b>" +
+                                     String_helpers::string_with_precision(dps.mean(), 5) + " &plusmn " +
+                                     String_helpers::string_with_precision(q95 * dps.std_of_the_mean(), 3) + "</b><br>";
+            }
+            fight_length_info += "<br>";
+        }, reuse_base ? std::vector<Parallel::Task_graph::Task_id>{base_task} : std::vector<Parallel::Task_graph::Task_id>{});
+    }
+
+    if (options.has("compute_dpr"))
+    {
+        tasks.add([&]() { compute_dpr(character, simulator, base_dps, simulator.get_damage_distribution(), results.dpr); },
+                  {base_task});
+    }
+
+    if (options.has("talents_stat_weights"))
+    {
+        tasks.add([&]() { results.talent_weights = compute_talent_weights(talent_config, character, base_dps, checkpoint); },
+                  {base_task});
+    }
+
+    const bool compare_characters = input.compare_armor.size() == 15 && input.compare_weapons.size() == 2;
+    std::string compare_stats{};
+    Distribution compare_dps{};
+    if (compare_characters)
+    {
+        tasks.add([&]() {
+            Character character2 = character_setup(armory, input.race[0], input.compare_armor, input.compare_weapons,
+                                                   temp_buffs, input.talent_string, input.talent_val, input.enchants, input.gems);
+            compare_dps = Combat_simulator::simulate(talent_config, character2);
+            compare_stats = get_character_stat(character, character2);
+        });
+    }
+
+    // one task per socket, the upgrades are listed in the order of the sockets
+    std::vector<Socket_upgrades> socket_upgrades{};
+    Surrogate_model surrogate{};
+    if (options.has("suggestion_disclaimer") && (options.has("item_strengths") || options.has("wep_strengths")))
+    {
+        const Character character_new = character_setup(armory, input.race[0], input.armor, input.weapons, temp_buffs,
+                                                        input.talent_string, input.talent_val, input.enchants, input.gems);
+
+        // with the surrogate_model option the candidates are pruned with weights fitted to this character. with
+        //  surrogate_cache the fit is also kept on disk, later jobs for the same character don't fit it again
+        std::vector<Parallel::Task_graph::Task_id> upgrade_deps{base_task};
+        if (options.has("surrogate_model"))
+        {
+            const auto surrogate_id = surrogate_fingerprint(input);
+            const bool cache = options.has("surrogate_cache");
+            upgrade_deps.push_back(tasks.add([&, surrogate_id, cache]() {
+                surrogate = cache ? Surrogate_model::load_or_fit(fingerprint_path("surrogate", surrogate_id), surrogate_id,
+                                                                 talent_config, character) :
+                                    Surrogate_model::fit(talent_config, character);
+            }));
+        }
+        auto add_upgrades = [&](std::function<void(Socket_upgrades&, const Surrogate_model*)> compute) {
+            const auto index = socket_upgrades.size();
+            socket_upgrades.emplace_back();
+            tasks.add([&socket_upgrades, &surrogate, index, compute = std::move(compute)]() {
+                compute(socket_upgrades[index], surrogate.fitted() ? &surrogate : nullptr);
+            }, upgrade_deps);
+        };
+        std::vector<Socket> all_sockets = {
+            Socket::head, Socket::neck, Socket::shoulder, Socket::back, Socket::chest,   Socket::wrist,  Socket::hands,
+            Socket::belt, Socket::legs, Socket::boots,    Socket::ring, Socket::trinket, Socket::ranged,
+        };
+
+        if (options.has("item_strengths"))
+        {
+            for (auto socket : all_sockets)
+            {
+                const bool two_items = socket == Socket::ring || socket == Socket::trinket;
+                for (bool first_item : {true, false})
+                {
+                    if (!first_item && !two_items) continue;
+                    add_upgrades([&, character_new, socket, first_item](Socket_upgrades& upgrades, const Surrogate_model* model) {
+                        item_upgrades(upgrades, talent_config, character_new, armory, base_dps, socket, first_item,
+                                      checkpoint, model);
+                    });
+                }
+            }
+        }
+        if (options.has("wep_strengths"))
+        {
+            const auto& tl = character_new.talents;
+            results.uneven_weapon_specializations =
+                tl.sword_specialization != tl.mace_specialization || tl.sword_specialization != tl.poleaxe_specialization;
+
+            auto weapon_sockets = is_dual_wield ? std::vector<Weapon_socket>{Weapon_socket::main_hand, Weapon_socket::off_hand} :
+                                                  std::vector<Weapon_socket>{Weapon_socket::two_hand};
+            for (auto weapon_socket : weapon_sockets)
+            {
+                add_upgrades([&, character_new, weapon_socket](Socket_upgrades& upgrades, const Surrogate_model* model) {
+                    wep_upgrades(upgrades, talent_config, character_new, armory, base_dps, weapon_socket, checkpoint, model);
+                });
+            }
+        }
+    }
+
+    if (!input.stat_weights.empty())
+    {
+        if (options.has("stat_weights_gradient"))
+        {
+            tasks.add([&]() { results.stat_weights = compute_stat_weights_gradient(stat_config, character, input.stat_weights); });
+        }
+        else
+        {
+            tasks.add([&]() {
+                results.stat_weights = compute_stat_weights(stat_config, character, base_dps, input.stat_weights, checkpoint);
+            }, {base_task});
+        }
+    }
+
+    std::string response_surface{};
+    std::string response_surface_info{};
+    if (options.has("response_surface"))
+    {
+        const auto axes = response_surface_axes(options);
+        const int n_points = static_cast<int>(options.find("response_surface_points_dd", 0.0));
+        tasks.add([&, axes, n_points]() {
+            response_surface = compute_response_surface(stat_config, character, axes, n_points, response_surface_info);
+        });
+    }
+
+    std::string debug_topic{};
+    if (options.has("debug_on"))
+    {
+        tasks.add([&]() {
+            auto debug_config = stat_config;
+            debug_config.display_combat_debug = true;
+            Combat_simulator debug_sim(debug_config);
+            debug_sim.simulate(character, [&base_dps](const Distribution& d) {
+                return std::abs(d.last_sample() - base_dps.mean()) < q95 * base_dps.std_of_the_mean();
+            });
+            debug_topic = debug_sim.get_debug_topic();
+        }, {base_task});
+    }
+
+    // single fights of the base run again with the combat log on: the notable ones (lowest, highest, quantiles) and
+    //  the one asked for by its batch index. the base run itself stays without a log
+    std::string replay_topic{};
+    const bool replay_notable_fights = options.has("replay_notable_fights");
+    const bool replay_fight = options.has("replay_fight_dd");
+    const int replay_batch = replay_fight ? std::max(0, static_cast<int>(options.value("replay_fight_dd"))) : 0;
+    if (replay_notable_fights || replay_fight)
+    {
+        tasks.add([&, replay_notable_fights, replay_fight, replay_batch]() {
+            std::vector<std::pair<std::string, int>> replays{};
+            if (replay_notable_fights)
+            {
+                for (const auto& [name, fight] : simulator.get_notable_fights())
+                {
+                    replays.emplace_back(name, fight.batch);
+                }
+            }
+            if (replay_fight)
+            {
+                replays.emplace_back("requested", replay_batch);
+            }
+            for (const auto& [name, batch] : replays)
+            {
+                const auto replay = Combat_simulator::replay_fight(config, character, batch);
+                replay_topic += "<br><b>Replay of batch " + std::to_string(batch) + " (" + name + ", " +
+                                String_helpers::string_with_precision(replay.dps, 5) + " DPS):</b><br>" + replay.combat_log;
+            }
+        }, {base_task});
+    }
+
+    tasks.run(config.n_threads);
+
 #ifdef TEST_VIA_CONFIG
     print_results(simulator, true);
 #endif
 
-    const auto base_dps = simulator.get_dps_distribution();
-    std::vector<double> mean_dps_vec{base_dps.mean()};
-    std::vector<double> sample_std_dps_vec{base_dps.std_of_the_mean()};
-
     const auto& hist_x = simulator.get_hist_x();
     const auto& hist_y = simulator.get_hist_y();
 
     const auto& dmg_dist = simulator.get_damage_distribution();
     const auto& dps_dist_raw = get_damage_sources(dmg_dist);
 
-    std::vector<std::string> use_effects_schedule_string{};
+    std::vector<double> mean_dps_vec{base_dps.mean()};
+    std::vector<double> sample_std_dps_vec{simulator.get_dps_std_of_the_mean()};
+    if (compare_characters)
+    {
+        mean_dps_vec.push_back(compare_dps.mean());
+        sample_std_dps_vec.push_back(compare_dps.std_of_the_mean());
+    }
+
+    for (const auto& upgrades : socket_upgrades)
+    {
+        results.item_upgrades.insert(results.item_upgrades.end(), upgrades.upgrades.begin(), upgrades.upgrades.end());
+    }
+    if (surrogate.fitted())
+    {
+        const auto names = Surrogate_model::field_names();
+        for (size_t i = 0; i < names.size(); ++i)
+        {
+            results.surrogate_weights.push_back({names[i], surrogate.weights()[i], surrogate.errors()[i]});
+        }
+
+        auto& validation = results.surrogate_validation;
+        for (const auto& upgrades : socket_upgrades)
+        {
+            for (const auto& [predicted, simulated] : upgrades.predicted_and_simulated)
+            {
+                validation.n_items++;
+                validation.mean_error += predicted - simulated;
+                validation.rms_error += (predicted - simulated) * (predicted - simulated);
+                validation.rms_dps_diff += simulated * simulated;
+            }
+        }
+        if (validation.n_items > 0)
+        {
+            validation.mean_error /= validation.n_items;
+            validation.rms_error = std::sqrt(validation.rms_error / validation.n_items);
+            validation.rms_dps_diff = std::sqrt(validation.rms_dps_diff / validation.n_items);
+        }
+
+        for (const auto& upgrades : socket_upgrades)
+        {
+            for (const auto& [predicted, simulated] : upgrades.pruned_predicted_and_simulated)
+            {
+                validation.n_pruned++;
+                validation.pruned_mean_error += predicted - simulated;
+                validation.pruned_rms_error += (predicted - simulated) * (predicted - simulated);
+            }
+            validation.n_pruned_better += upgrades.n_pruned_better;
+        }
+        if (validation.n_pruned > 0)
+        {
+            validation.pruned_mean_error /= validation.n_pruned;
+            validation.pruned_rms_error = std::sqrt(validation.pruned_rms_error / validation.n_pruned);
+        }
+    }
+
+    results.unknown_options = unknown_options;
+    results.schedule_search_gain = schedule_search_gain;
+    results.dual_wield = is_dual_wield;
+    results.dps_std = base_dps.std();
+    if (config.control_variates)
+    {
+        const auto& dps_control_variates = simulator.get_dps_control_variates();
+        results.adjusted_dps = {"dps", dps_control_variates.mean(), q95 * dps_control_variates.std_of_the_mean()};
+        results.adjusted_dps_variance_ratio = dps_control_variates.variance_ratio();
+    }
     {
         auto use_effects_schedule = simulator.compute_use_effects_schedule(character);
         for (auto it = use_effects_schedule.crbegin(); it != use_effects_schedule.crend(); ++it)
         {
-            use_effects_schedule_string.emplace_back(
-                it->second.get().name + " " +
-                String_helpers::string_with_precision(it->first * 0.001, 3) + " " +
-                String_helpers::string_with_precision(it->second.get().duration * 0.001, 3));
+            results.use_effects.push_back({it->second.get().name, it->first * 0.001, it->second.get().duration * 0.001});
         }
     }
 
-    const auto& aura_uptimes = simulator.get_aura_uptimes();
-    const auto& proc_statistics = simulator.get_proc_statistics();
+    for (const auto& aura : simulator.get_aura_uptimes())
+    {
+        results.aura_uptimes.push_back({aura.first, aura.second});
+    }
+    for (const auto& proc : simulator.get_proc_statistics())
+    {
+        results.procs.push_back({proc.first, proc.second});
+    }
     const auto& damage_time_lapse_raw = simulator.get_damage_time_lapse();
     std::vector<std::string> time_lapse_names;
     std::vector<std::vector<double>> damage_time_lapse;
     std::vector<double> dps_dist;
-    std::vector<std::string> damage_names = {"White MH",      "White OH",         "Bloodthirst", "Execute",
-                                             "Heroic Strike", "Cleave",           "Whirlwind",   "Hamstring",
-                                             "Deep Wounds",   "Item Hit Effects", "Overpower",   "Slam",
-                                             "Mortal Strike", "Sweeping Strikes", "Sword Specialization"};
     for (size_t i = 0; i < damage_time_lapse_raw.size(); i++)
     {
         double total_damage = 0;
@@ -895,148 +1418,54 @@ Sim_output Sim_interface::simulate(const Sim_input& input)
         }
         if (total_damage > 0)
         {
-            time_lapse_names.push_back(damage_names[i]);
+            time_lapse_names.emplace_back(damage_source_names[i]);
             damage_time_lapse.push_back(damage_time_lapse_raw[i]);
             dps_dist.push_back(dps_dist_raw[i]);
         }
     }
 
-    std::string character_stats = get_character_stat(character);
-
-    // TODO(vigo) add rage gained or spent here, too
-    std::string rage_info = "<b>Rage Statistics:</b><br>";
-    rage_info += "(Average per simulation)<br>";
-    rage_info += "Rage lost to rage cap (gaining rage when at 100): <b>" +
-                 String_helpers::string_with_precision(simulator.get_rage_lost_capped() / base_dps.samples(), 3) + "</b><br>";
-    rage_info += "</b>Rage lost when changing stance: <b>" +
-                 String_helpers::string_with_precision(simulator.get_rage_lost_stance() / base_dps.samples(), 3) + "</b><br>";
-
-    std::string extra_info_string = "<b>Fight stats vs. target:</b><br>";
-    extra_info_string += "<b>Hit:</b><br>";
-    extra_info_string += String_helpers::percent_to_str("Yellow hits", yellow_mh_ht.miss(), "chance to miss");
-    extra_info_string += String_helpers::percent_to_str("Main-hand, white hits", white_mh_ht.miss(), "chance to miss");
-    if (is_dual_wield)
+    results.character_stats = get_character_stats(character);
+    for (const auto& bonus : character.set_bonuses)
     {
-        extra_info_string += String_helpers::percent_to_str("Off-hand, white hits", white_oh_ht.miss(), "chance to miss");
-        extra_info_string +=
-            String_helpers::percent_to_str("Off-hand, while ability queued", white_oh_ht_queued.miss(), "chance to miss");
+        results.set_bonuses.emplace_back(bonus.name);
     }
 
-    extra_info_string += "<b>Crit chance:</b><br>";
-    extra_info_string += String_helpers::percent_to_str("Yellow main-hand", yellow_mh_ht.crit(), "chance to crit per cast");
-    extra_info_string += String_helpers::percent_to_str("White main-hand", white_mh_ht.crit(), "chance to crit",
-                                                        white_mh_ht.hit(), "left to crit-cap");
+    results.rage_lost_capped = simulator.get_rage_lost_capped() / base_dps.samples();
+    results.rage_lost_stance = simulator.get_rage_lost_stance() / base_dps.samples();
 
+    results.fight_stats.assign(static_cast<size_t>(Fight_stat::size), 0.0);
+    auto set_fight_stat = [&results](Fight_stat stat, double value) { results.fight_stats[static_cast<size_t>(stat)] = value; };
+    set_fight_stat(Fight_stat::yellow_mh_miss, yellow_mh_ht.miss());
+    set_fight_stat(Fight_stat::white_mh_miss, white_mh_ht.miss());
+    set_fight_stat(Fight_stat::yellow_mh_crit, yellow_mh_ht.crit());
+    set_fight_stat(Fight_stat::white_mh_crit, white_mh_ht.crit());
+    set_fight_stat(Fight_stat::white_mh_left_to_crit_cap, white_mh_ht.hit());
+    set_fight_stat(Fight_stat::glance_chance, white_mh_ht.glance());
+    set_fight_stat(Fight_stat::glancing_penalty, 100 * white_mh_ht.glancing_penalty());
+    set_fight_stat(Fight_stat::mh_dodge, yellow_mh_ht.dodge());
     if (is_dual_wield)
     {
-        extra_info_string += String_helpers::percent_to_str("Yellow off-hand", yellow_oh_ht.crit(), "chance to crit per cast");
-        extra_info_string += String_helpers::percent_to_str("White off-hand", white_oh_ht.crit(), "chance to crit",
-                                                            white_oh_ht.hit(), "left to crit-cap");
-    }
-    extra_info_string += "<b>Glancing blows:</b><br>";
-    extra_info_string +=
-        String_helpers::percent_to_str("Chance to occur", white_mh_ht.glance(), "(based on level difference)");
-    extra_info_string +=
-        String_helpers::percent_to_str("Glancing damage", 100 * white_mh_ht.glancing_penalty(), "(based on level difference)");
-    extra_info_string += "<b>Other:</b><br>";
-    extra_info_string += String_helpers::percent_to_str("Main-hand dodge chance", yellow_mh_ht.dodge(), "(based on level difference and expertise)");
-    if (is_dual_wield)
-    {
-        extra_info_string += String_helpers::percent_to_str("Off-hand dodge chance", yellow_oh_ht.dodge(), "(based on level difference and expertise)");
+        set_fight_stat(Fight_stat::white_oh_miss, white_oh_ht.miss());
+        set_fight_stat(Fight_stat::white_oh_queued_miss, white_oh_ht_queued.miss());
+        set_fight_stat(Fight_stat::yellow_oh_crit, yellow_oh_ht.crit());
+        set_fight_stat(Fight_stat::white_oh_crit, white_oh_ht.crit());
+        set_fight_stat(Fight_stat::white_oh_left_to_crit_cap, white_oh_ht.hit());
+        set_fight_stat(Fight_stat::oh_dodge, yellow_oh_ht.dodge());
     }
-    extra_info_string += "<br><br>";
 
-    std::string dpr_info = "<br>(Hint: Ability damage per rage computations can be turned on under 'Simulation settings')";
-    if (String_helpers::find_string(input.options, "compute_dpr"))
-    {
-        compute_dpr(character, simulator, base_dps, dmg_dist, dpr_info);
-    }
-
-    std::string talents_info = "<br>(Hint: Talent stat-weights can be activated under 'Simulation settings')";
-    if (String_helpers::find_string(input.options, "talents_stat_weights"))
-    {
-        config.n_batches = static_cast<int>(String_helpers::find_value(input.float_options_string, input.float_options_val, "n_simulations_talent_dd"));
-        talents_info = compute_talent_weights(config, character, base_dps);
-    }
 #ifdef TEST_VIA_CONFIG
-    if (talents_info.find("Value per 1 talent point") != std::string::npos)
+    if (!results.talent_weights.empty())
     {
+        const auto talents_info = Sim_output_renderer::talent_weights(results.talent_weights);
         for (size_t ppos = 0, pos = talents_info.find("<br>", ppos); pos != std::string::npos; ppos = pos + 4, pos = talents_info.find("<br>", ppos))
         {
             std::cout << talents_info.substr(ppos, pos - ppos) << std::endl;
         }
     }
     std::cout << std::endl;
-#endif
-
-    if (input.compare_armor.size() == 15 && input.compare_weapons.size() == 2)
-    {
-        Character character2 = character_setup(armory, input.race[0], input.compare_armor, input.compare_weapons,
-                                               temp_buffs, input.talent_string, input.talent_val, input.enchants, input.gems);
-
-        auto compare_dps = Combat_simulator::simulate(config, character2);
-
-        double mean_init_2 = compare_dps.mean();
-        double sample_std_init_2 = compare_dps.std_of_the_mean();
-
-        character_stats = get_character_stat(character, character2);
-
-        mean_dps_vec.push_back(mean_init_2);
-        sample_std_dps_vec.push_back(sample_std_init_2);
-    }
-
-    std::string item_strengths_string;
-    if (String_helpers::find_string(input.options, "suggestion_disclaimer") && (String_helpers::find_string(input.options, "item_strengths") || String_helpers::find_string(input.options, "wep_strengths")))
-    {
-        item_strengths_string = "<b>Character items and proposed upgrades:</b><br>";
-
-        Character character_new = character_setup(armory, input.race[0], input.armor, input.weapons, temp_buffs,
-                                                  input.talent_string, input.talent_val, input.enchants, input.gems);
-        std::string dummy{};
-        std::vector<Socket> all_sockets = {
-            Socket::head, Socket::neck, Socket::shoulder, Socket::back, Socket::chest,   Socket::wrist,  Socket::hands,
-            Socket::belt, Socket::legs, Socket::boots,    Socket::ring, Socket::trinket, Socket::ranged,
-        };
-
-        if (String_helpers::find_string(input.options, "item_strengths"))
-        {
-            for (auto socket : all_sockets)
-            {
-                if (socket == Socket::ring || socket == Socket::trinket)
-                {
-                    item_upgrades(item_strengths_string, config, character_new, armory, base_dps, socket, true);
-                    item_upgrades(item_strengths_string, config, character_new, armory, base_dps, socket, false);
-                }
-                else
-                {
-                    item_upgrades(item_strengths_string, config, character_new, armory, base_dps, socket, true);
-                }
-            }
-        }
-        if (String_helpers::find_string(input.options, "wep_strengths"))
-        {
-            const auto& tl = character_new.talents;
-            if (tl.sword_specialization != tl.mace_specialization || tl.sword_specialization != tl.poleaxe_specialization)
-            {
-                item_strengths_string += "Consider comparing weapons with all weapon specializations set to the same value (e.g. 5/5).<br><br>";
-            }
-
-            if (is_dual_wield)
-            {
-                wep_upgrades(item_strengths_string, config, character_new, armory, base_dps, Weapon_socket::main_hand);
-                wep_upgrades(item_strengths_string, config, character_new, armory, base_dps, Weapon_socket::off_hand);
-            }
-            else
-            {
-                wep_upgrades(item_strengths_string, config, character_new, armory, base_dps, Weapon_socket::two_hand);
-            }
-        }
-        item_strengths_string += "<br><br>";
-    }
-
-#ifdef TEST_VIA_CONFIG
-    if (!item_strengths_string.empty())
+    if (!results.item_upgrades.empty())
     {
+        const auto item_strengths_string = Sim_output_renderer::item_upgrades(results);
         for (size_t ppos = 0, pos = item_strengths_string.find("<br>", ppos); pos != std::string::npos; ppos = pos + 4, pos = item_strengths_string.find("<br>", ppos))
         {
             std::cout << item_strengths_string.substr(ppos, pos - ppos) << std::endl;
@@ -1044,60 +1473,43 @@ Sim_output Sim_interface::simulate(const Sim_input& input)
     }
 #endif
 
-    std::vector<std::string> sw_strings{};
-    if (!input.stat_weights.empty())
-    {
-        config.n_batches = static_cast<int>(String_helpers::find_value(input.float_options_string, input.float_options_val, "n_simulations_stat_dd"));
-        sw_strings = compute_stat_weights(config, character, base_dps, input.stat_weights);
-    }
-
-    std::string debug_topic{};
-    if (String_helpers::find_string(input.options, "debug_on"))
+    if (options.has("debug_on"))
     {
-        config.display_combat_debug = true;
-        Combat_simulator debug_sim(config);
-        debug_sim.simulate(character, [base_dps](const Distribution& d) {
-            return std::abs(d.last_sample() - base_dps.mean()) < q95 * base_dps.std_of_the_mean();
-        });
-        debug_topic = debug_sim.get_debug_topic();
-
         debug_topic += "<br><br>";
         debug_topic += "Fight statistics:<br>";
         debug_topic += "DPS: " + String_helpers::string_with_precision(base_dps.mean(), 2) + "<br><br>";
 
         auto f = 1.0 / (config.sim_time * base_dps.samples());
         debug_topic += "DPS from sources:<br>";
-        debug_topic += "DPS white MH: " + String_helpers::string_with_precision(dmg_dist.white_mh_damage * f, 2) + "<br>";
-        if (dmg_dist.white_mh_count > 0) debug_topic += "DPS white OH: " + String_helpers::string_with_precision(dmg_dist.white_oh_damage * f, 2) + "<br>";
-        if (dmg_dist.bloodthirst_count > 0) debug_topic += "DPS bloodthirst: " + String_helpers::string_with_precision(dmg_dist.bloodthirst_damage * f, 2) + "<br>";
-        if (dmg_dist.mortal_strike_count > 0) debug_topic += "DPS mortal strike: " + String_helpers::string_with_precision(dmg_dist.mortal_strike_damage * f, 2) + "<br>";
-        if (dmg_dist.sweeping_strikes_count > 0) debug_topic += "DPS sweeping strikes: " + String_helpers::string_with_precision(dmg_dist.sweeping_strikes_damage * f, 2) + "<br>";
-        if (dmg_dist.overpower_count > 0) debug_topic += "DPS overpower: " + String_helpers::string_with_precision(dmg_dist.overpower_damage * f, 2) + "<br>";
-        if (dmg_dist.slam_count > 0) debug_topic += "DPS slam: " + String_helpers::string_with_precision(dmg_dist.slam_damage * f, 2) + "<br>";
-        if (dmg_dist.execute_count > 0) debug_topic += "DPS execute: " + String_helpers::string_with_precision(dmg_dist.execute_damage * f, 2) + "<br>";
-        if (dmg_dist.heroic_strike_count > 0) debug_topic += "DPS heroic strike: " + String_helpers::string_with_precision(dmg_dist.heroic_strike_damage * f, 2) + "<br>";
-        if (dmg_dist.cleave_count > 0) debug_topic += "DPS cleave: " + String_helpers::string_with_precision(dmg_dist.cleave_damage * f, 2) + "<br>";
-        if (dmg_dist.whirlwind_damage > 0) debug_topic += "DPS whirlwind: " + String_helpers::string_with_precision(dmg_dist.whirlwind_damage * f, 2) + "<br>";
-        if (dmg_dist.hamstring_count > 0) debug_topic += "DPS hamstring: " + String_helpers::string_with_precision(dmg_dist.hamstring_damage * f, 2) + "<br>";
-        if (dmg_dist.deep_wounds_count > 0) debug_topic += "DPS deep wounds: " + String_helpers::string_with_precision(dmg_dist.deep_wounds_damage * f, 2) + "<br>";
-        if (dmg_dist.item_hit_effects_count > 0) debug_topic += "DPS item effects: " + String_helpers::string_with_precision(dmg_dist.item_hit_effects_damage * f, 2) + "<br><br>";
+        for (size_t i = 0; i < n_damage_sources; i++)
+        {
+            if (dmg_dist.counts[i] > 0)
+            {
+                debug_topic += std::string("DPS ") + damage_source_names[i] + ": " +
+                               String_helpers::string_with_precision(dmg_dist.damage[i] * f, 2) + "<br>";
+            }
+        }
+        debug_topic += "<br>";
 
         auto g = 1.0 / base_dps.samples();
         debug_topic += "Casts:<br>";
-        debug_topic += "#Hits white MH: " + String_helpers::string_with_precision(dmg_dist.white_mh_count * g, 2) + "<br>";
-        if (dmg_dist.white_oh_count > 0) debug_topic += "#Hits white OH: " + String_helpers::string_with_precision(dmg_dist.white_oh_count * g, 2) + "<br>";
-        if (dmg_dist.bloodthirst_count > 0) debug_topic += "#Hits bloodthirst: " + String_helpers::string_with_precision(dmg_dist.bloodthirst_count * g, 2) + "<br>";
-        if (dmg_dist.mortal_strike_count > 0) debug_topic += "#Hits mortal strike: " + String_helpers::string_with_precision(dmg_dist.mortal_strike_count * g, 2) + "<br>";
-        if (dmg_dist.sweeping_strikes_count > 0) debug_topic += "#Hits sweeping strikes: " + String_helpers::string_with_precision(dmg_dist.sweeping_strikes_count * g, 2) + "<br>";
-        if (dmg_dist.overpower_count > 0) debug_topic += "#Hits overpower: " + String_helpers::string_with_precision(dmg_dist.overpower_count * g, 2) + "<br>";
-        if (dmg_dist.slam_count > 0) debug_topic += "#Hits slam: " + String_helpers::string_with_precision(dmg_dist.slam_count * g, 2) + "<br>";
-        if (dmg_dist.execute_count > 0) debug_topic += "#Hits execute: " + String_helpers::string_with_precision(dmg_dist.execute_count * g, 2) + "<br>";
-        if (dmg_dist.heroic_strike_count > 0) debug_topic += "#Hits heroic strike: " + String_helpers::string_with_precision(dmg_dist.heroic_strike_count * g, 2) + "<br>";
-        if (dmg_dist.cleave_count > 0) debug_topic += "#Hits cleave: " + String_helpers::string_with_precision(dmg_dist.cleave_count * g, 2) + "<br>";
-        if (dmg_dist.whirlwind_count > 0) debug_topic += "#Hits whirlwind: " + String_helpers::string_with_precision(dmg_dist.whirlwind_count * g, 2) + "<br>";
-        if (dmg_dist.hamstring_count > 0) debug_topic += "#Hits hamstring: " + String_helpers::string_with_precision(dmg_dist.hamstring_count * g, 2) + "<br>";
-        if (dmg_dist.deep_wounds_count > 0) debug_topic += "#Hits deep_wounds: " + String_helpers::string_with_precision(dmg_dist.deep_wounds_count * g, 2) + "<br>";
-        if (dmg_dist.item_hit_effects_count > 0) debug_topic += "#Hits item effects: " + String_helpers::string_with_precision(dmg_dist.item_hit_effects_count * g, 2) + "<br>";
+        for (size_t i = 0; i < n_damage_sources; i++)
+        {
+            if (dmg_dist.counts[i] > 0)
+            {
+                debug_topic += std::string("#Hits ") + damage_source_names[i] + ": " +
+                               String_helpers::string_with_precision(dmg_dist.counts[i] * g, 2) + "<br>";
+            }
+        }
+    }
+
+    for (const auto& [name, fight] : simulator.get_notable_fights())
+    {
+        results.notable_fights.push_back({name, fight.batch, fight.dps});
+    }
+    if (!replay_topic.empty())
+    {
+        debug_topic += "<br>" + Sim_output_renderer::notable_fights(results.notable_fights) + replay_topic;
     }
 
     for (auto& v : sample_std_dps_vec)
@@ -1105,30 +1517,57 @@ Sim_output Sim_interface::simulate(const Sim_input& input)
         v *= q95;
     }
 
-    auto p5 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.05), 0.01);
-    auto p50 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.50), 0.01);
-    auto p95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
-
-    std::string histogram_details(
-        "Mean is " + String_helpers::string_with_precision(base_dps.mean(), 1) + " DPS, " +
-        "Standard deviation is " + String_helpers::string_with_precision(base_dps.std(), 1) +  + " DPS.<br><ul>" +
-        "<li>5% of all samples are within &plusmn " + String_helpers::string_with_precision(base_dps.std() * p5, 1) + " DPS of the mean." +
-        "<li>50% of all samples are within &plusmn " + String_helpers::string_with_precision(base_dps.std() * p50, 1) + " DPS of the mean (lighter blue above)." +
-        "<li>95% of all samples are within &plusmn " + String_helpers::string_with_precision(base_dps.std() * p95, 1) + " DPS of the mean." +
-        "</ul><br>");
+    const auto& dps_sketch = simulator.get_dps_sketch();
+    std::vector<double> dps_percentiles{dps_sketch.quantile(0.05), dps_sketch.quantile(0.5), dps_sketch.quantile(0.95)};
+
+    checkpoint.remove();
+
+    if (structured_output)
+    {
+        return {hist_x,
+                hist_y,
+                dps_dist,
+                time_lapse_names,
+                damage_time_lapse,
+                {},
+                {},
+                {},
+                {},
+                {{}, debug_topic},
+                {},
+                mean_dps_vec,
+                sample_std_dps_vec,
+                {},
+                dps_percentiles,
+                fight_lengths,
+                fight_length_dps,
+                response_surface,
+                std::move(results)};
+    }
+
+    auto extra_info = Sim_output_renderer::unknown_options(results.unknown_options) + checkpoint_info +
+                      Sim_output_renderer::adjusted_dps(results) + Sim_output_renderer::schedule_search(results) + Sim_output_renderer::item_upgrades(results) +
+                      Sim_output_renderer::surrogate_model(results) + Sim_output_renderer::fight_stats(results) +
+                      Sim_output_renderer::rage(results) + fight_length_info + response_surface_info +
+                      Sim_output_renderer::dpr(results.dpr) + Sim_output_renderer::talent_weights(results.talent_weights);
 
     return {hist_x,
             hist_y,
             dps_dist,
             time_lapse_names,
             damage_time_lapse,
-            aura_uptimes,
-            use_effects_schedule_string,
-            proc_statistics,
-            sw_strings,
-            {item_strengths_string + extra_info_string + rage_info + dpr_info + talents_info, debug_topic},
-            histogram_details,
+            Sim_output_renderer::named_values(results.aura_uptimes),
+            Sim_output_renderer::use_effects(results.use_effects),
+            Sim_output_renderer::named_values(results.procs),
+            Sim_output_renderer::stat_weights(results.stat_weights),
+            {extra_info, debug_topic},
+            Sim_output_renderer::histogram_details(base_dps.mean(), base_dps.std(), dps_percentiles),
             mean_dps_vec,
             sample_std_dps_vec,
-            {character_stats}};
+            {compare_stats.empty() ? Sim_output_renderer::character_stats(results) : compare_stats},
+            dps_percentiles,
+            fight_lengths,
+            fight_length_dps,
+            response_surface,
+            std::move(results)};
 }
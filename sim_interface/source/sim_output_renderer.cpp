@@ -0,0 +1,345 @@
+#include "sim_output_renderer.hpp"
+
+#include "Statistics.hpp"
+#include "string_helpers.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace
+{
+std::string print_stat(const std::string& stat_name, double amount, double bonus_amount = -1)
+{
+    std::ostringstream stream;
+    stream << stat_name << std::setprecision(4) << "<b>" << amount;
+    if (bonus_amount > 0) stream << " + " << std::setprecision(4) << bonus_amount;
+    stream << "</b><br>";
+    return stream.str();
+}
+
+std::string item_upgrade_string(const Item_upgrade_result& upgrade)
+{
+    // TODO(vigo) consider labelling "<b>Side</b>grade" (" Note: Similar item stats, difficult to draw conclusions.")
+    std::string s;
+    if (upgrade.dps_diff >= 0)
+    {
+        s += "<br><b>Up</b>grade: <b>" + upgrade.item + "</b> ( +<b>";
+    }
+    else
+    {
+        s += "<br><b>Down</b>grade: <b>" + upgrade.item + "</b> ( <b>";
+    }
+    s += String_helpers::string_with_precision(upgrade.dps_diff, 1) + " &plusmn ";
+    s += String_helpers::string_with_precision(upgrade.error, 1) + "</b> DPS).";
+    return s;
+}
+
+std::string dpr_string(const Dpr_result& dpr)
+{
+    return "<b>" + dpr.ability + "</b>: <br>Damage per cast: <b>" +
+           String_helpers::string_with_precision(dpr.damage_per_cast, 4) + "</b><br>Average rage cost: <b>" +
+           String_helpers::string_with_precision(dpr.rage_cost, 3) + "</b><br>DPR: <b>" +
+           String_helpers::string_with_precision(dpr.damage_per_cast / dpr.rage_cost, 4) + "</b><br>";
+}
+} // namespace
+
+namespace Sim_output_renderer
+{
+std::vector<std::string> named_values(const std::vector<Named_value>& values)
+{
+    std::vector<std::string> strings;
+    strings.reserve(values.size());
+    for (const auto& value : values)
+    {
+        strings.emplace_back(value.name + " " + std::to_string(value.value));
+    }
+    return strings;
+}
+
+std::vector<std::string> use_effects(const std::vector<Use_effect_timing>& use_effects)
+{
+    std::vector<std::string> strings;
+    strings.reserve(use_effects.size());
+    for (const auto& use_effect : use_effects)
+    {
+        strings.emplace_back(use_effect.name + " " + String_helpers::string_with_precision(use_effect.time, 3) + " " +
+                             String_helpers::string_with_precision(use_effect.duration, 3));
+    }
+    return strings;
+}
+
+std::vector<std::string> stat_weights(const std::vector<Estimate>& stat_weights)
+{
+    std::vector<std::string> strings;
+    strings.reserve(stat_weights.size());
+    for (const auto& sw : stat_weights)
+    {
+        strings.emplace_back(sw.name + ":" + std::to_string(sw.mean) + ":" + std::to_string(sw.error));
+    }
+    return strings;
+}
+
+std::string unknown_options(const std::vector<std::string>& unknown_options)
+{
+    if (unknown_options.empty()) return {};
+
+    std::string out_string = "Ignored unknown options:";
+    for (const auto& option : unknown_options)
+    {
+        out_string += " <b>" + option + "</b>";
+    }
+    return out_string + "<br><br>";
+}
+
+std::string adjusted_dps(const Sim_results& results)
+{
+    if (results.adjusted_dps.name.empty()) return {};
+
+    return "DPS adjusted for the luck in crits, misses and procs: <b>" +
+           String_helpers::string_with_precision(results.adjusted_dps.mean, 5) + " &plusmn " +
+           String_helpers::string_with_precision(results.adjusted_dps.error, 3) + "</b> (" +
+           String_helpers::string_with_precision(100 * results.adjusted_dps_variance_ratio, 3) +
+           "% of the variance left)<br><br>";
+}
+
+std::string schedule_search(const Sim_results& results)
+{
+    const auto& gain = results.schedule_search_gain;
+    if (gain.name.empty()) return {};
+
+    return "Searched cooldown timings vs. the default ones: <b>" + String_helpers::string_with_precision(gain.mean, 3) +
+           " &plusmn " + String_helpers::string_with_precision(gain.error, 3) + "</b> DPS, " +
+           (gain.mean - gain.error > 0 ? "the searched timings are used" : "the default timings are kept") + "<br><br>";
+}
+
+std::string character_stats(const Sim_results& results)
+{
+    auto stat = [&results](Character_stat character_stat) {
+        return results.character_stats[static_cast<size_t>(character_stat)];
+    };
+
+    std::string out_string = "<b>Character stats:</b> <br />";
+    out_string += print_stat("Strength: ", stat(Character_stat::strength));
+    out_string += print_stat("Agility: ", stat(Character_stat::agility));
+    out_string += print_stat("Hit: ", stat(Character_stat::hit));
+    out_string += print_stat("Expertise (before rounding down): ", stat(Character_stat::expertise));
+    out_string += print_stat("Crit (spellbook): ", stat(Character_stat::crit));
+    out_string += print_stat("Attack Power: ", stat(Character_stat::attack_power), stat(Character_stat::bonus_attack_power));
+    out_string += print_stat("Haste factor: ", stat(Character_stat::haste_factor));
+
+    const std::vector<std::pair<Character_stat, std::string>> weapon_types =
+        results.dual_wield ? std::vector<std::pair<Character_stat, std::string>>{{Character_stat::sword_expertise, "Sword bonus expertise: "},
+                                                                                {Character_stat::axe_expertise, "Axe bonus expertise: "},
+                                                                                {Character_stat::dagger_expertise, "Dagger bonus expertise: "},
+                                                                                {Character_stat::mace_expertise, "Mace bonus expertise: "},
+                                                                                {Character_stat::unarmed_expertise, "Unarmed bonus expertise: "}} :
+                             std::vector<std::pair<Character_stat, std::string>>{{Character_stat::sword_expertise, "Two Hand Sword expertise: "},
+                                                                                {Character_stat::axe_expertise, "Two Hand Axe expertise: "},
+                                                                                {Character_stat::mace_expertise, "Two Hand Mace expertise: "}};
+    for (const auto& weapon_type : weapon_types)
+    {
+        if (stat(weapon_type.first) >= 0)
+        {
+            out_string += print_stat(weapon_type.second, stat(weapon_type.first));
+        }
+    }
+
+    out_string += "<br>";
+
+    out_string += "Set bonuses:<br>";
+    for (const auto& bonus : results.set_bonuses)
+    {
+        out_string += "<b>" + bonus + "</b><br>";
+    }
+
+    return out_string;
+}
+
+std::string fight_stats(const Sim_results& results)
+{
+    auto stat = [&results](Fight_stat fight_stat) { return results.fight_stats[static_cast<size_t>(fight_stat)]; };
+
+    std::string out_string = "<b>Fight stats vs. target:</b><br>";
+    out_string += "<b>Hit:</b><br>";
+    out_string += String_helpers::percent_to_str("Yellow hits", stat(Fight_stat::yellow_mh_miss), "chance to miss");
+    out_string += String_helpers::percent_to_str("Main-hand, white hits", stat(Fight_stat::white_mh_miss), "chance to miss");
+    if (results.dual_wield)
+    {
+        out_string += String_helpers::percent_to_str("Off-hand, white hits", stat(Fight_stat::white_oh_miss), "chance to miss");
+        out_string += String_helpers::percent_to_str("Off-hand, while ability queued", stat(Fight_stat::white_oh_queued_miss),
+                                                     "chance to miss");
+    }
+
+    out_string += "<b>Crit chance:</b><br>";
+    out_string += String_helpers::percent_to_str("Yellow main-hand", stat(Fight_stat::yellow_mh_crit), "chance to crit per cast");
+    out_string += String_helpers::percent_to_str("White main-hand", stat(Fight_stat::white_mh_crit), "chance to crit",
+                                                 stat(Fight_stat::white_mh_left_to_crit_cap), "left to crit-cap");
+
+    if (results.dual_wield)
+    {
+        out_string += String_helpers::percent_to_str("Yellow off-hand", stat(Fight_stat::yellow_oh_crit), "chance to crit per cast");
+        out_string += String_helpers::percent_to_str("White off-hand", stat(Fight_stat::white_oh_crit), "chance to crit",
+                                                     stat(Fight_stat::white_oh_left_to_crit_cap), "left to crit-cap");
+    }
+    out_string += "<b>Glancing blows:</b><br>";
+    out_string += String_helpers::percent_to_str("Chance to occur", stat(Fight_stat::glance_chance), "(based on level difference)");
+    out_string += String_helpers::percent_to_str("Glancing damage", stat(Fight_stat::glancing_penalty), "(based on level difference)");
+    out_string += "<b>Other:</b><br>";
+    out_string += String_helpers::percent_to_str("Main-hand dodge chance", stat(Fight_stat::mh_dodge),
+                                                 "(based on level difference and expertise)");
+    if (results.dual_wield)
+    {
+        out_string += String_helpers::percent_to_str("Off-hand dodge chance", stat(Fight_stat::oh_dodge),
+                                                     "(based on level difference and expertise)");
+    }
+    out_string += "<br><br>";
+    return out_string;
+}
+
+std::string rage(const Sim_results& results)
+{
+    // TODO(vigo) add rage gained or spent here, too
+    std::string out_string = "<b>Rage Statistics:</b><br>";
+    out_string += "(Average per simulation)<br>";
+    out_string += "Rage lost to rage cap (gaining rage when at 100): <b>" +
+                  String_helpers::string_with_precision(results.rage_lost_capped, 3) + "</b><br>";
+    out_string += "</b>Rage lost when changing stance: <b>" +
+                  String_helpers::string_with_precision(results.rage_lost_stance, 3) + "</b><br>";
+    return out_string;
+}
+
+std::string talent_weights(const std::vector<Estimate>& talent_weights)
+{
+    if (talent_weights.empty())
+    {
+        return "<br>(Hint: Talent stat-weights can be activated under 'Simulation settings')";
+    }
+
+    std::string out_string = "<br><b>Value per 1 talent point:</b>";
+    for (const auto& tw : talent_weights)
+    {
+        out_string += "<br>Talent: <b>" + tw.name + "</b><br>Value: <b>" +
+                      String_helpers::string_with_precision(tw.mean, 4) + " &plusmn " +
+                      String_helpers::string_with_precision(tw.error, 3) + " DPS</b><br>";
+    }
+    return out_string;
+}
+
+std::string item_upgrades(const Sim_results& results)
+{
+    const auto& upgrades = results.item_upgrades;
+    if (upgrades.empty()) return {};
+
+    std::string out_string = "<b>Character items and proposed upgrades:</b><br>";
+    bool weapon_note = results.uneven_weapon_specializations;
+    for (size_t begin = 0, end = 0; begin < upgrades.size(); begin = end)
+    {
+        while (end < upgrades.size() && upgrades[end].socket == upgrades[begin].socket &&
+               upgrades[end].first_item == upgrades[begin].first_item)
+        {
+            ++end;
+        }
+
+        const auto socket = upgrades[begin].socket;
+        if (weapon_note && (socket == Socket::main_hand || socket == Socket::off_hand))
+        {
+            out_string += "Consider comparing weapons with all weapon specializations set to the same value (e.g. 5/5).<br><br>";
+            weapon_note = false;
+        }
+
+        out_string += "Current " + friendly_name(socket) + ": <b>" + upgrades[begin].current_item + "</b>";
+        if (upgrades[begin].dps_diff < 0)
+        {
+            out_string += " is <b>BiS</b> in current configuration!";
+        }
+        for (size_t i = begin; i < end; ++i)
+        {
+            out_string += item_upgrade_string(upgrades[i]);
+        }
+        out_string += "<br><br>";
+    }
+    out_string += "<br><br>";
+    return out_string;
+}
+
+std::string surrogate_model(const Sim_results& results)
+{
+    if (results.surrogate_weights.empty()) return {};
+
+    std::string out_string = "<b>Surrogate model used to pick the item candidates</b> (dps per stat):<br>";
+    for (const auto& weight : results.surrogate_weights)
+    {
+        out_string += weight.name + ": <b>" + String_helpers::string_with_precision(weight.mean, 3) + " &plusmn " +
+                      String_helpers::string_with_precision(weight.error, 2) + "</b><br>";
+    }
+    const auto& validation = results.surrogate_validation;
+    if (validation.n_items > 0)
+    {
+        out_string += "Predicted the " + std::to_string(validation.n_items) +
+                      " simulated items without procs or set bonuses to within <b>" +
+                      String_helpers::string_with_precision(validation.rms_error, 3) + "</b> DPS (rms, mean error " +
+                      String_helpers::string_with_precision(validation.mean_error, 3) + ", the upgrades spread " +
+                      String_helpers::string_with_precision(validation.rms_dps_diff, 3) + " DPS).<br>";
+    }
+    if (validation.n_pruned > 0)
+    {
+        out_string += "Of " + std::to_string(validation.n_pruned) + " candidates it pruned and that were simulated to check, <b>" +
+                      std::to_string(validation.n_pruned_better) +
+                      "</b> came out better than the weakest candidate kept. Predicted them to within <b>" +
+                      String_helpers::string_with_precision(validation.pruned_rms_error, 3) + "</b> DPS (rms, mean error " +
+                      String_helpers::string_with_precision(validation.pruned_mean_error, 3) + ").<br>";
+    }
+    return out_string + "<br>";
+}
+
+std::string dpr(const std::vector<Dpr_result>& dpr)
+{
+    if (dpr.empty())
+    {
+        return "<br>(Hint: Ability damage per rage computations can be turned on under 'Simulation settings')";
+    }
+
+    std::string out_string = "<br><b>Ability damage per rage:</b><br>";
+    out_string += "DPR for ability X is computed as following:<br> "
+                  "((Normal DPS) - (DPS where ability X costs rage but has no effect)) / (rage cost of ability "
+                  "X)<br>";
+    for (const auto& d : dpr)
+    {
+        out_string += dpr_string(d);
+    }
+    return out_string;
+}
+
+std::string notable_fights(const std::vector<Notable_fight>& notable_fights)
+{
+    if (notable_fights.empty()) return {};
+
+    std::string out_string = "<b>Fights of the run</b> (replay one with replay_fight_dd = its batch):<br>";
+    for (const auto& fight : notable_fights)
+    {
+        out_string += fight.name + ": batch <b>" + std::to_string(fight.batch) + "</b>, " +
+                      String_helpers::string_with_precision(fight.dps, 5) + " DPS<br>";
+    }
+    return out_string + "<br>";
+}
+
+std::string histogram_details(double mean, double std, const std::vector<double>& dps_percentiles)
+{
+    auto p5 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.05), 0.01);
+    auto p50 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.50), 0.01);
+    auto p95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
+
+    return "Mean is " + String_helpers::string_with_precision(mean, 1) + " DPS, " +
+           "Standard deviation is " + String_helpers::string_with_precision(std, 1) + " DPS.<br><ul>" +
+           "<li>5% of all samples are within &plusmn " + String_helpers::string_with_precision(std * p5, 1) + " DPS of the mean." +
+           "<li>50% of all samples are within &plusmn " + String_helpers::string_with_precision(std * p50, 1) + " DPS of the mean (lighter blue above)." +
+           "<li>95% of all samples are within &plusmn " + String_helpers::string_with_precision(std * p95, 1) + " DPS of the mean." +
+           "</ul>" +
+           "Percentiles of the dps per fight:<ul>" +
+           "<li>5th percentile (1 in 20 fights is worse): " + String_helpers::string_with_precision(dps_percentiles[0], 1) + " DPS." +
+           "<li>Median: " + String_helpers::string_with_precision(dps_percentiles[1], 1) + " DPS." +
+           "<li>95th percentile (1 in 20 fights is better): " + String_helpers::string_with_precision(dps_percentiles[2], 1) + " DPS." +
+           "</ul><br>";
+}
+
+} // namespace Sim_output_renderer
@@ -21,6 +21,7 @@ struct Over_time_buff
         rage_gain(effect.rage_gain),
         damage(effect.damage),
         special_stats(effect.special_stats),
+        stat_delta(effect.special_stats),
         interval(effect.interval),
         next_tick(current_time + effect.interval),
         next_fade(current_time + effect.duration),
@@ -32,6 +33,7 @@ struct Over_time_buff
     double rage_gain;
     double damage;
     Special_stats special_stats;
+    Stat_delta stat_delta;
 
     int interval;
 
@@ -48,6 +50,7 @@ struct Combat_buff
     Combat_buff(const Hit_effect& hit_effect, const Special_stats& multipliers, int current_time) :
         name(hit_effect.name),
         special_stats_boost(hit_effect.to_special_stats(multipliers)),
+        stat_delta(special_stats_boost),
         stacks(1),
         next_fade(current_time + hit_effect.duration),
         charges(hit_effect.max_charges),
@@ -56,6 +59,7 @@ struct Combat_buff
 
     const std::string name;
     const Special_stats special_stats_boost;
+    const Stat_delta stat_delta;
     int stacks;
 
     int next_fade;
@@ -70,27 +74,33 @@ struct Hit_aura
 {
     static constexpr int inactive = -1;
 
-    Hit_aura(std::string name, int current_time, int duration) :
+    Hit_aura(std::string name, int mh_index, int oh_index) :
         name(std::move(name)),
-        next_fade(current_time + duration),
-        hit_effect_mh(nullptr),
-        hit_effect_oh(nullptr) { }
+        next_fade(inactive),
+        mh_index(mh_index),
+        oh_index(oh_index) { }
 
     std::string name;
     int next_fade;
 
-    Hit_effect* hit_effect_mh; // disabled on next_fade
-    Hit_effect* hit_effect_oh;
+    // hit effects on the weapons, disabled on next_fade. -1 if the weapon doesn't carry it
+    int mh_index;
+    int oh_index;
 };
 
 class Buff_manager
 {
 public:
-    void initialize(std::vector<Hit_effect>& hit_effects_mh_input, std::vector<Hit_effect>& hit_effects_oh_input,
+    // the hit effects of hit auras need to be on the weapons already, off_hand is nullptr for two-handers
+    void initialize(Weapon_state& main_hand_input, Weapon_state* off_hand_input,
                     Use_effects::Schedule& use_effects_schedule_input, Rage_manager* rage_manager_input);
 
     void reset(Sim_state& state);
 
+    // drops every buff (keeping the capacity), for a simulator that starts over. effects that link to a buff by index
+    //  have to be unlinked by the owner
+    void clear();
+
     void update_aura_uptimes(int current_time);
     [[nodiscard]] std::unordered_map<std::string, double> get_aura_uptimes_map() const;
 
@@ -107,36 +117,27 @@ public:
     void increment(Time_keeper& time_keeper, Logger& logger);
 
     void remove_charge(const Hit_effect& hit_effect, int current_time, Logger& logger);
+    void remove_charge(int combat_buff_idx, int current_time, Logger& logger);
 
-    void start_cooldown(const Hit_effect& hit_effect, int current_time) const
+    void start_cooldown(Weapon_state& weapon, size_t index, int current_time) const
     {
-        if (hit_effect.cooldown == 0) return;
+        const auto cooldown = weapon.weapon.hit_effects[index].cooldown;
+        if (cooldown == 0) return;
 
-        for (auto& hit_effect_mh : *hit_effects_mh)
-        {
-            if (hit_effect_mh.name == hit_effect.name)
-            {
-                hit_effect_mh.time_counter = current_time + hit_effect.cooldown;
-                break;
-            }
-        }
-        for (auto& hit_effect_oh : *hit_effects_oh)
+        weapon.ready_at[index] = current_time + cooldown;
+        const auto shared = weapon.shared_cooldown[index];
+        if (shared >= 0)
         {
-            if (hit_effect_oh.name == hit_effect.name)
-            {
-                hit_effect_oh.time_counter = current_time + hit_effect.cooldown;
-                break;
-            }
+            auto& other = &weapon == main_hand ? *off_hand : *main_hand;
+            other.ready_at[shared] = current_time + cooldown;
         }
     }
 
     void add_combat_buff(Hit_effect& hit_effect, int current_time);
-    void add_hit_aura(const std::string& name, Hit_effect& hit_effect, int duration, int current_time);
+    void add_combat_buff(const Hit_effect& hit_effect, int& combat_buff_idx, int current_time);
+    void add_hit_aura(const std::string& name, int duration, int current_time);
     void add_over_time_buff(Over_time_effect& over_time_effect, int current_time);
 
-    bool need_to_recompute_hit_tables{};
-    bool need_to_recompute_mitigation{};
-
 private:
     void increment_combat_buffs(int current_time, Logger& logger);
     void increment_over_time_buffs(int current_time, Logger& logger);
@@ -145,8 +146,9 @@ private:
 
     void do_fade_buff(Combat_buff& buff, Logger& logger);
 
-    void gain_stats(const Special_stats& ssb);
-    void do_add_combat_buff(Hit_effect& hit_effect, int current_time);
+    void gain_stats(const Combat_buff& buff);
+    void do_add_combat_buff(const Hit_effect& hit_effect, int combat_buff_idx, int current_time);
+    void set_hit_aura_ready(const Hit_aura& hit_aura, int ready_at);
     void do_add_over_time_buff(const Over_time_effect& over_time_effect, int current_time);
 
     Sim_state* sim_state{};
@@ -164,8 +166,8 @@ private:
     std::vector<Hit_aura> hit_auras{};
     int min_hit_aura{std::numeric_limits<int>::max()};
 
-    std::vector<Hit_effect>* hit_effects_mh{};
-    std::vector<Hit_effect>* hit_effects_oh{};
+    Weapon_state* main_hand{};
+    Weapon_state* off_hand{};
     Use_effects::Schedule use_effects_schedule{};
 };
 
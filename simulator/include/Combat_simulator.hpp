@@ -4,10 +4,13 @@
 #include "Buff_manager.hpp"
 #include "Character.hpp"
 #include "Config.hpp"
+#include "Control_variates.hpp"
 #include "Distribution.hpp"
+#include "Quantile_sketch.hpp"
 #include "Rage_manager.hpp"
 #include "damage_sources.hpp"
 #include "logger.hpp"
+#include "random_generator.hpp"
 #include "sim_state.hpp"
 #include "time_keeper.hpp"
 #include "weapon_sim.hpp"
@@ -16,8 +19,11 @@
 #include <array>
 #include <cassert>
 #include <cmath>
+#include <functional>
 #include <iomanip>
+#include <istream>
 #include <map>
+#include <ostream>
 #include <vector>
 
 class Combat_simulator : Rage_manager
@@ -44,6 +50,19 @@ public:
         ms_bt,
     };
 
+    // one fight of a run, replay_fight() runs it again
+    struct Fight_record
+    {
+        int batch{-1};
+        double dps{};
+    };
+
+    struct Fight_replay
+    {
+        double dps{};
+        std::string combat_log{};
+    };
+
     struct Ability_queue_manager
     {
         [[nodiscard]] bool is_ability_queued() const { return heroic_strike_queued || cleave_queued; }
@@ -137,19 +156,19 @@ public:
     class Hit_table
     {
     public:
-        Hit_table(std::string name, double miss, double dodge, double glance, double crit, const Damage_multipliers& dm)
-                : name_(std::move(name)), miss_(miss), dodge_(miss + dodge), glance_(miss + dodge + glance), crit_(miss + dodge + glance + crit), dm_(dm)
+        Hit_table(const char* name, double miss, double dodge, double glance, double crit, const Damage_multipliers& dm)
+                : name_(name), miss_(miss), dodge_(miss + dodge), glance_(miss + dodge + glance), crit_(miss + dodge + glance + crit), dm_(dm)
         {
         }
 
-        Hit_table() : name_(), miss_(0), dodge_(0), glance_(0), crit_(0), dm_() {}
+        Hit_table() : name_(""), miss_(0), dodge_(0), glance_(0), crit_(0), dm_() {}
 
         void alter_white_crit(double crit_delta) { crit_ += crit_delta; }
         void alter_yellow_crit(double crit_delta) { crit_ += (100 - dodge_) / 100 * crit_delta; }
 
-        [[nodiscard]] const std::string& name() const { return name_; }
+        [[nodiscard]] const char* name() const { return name_; }
 
-        [[nodiscard]] bool isMissOrDodge() const { return rand() * 100.0 / RAND_MAX < dodge_; }
+        [[nodiscard]] bool isMissOrDodge(double roll) const { return roll < dodge_; }
 
         [[nodiscard]] double miss() const { return miss_; }
         [[nodiscard]] double dodge() const { return dodge_ - miss_; }
@@ -159,9 +178,12 @@ public:
 
         [[nodiscard]] double glancing_penalty() const { return dm_.glance(); }
 
-        [[nodiscard]] Hit_outcome generate_hit(double damage) const
+        // roll is uniform in [0, 100). monotone reads the crit band from the top, after the plain hits, so the damage
+        //  grows with the roll. the chances stay the same, but a mirrored roll (antithetic batches) then lands on the
+        //  other end of the damage range, also when the regions below the plain hits cover more than half the table
+        [[nodiscard]] Hit_outcome generate_hit(double roll, double damage, bool monotone = false) const
         {
-            auto roll = rand() * 100.0 / RAND_MAX;
+            if (monotone && roll >= glance_) roll = glance_ + 100 - roll;
             if (roll < miss_) return {0, Hit_result::miss};
             if (roll < dodge_) return {0, Hit_result::dodge, damage * dm_.hit()};
             if (roll < glance_) return {damage * dm_.glance(), Hit_result::glancing};
@@ -169,7 +191,7 @@ public:
             return {damage * dm_.hit(), Hit_result::hit};
         }
     private:
-        std::string name_;
+        const char* name_; // string literal, keeps tables trivially copyable
 
         double miss_;
         double dodge_;
@@ -182,6 +204,14 @@ public:
 
     explicit Combat_simulator(const Combat_simulator_config& config);
 
+    // starts over with config as if newly constructed, the containers keep their capacity. many short runs on one
+    //  simulator save setting up (and allocating for) a new one every time
+    void reset(const Combat_simulator_config& new_config);
+
+    // this thread's own simulator, reset to config. it is shared by every caller on the thread, so it must not be held
+    //  across anything else that might use it - read out the results and let go
+    static Combat_simulator& pooled(const Combat_simulator_config& config);
+
     void gain_rage(double amount) final
     {
         rage_gained_ += amount;
@@ -218,22 +248,25 @@ public:
     [[nodiscard]] double get_rage() const final { return rage; }
 
     // TODO(vigo) turn us into hit effects :)
-    void maybe_gain_flurry(Hit_result hit_result, int& flurry_charges, Special_stats& special_stats) const;
-    void maybe_remove_flurry(int& flurry_charges, Special_stats& special_stats) const;
-    void maybe_add_rampage_stack(Hit_result hit_result, int& rampage_stacks, Special_stats& special_stats);
+    void maybe_gain_flurry(Hit_result hit_result, int& flurry_charges, Stat_accumulator& stats) const;
+    void maybe_remove_flurry(int& flurry_charges, Stat_accumulator& stats) const;
+    void maybe_add_rampage_stack(Hit_result hit_result, int& rampage_stacks, Stat_accumulator& stats);
     void unbridled_wrath(Sim_state& state, const Weapon_sim& weapon);
 
     void swing_main_hand(Sim_state& state, Extra_attack_chain chain = {});
     void swing_off_hand(Sim_state& state);
 
     // template helper for hit_effects()
-    template<typename ...Args> void on_proc(Hit_effect& hit_effect, Args&&... args) {
-        hit_effect.procs++;
-        buff_manager_.start_cooldown(hit_effect, time_keeper_.time);
+    template<typename ...Args> void on_proc(Weapon_state& weapon, size_t index, Args&&... args) {
+        weapon.procs[index]++;
+        buff_manager_.start_cooldown(weapon, index, time_keeper_.time);
         logger_.print(args...);
     }
 
-    void hit_effects(Sim_state& state, Hit_result hit_result, Weapon_sim& weapon, Hit_type hit_type = Hit_type::spell, Extra_attack_chain chain = {},
+    // the procs of a hit. extra attacks (and the procs of proc damage) it triggers are queued and only resolved once
+    //  the procs of the hit itself are through, in the order they were triggered. the outermost call works off the
+    //  queue, so a chain of extra attacks is a loop rather than a recursion
+    void hit_effects(Sim_state& state, Hit_result hit_result, Weapon_state& weapon, Hit_type hit_type = Hit_type::spell, Extra_attack_chain chain = {},
                     Special_type special_type = Special_type::none);
 
     void overpower(Sim_state& state);
@@ -257,15 +290,48 @@ public:
     void simulate(const Character& character, const std::function<bool(const Distribution&)>& target, bool log_data = false);
     void simulate(const Character& character, bool log_data = false);
 
+    // simulates batches [first_batch, first_batch + n_batches), without finalizing time lapse and histogram - used for chunks
+    void simulate(const Character& character, int first_batch, int n_batches, bool log_data = false);
+
+    // batch of config once more, on its own and with the combat log on. it is the same fight as in any run of config
+    //  (batches only depend on the seed and their index), with the same dps as its Fight_record
+    static Fight_replay replay_fight(const Combat_simulator_config& config, const Character& character, int batch);
+
+    // the hit at which yellow (and two-hand white) attacks against a target of that level stop missing
+    [[nodiscard]] static double yellow_hit_cap(int target_level);
+
+    // the same for dual wield white attacks, more hit than that is worth nothing
+    [[nodiscard]] static double dual_wield_hit_cap(int target_level) { return yellow_hit_cap(target_level) + dual_wield_miss; }
+
+    // runs config.n_batches in chunks on all threads, stopping early once config.target_precision is reached.
+    // chunks are merged in batch order, so the result does not depend on the number of threads
+    void simulate_parallel(const Character& character, bool log_data = false);
+
+    // the damage time lapses only add up for the same fight length, a simulator without one takes the other's
+    [[nodiscard]] bool can_merge(const Combat_simulator& other) const;
+
+    void merge(const Combat_simulator& other);
+
+    // everything merge() combines, as a compact binary blob. a simulator loaded from it only serves to be merged into
+    // another one or to be read out, e.g. the partial results of shards that ran in other processes
+    void save_results(std::ostream& os) const;
+    [[nodiscard]] bool load_results(std::istream& is);
+
+    [[nodiscard]] bool is_precision_reached() const;
+
     static Distribution simulate(const Combat_simulator_config& config, const Character& character);
 
+    // the dps the searched use effect schedule (search_use_effect_schedule) gains over the computed one, per fight.
+    //  both run the same config.n_batches fights, fight for fight on the same random stream
+    static Distribution schedule_search_gain(const Combat_simulator_config& config, const Character& character);
+
     void normal_phase(Sim_state& state, bool mh_swing);
     void execute_phase(Sim_state& state, bool mh_swing);
     void queue_next_melee();
 
     void update_swing_timers(Sim_state& state, double oldHaste);
 
-    static double get_uniform_random(double r_max) { return rand() * r_max / RAND_MAX; }
+    double get_uniform_random(double r_max) { return rng_.uniform(r_max); }
 
     [[nodiscard]] static double rage_generation(Sim_state& state, const Hit_outcome& hit_outcome, const Weapon_sim& weapon);
 
@@ -274,6 +340,21 @@ public:
     Hit_outcome generate_hit(Sim_state& state, const Weapon_sim& weapon, const Hit_table& hit_table, double damage,
                              bool boss_target = true, bool can_sweep = true);
 
+    // the base chances (in %) against a target of some level, before the character's stats
+    struct Level_table
+    {
+        double miss;
+        double hit_suppression;
+        double dodge;
+        double glance;
+        double glance_dr;
+        double crit_suppression;
+    };
+
+    static Level_table level_table(int target_level);
+
+    static constexpr double dual_wield_miss = 19.0; // on top of the miss chance, for white dual wield attacks
+
     void compute_hit_tables(const Character& character, const Special_stats& special_stats, const Weapon_sim& weapon);
 
     void add_talent_effects(const Character& character);
@@ -294,13 +375,21 @@ public:
 
     void add_damage_source_to_time_lapse(const std::vector<Damage_instance>& damage_instances);
 
-    [[nodiscard]] std::vector<std::string> get_aura_uptimes() const;
+    [[nodiscard]] std::vector<std::pair<std::string, double>> get_aura_uptimes() const;
 
-    [[nodiscard]] std::unordered_map<std::string, double> get_aura_uptimes_map() const { return buff_manager_.get_aura_uptimes_map(); }
+    [[nodiscard]] const std::unordered_map<std::string, double>& get_aura_uptimes_map() const { return aura_uptimes_; }
 
     [[nodiscard]] const std::unordered_map<std::string, int>& get_proc_data() const { return proc_data_; }
 
-    [[nodiscard]] std::vector<std::string> get_proc_statistics() const;
+    [[nodiscard]] std::vector<std::pair<std::string, double>> get_proc_statistics() const;
+
+    // the most extra hits queued behind a single triggering hit, over all fights
+    [[nodiscard]] int get_longest_hit_chain() const { return longest_hit_chain_; }
+
+    // extra hits are queued behind the hit that triggered them and the queue is emptied once that hit is through, so
+    //  this bounds the chain of each triggering hit, not the extra hits of a fight. a real chain is a handful of hits,
+    //  the bound only stops a runaway one
+    static constexpr size_t max_pending_hits = 32;
 
     void reset_time_lapse();
 
@@ -312,6 +401,28 @@ public:
 
     [[nodiscard]] const Distribution& get_dps_distribution() const { return dps_distribution_; }
 
+    // the error of the mean dps. the two fights of an antithetic pair aren't independent, with config.antithetic_batches
+    //  it's taken from the pair means instead
+    [[nodiscard]] double get_dps_std_of_the_mean() const;
+
+    [[nodiscard]] const Quantile_sketch& get_dps_sketch() const { return dps_sketch_; }
+
+    // the fights with the lowest ("min") and highest ("max") dps. after runs with log_data also those at the 5%, 50%
+    //  and 95% quantiles ("p5", "median", "p95"), those need the dps of every fight
+    [[nodiscard]] std::vector<std::pair<std::string, Fight_record>> get_notable_fights() const;
+
+    // the dps per fight regressed on the luck of that fight's crit, miss/dodge and proc rolls (see Roll_luck). same
+    //  mean, but a smaller error - with config.control_variates it also decides when target_precision is reached. with
+    //  config.antithetic_batches the samples are the pair means, so its error accounts for the twins' correlation
+    [[nodiscard]] const Control_variates& get_dps_control_variates() const { return dps_control_variates_; }
+
+    // dps per fight for each length of config.fight_length_sweep that fits into sim_time, recorded from the same
+    //  fights: damage up to the start of that length's execute phase, plus the execute phase dps of the full fight
+    //  times its execute phase duration. the second part ignores how the execute phase starts (cooldowns, rage), so
+    //  lengths close to sim_time are the most accurate
+    [[nodiscard]] const std::vector<double>& get_fight_lengths() const { return fight_lengths_; }
+    [[nodiscard]] const std::vector<Distribution>& get_fight_length_dps() const { return fight_length_dps_; }
+
     [[nodiscard]] double get_rage_lost_stance() const { return rage_lost_stance_swap_; }
     [[nodiscard]] double get_rage_lost_capped() const { return rage_lost_capped_; }
 
@@ -326,6 +437,8 @@ public:
 
     void init_histogram();
 
+    void add_to_histogram(double dps_sample);
+
     void prune_histogram();
 
     void normalize_timelapse();
@@ -349,6 +462,22 @@ private:
     [[nodiscard]] static int to_millis(double seconds) { return Time_keeper::to_millis(seconds); }
     [[nodiscard]] int from_offset(double offset) const { return time_keeper_.from_offset(offset); }
 
+    void run_batches(const Character& character, const std::function<bool(const Distribution&)>& target, int first_batch, bool log_data);
+
+    // hit_effects() without working off the queue
+    void proc_hit_effects(Sim_state& state, Hit_result hit_result, Weapon_state& weapon, Hit_type hit_type,
+                          Extra_attack_chain chain, Special_type special_type);
+
+    struct Pending_hit
+    {
+        bool extra_attack{};  // a main hand swing with chain, otherwise the procs of proc damage that hit_result
+        Extra_attack_chain chain{};
+        Hit_result hit_result{};
+    };
+
+    // the hit is lost if the queue is full
+    void queue_hit(const Pending_hit& pending_hit);
+
     Hit_table hit_table_white_mh_{};
     Hit_table hit_table_white_oh_{};
     Hit_table hit_table_yellow_mh_{};
@@ -358,6 +487,12 @@ private:
 
     Special_stats compute_hit_table_stats_{};
 
+    // the stats the hit tables and the armor mitigation depend on, anything else changing doesn't trigger a rebuild
+    static constexpr Stat_mask hit_table_inputs =
+        stat_mask(Stat_field::critical_strike, Stat_field::hit, Stat_field::expertise, Stat_field::sword_expertise,
+                  Stat_field::mace_expertise, Stat_field::axe_expertise, Stat_field::crit_multiplier);
+    static constexpr Stat_mask mitigation_inputs = stat_mask(Stat_field::gear_armor_pen);
+
     Time_keeper time_keeper_{};
     Buff_manager buff_manager_{};
     Ability_queue_manager ability_queue_manager{};
@@ -365,6 +500,7 @@ private:
     double rage{};
 
     Logger logger_{};
+    Random_generator rng_{};
 
     // config related
     double armor_reduction_factor_{};
@@ -382,7 +518,8 @@ private:
     int bloodthirst_rage_cost_{};
     int tactical_mastery_rage_{};
 
-    Special_stats flurry_{};
+    Stat_delta flurry_{};
+    const Stat_delta rampage_stack_{Special_stats{0, 0, 50}};
 
     bool deep_wounds_{};
     bool use_bloodthirst_{};
@@ -410,6 +547,26 @@ private:
     // statistics
     Damage_sources damage_distribution_{};
     Distribution dps_distribution_{};
+    Distribution antithetic_pair_dps_{}; // pairs split between two simulators (chunks, shards) are left out
+    Quantile_sketch dps_sketch_{};
+    Fight_record min_fight_{};
+    Fight_record max_fight_{};
+    int first_fight_{};                // batch of fight_dps_[0]
+    std::vector<double> fight_dps_{}; // only with log_data, and only while merges come in batch order
+
+    // observed minus expected outcomes of the rolls in a fight. every roll adds zero on average, whatever happened
+    //  before it, so these are zero-mean - but a lucky fight shows in them as much as in the dps
+    struct Roll_luck
+    {
+        double crits{};
+        double avoided{}; // misses and dodges
+        double extra_attacks{};
+        double procs{};
+    };
+    Roll_luck roll_luck_{};
+    Control_variates dps_control_variates_{4};
+    std::vector<double> fight_lengths_{};
+    std::vector<Distribution> fight_length_dps_{};
 
     double flurry_uptime_{};
     double oh_queued_uptime_{};
@@ -424,6 +581,9 @@ private:
     double avg_rage_spent_executing_{};
 
     std::unordered_map<std::string, int> proc_data_{};
+    std::unordered_map<std::string, double> aura_uptimes_{}; // total seconds over all batches
+
+    static constexpr int batches_per_chunk = 500;
 
     static constexpr int time_lapse_resolution = 500; // time lapse bucket size (in ms)
     static constexpr int histogram_dps_resolution = 20; // histogram bucket size (in dps)
@@ -432,6 +592,12 @@ private:
     std::vector<int> hist_x{};
     std::vector<int> hist_y{};
 
+    std::vector<Damage_instance> damage_instances_{};
+
+    std::vector<Pending_hit> pending_hits_{};
+    bool resolving_pending_hits_{};
+    int longest_hit_chain_{};
+
     bool has_run{}; // TODO(vigo) remove me soonish
 };
 
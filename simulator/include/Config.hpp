@@ -3,17 +3,37 @@
 
 #include "sim_input.hpp"
 #include "string_helpers.hpp"
-#include "find_values.hpp"
+#include "option_index.hpp"
 #include "time_keeper.hpp"
 
+#include <vector>
+
+// a part of the fight with adds up, without anything to attack, or with an add as the main target
+struct Encounter_window
+{
+    enum class Type
+    {
+        adds,
+        downtime,
+        target_switch,
+    };
+
+    Type type{};
+    double start{}; // s
+    double end{};
+    int count{}; // adds only
+};
+
 struct Combat_simulator_config
 {
     Combat_simulator_config() = default;
 
     explicit Combat_simulator_config(const Sim_input& input);
 
-    template <typename T>
-    void parse_combat_simulator_config(const T& input);
+    // reads its options through the job's index, which then knows them
+    Combat_simulator_config(const Sim_input& input, Option_index& options);
+
+    void parse_combat_simulator_config(Option_index& options);
 
     //void set_display_histogram(bool display_histogram_input) { display_histogram = display_histogram_input; }
     //void set_display_time_lapse(bool display_time_lapse_input) { display_time_lapse = display_time_lapse_input; }
@@ -22,6 +42,12 @@ struct Combat_simulator_config
 
     int n_batches{};
 
+    // stop early once the 95% confidence interval of the mean dps is within +- target_precision (0: run all n_batches)
+    double target_precision{};
+    bool control_variates{}; // judge target_precision by the control variate estimate of the mean
+    bool antithetic_batches{}; // run the batches in pairs, the second one with mirrored uniforms
+    int n_threads{}; // 0: one per hardware thread
+
     bool display_combat_debug{};
     //bool display_histogram{};
     //bool display_time_lapse{};
@@ -29,6 +55,10 @@ struct Combat_simulator_config
 
     double sim_time{};
 
+    // fight lengths (s, ascending) to also report the dps for. they're recorded from the same fights, as long as
+    //  they don't exceed sim_time (cp. Combat_simulator::get_fight_length_dps)
+    std::vector<double> fight_length_sweep{};
+
     int main_target_level{};
     int main_target_initial_armor_{};
 
@@ -49,6 +79,11 @@ struct Combat_simulator_config
 
     double execute_phase_percentage_{};
 
+    // on top of the settings above (cp. compile_encounter). adds fight like the extra targets of multi target mode,
+    //  and a target switch puts an add with extra_target_initial_armor_ in place of the boss
+    std::vector<Encounter_window> encounter_windows{};
+    static constexpr int max_encounter_windows = 4; // of each type
+
     double initial_rage{};
     int sunder_armor_globals_{};
 
@@ -65,6 +100,7 @@ struct Combat_simulator_config
     bool enable_extra_bloodlust{};
     double extra_bloodlust_count_{};
     bool reverse_cooldown{};
+    bool search_use_effect_schedule{};
 
     bool enable_unleashed_rage{};
     double unleashed_rage_start_{};
@@ -134,6 +170,4 @@ struct Combat_simulator_config
     } dpr_settings;
 };
 
-#include "Config.tcc"
-
 #endif
@@ -12,6 +12,11 @@ public:
     static Schedule compute_schedule(std::vector<Use_effect>& use_effects, const Special_stats& special_stats,
                                      int sim_time, double ap, bool reverse_cooldown = false);
 
+    // searches for better activation times on a timeline of step ms, starting from a computed schedule. Uses a simple model
+    //  of the damage done, keeps the cooldowns and the lockout of shared effects, and adds activations where they fit
+    static void optimize_schedule(Schedule& schedule, const Special_stats& special_stats, int sim_time, double total_ap,
+                                  int step = 1000);
+
     static double get_use_effect_ap_equivalent(const Use_effect& use_effect, const Special_stats& special_stats, double total_ap,
                                                int sim_time);
 
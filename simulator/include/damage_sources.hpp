@@ -1,13 +1,14 @@
 #ifndef WOW_SIMULATOR_DAMAGE_SOURCES_HPP
 #define WOW_SIMULATOR_DAMAGE_SOURCES_HPP
 
-#include <string>
-#include <vector>
+#include <array>
 #include <cassert>
+#include <cstddef>
+#include <ostream>
 
 enum class Damage_source
 {
-    white_mh, // order is important, cp. damage_names
+    white_mh, // order is important, cp. damage_source_names
     white_oh,
     bloodthirst,
     execute,
@@ -24,6 +25,11 @@ enum class Damage_source
     size, // convenience ;)
 };
 
+constexpr size_t n_damage_sources = static_cast<size_t>(Damage_source::size);
+
+// Display names, indexed by Damage_source. New sources only need an enum entry and a name here.
+extern const std::array<const char*, n_damage_sources> damage_source_names;
+
 struct Damage_instance
 {
     Damage_instance(Damage_source source, double damage, int time_stamp)
@@ -38,53 +44,52 @@ std::ostream& operator<<(std::ostream& os, Damage_source damage_source);
 
 struct Damage_sources
 {
-    Damage_sources& operator+(const Damage_sources& rhs);
+    Damage_sources& operator+=(const Damage_sources& rhs)
+    {
+        for (size_t i = 0; i < n_damage_sources; ++i)
+        {
+            damage[i] += rhs.damage[i];
+        }
+        for (size_t i = 0; i < n_damage_sources; ++i)
+        {
+            counts[i] += rhs.counts[i];
+        }
+        return *this;
+    }
 
     [[nodiscard]] double sum_damage_sources() const
     {
-        return white_mh_damage + white_oh_damage + bloodthirst_damage + mortal_strike_damage + slam_damage +
-               overpower_damage + heroic_strike_damage + cleave_damage + whirlwind_damage + hamstring_damage +
-               execute_damage + deep_wounds_damage + item_hit_effects_damage + sweeping_strikes_damage;
+        double sum = 0.0;
+        for (double d : damage)
+        {
+            sum += d;
+        }
+        return sum;
     }
 
     [[nodiscard]] int sum_counts() const
     {
-        return white_mh_count + white_oh_count + bloodthirst_count + mortal_strike_count + slam_count +
-               overpower_count + heroic_strike_count + cleave_count + whirlwind_count + hamstring_count +
-               execute_count + deep_wounds_count + item_hit_effects_count + sweeping_strikes_count;
+        int sum = 0;
+        for (int c : counts)
+        {
+            sum += c;
+        }
+        return sum;
+    }
+
+    void add_damage(Damage_source source, double damage_value)
+    {
+        assert(source < Damage_source::size);
+        damage[static_cast<size_t>(source)] += damage_value;
+        counts[static_cast<size_t>(source)]++;
     }
 
-    void add_damage(Damage_source source, double damage);
+    [[nodiscard]] double get_damage(Damage_source source) const { return damage[static_cast<size_t>(source)]; }
 
-    double white_mh_damage{};
-    double white_oh_damage{};
-    double slam_damage{};
-    double overpower_damage{};
-    double bloodthirst_damage{};
-    double mortal_strike_damage{};
-    double sweeping_strikes_damage{};
-    double execute_damage{};
-    double heroic_strike_damage{};
-    double cleave_damage{};
-    double whirlwind_damage{};
-    double hamstring_damage{};
-    double deep_wounds_damage{};
-    double item_hit_effects_damage{};
+    [[nodiscard]] int get_count(Damage_source source) const { return counts[static_cast<size_t>(source)]; }
 
-    int white_mh_count{};
-    int white_oh_count{};
-    int slam_count{};
-    int overpower_count{};
-    int bloodthirst_count{};
-    int mortal_strike_count{};
-    int sweeping_strikes_count{};
-    int execute_count{};
-    int heroic_strike_count{};
-    int cleave_count{};
-    int whirlwind_count{};
-    int hamstring_count{};
-    int deep_wounds_count{};
-    int item_hit_effects_count{};
+    std::array<double, n_damage_sources> damage{};
+    std::array<int, n_damage_sources> counts{};
 };
 
 #endif // WOW_SIMULATOR_DAMAGE_SOURCES_HPP
@@ -0,0 +1,32 @@
+#ifndef WOW_SIMULATOR_ENCOUNTER_HPP
+#define WOW_SIMULATOR_ENCOUNTER_HPP
+
+#include "Config.hpp"
+
+#include <vector>
+
+// What happens in a fight at fixed times, whatever the warrior does: the delayed armor debuff landing, adds coming
+// and going, the boss being out of reach or swapped for an add, the execute phase. compile_encounter() turns the
+// config into one time-sorted list per run, the fight loop then only compares the time against the next event
+// instead of checking every condition on every step.
+struct Encounter_event
+{
+    enum class Type
+    {
+        armor_reduction, // improved expose armor
+        execute_phase,
+        extra_targets,   // value: adds arriving (> 0) or leaving (< 0)
+        downtime_start,  // nothing to attack until the matching downtime_end
+        downtime_end,
+        target_switch_start, // an add is the main target until the matching target_switch_end
+        target_switch_end,
+    };
+
+    int time; // ms. an event applies at the first step of the fight at or after it
+    Type type;
+    int value{};
+};
+
+std::vector<Encounter_event> compile_encounter(const Combat_simulator_config& config);
+
+#endif // WOW_SIMULATOR_ENCOUNTER_HPP
@@ -0,0 +1,80 @@
+#ifndef WOW_SIMULATOR_RANDOM_GENERATOR_HPP
+#define WOW_SIMULATOR_RANDOM_GENERATOR_HPP
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+// xoshiro256** seeded via splitmix64. Every (seed, stream) pair gives its own reproducible sequence, so each
+// batch can draw from a stream derived from its index - no matter which thread (or process) ends up running it.
+// The antithetic twin of a stream mirrors its uniforms (u becomes 1 - u), the raw numbers stay the same.
+class Random_generator
+{
+public:
+    using result_type = uint64_t;
+
+    Random_generator() { seed(0, 0); }
+
+    Random_generator(uint64_t seed_value, uint64_t stream) { seed(seed_value, stream); }
+
+    void seed(uint64_t seed_value, uint64_t stream, bool antithetic = false)
+    {
+        antithetic_ = antithetic;
+        uint64_t x = (seed_value << 32u) ^ stream;
+        for (auto& s : state_)
+        {
+            s = splitmix64(x);
+        }
+    }
+
+    result_type operator()()
+    {
+        const uint64_t result = rotl(state_[1] * 5, 7) * 9;
+        const uint64_t t = state_[1] << 17u;
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+        state_[2] ^= t;
+        state_[3] = rotl(state_[3], 45);
+        return result;
+    }
+
+    static constexpr result_type min() { return std::numeric_limits<result_type>::min(); }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    // uniform in [0, r_max)
+    double uniform(double r_max)
+    {
+        auto bits = operator()() >> 11u;
+        if (antithetic_) bits = (uint64_t{1} << 53u) - 1 - bits;
+        return static_cast<double>(bits) * 0x1.0p-53 * r_max;
+    }
+
+    // Fisher-Yates; std::shuffle is implementation defined, this gives the same order on every platform
+    template <typename Iterator>
+    void shuffle(Iterator first, Iterator last)
+    {
+        for (auto i = last - first - 1; i > 0; --i)
+        {
+            auto j = static_cast<decltype(i)>(operator()() % static_cast<uint64_t>(i + 1));
+            std::swap(first[i], first[j]);
+        }
+    }
+
+private:
+    static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+
+    static uint64_t splitmix64(uint64_t& x)
+    {
+        uint64_t z = (x += 0x9E3779B97F4A7C15u);
+        z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9u;
+        z = (z ^ (z >> 27u)) * 0x94D049BB133111EBu;
+        return z ^ (z >> 31u);
+    }
+
+    uint64_t state_[4]{};
+    bool antithetic_{};
+};
+
+#endif // WOW_SIMULATOR_RANDOM_GENERATOR_HPP
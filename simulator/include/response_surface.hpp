@@ -0,0 +1,72 @@
+#ifndef WOW_SIMULATOR_RESPONSE_SURFACE_HPP
+#define WOW_SIMULATOR_RESPONSE_SURFACE_HPP
+
+#include "Combat_simulator.hpp"
+#include "stat_accumulator.hpp"
+
+#include <optional>
+#include <string>
+#include <vector>
+
+// One stat that is swept, in the units of Special_stats (hit and crit in %, haste as a fraction, arpen as armor)
+struct Stat_axis
+{
+    std::string name;
+    Stat_field field;
+    double min;
+    double max;
+    int levels; // only used by the grid design
+};
+
+// "hit", "crit", "expertise", "haste", "arpen" and "ap", the same names the stat weights use
+std::optional<Stat_field> stat_axis_field(const std::string& name);
+
+// Sweeps some Special_stats fields over a design of points, simulates every point on the same batches (common random
+// numbers, so differences between points are not drowned in the noise of the fights) and fits a full quadratic
+// surface, dps ~ b0 + sum_i b_i x_i + sum_i<=j b_ij x_i x_j, on the axes scaled to [-1, 1].
+class Response_surface
+{
+public:
+    struct Point
+    {
+        std::vector<double> x;
+        double dps;
+        double std_of_the_mean;
+    };
+
+    explicit Response_surface(std::vector<Stat_axis> axes);
+
+    // every combination of the axis levels
+    [[nodiscard]] std::vector<std::vector<double>> grid_design() const;
+
+    // n_points points, each axis split into n_points strata and every stratum used exactly once
+    [[nodiscard]] std::vector<std::vector<double>> latin_hypercube_design(int n_points, uint64_t seed) const;
+
+    // simulates the points in parallel and fits the surface. the character's other stats are left as they are
+    void run(const Combat_simulator_config& config, const Character& character,
+             const std::vector<std::vector<double>>& design);
+
+    [[nodiscard]] double predict(const std::vector<double>& x) const;
+
+    [[nodiscard]] const std::vector<Point>& points() const { return points_; }
+    [[nodiscard]] const std::vector<double>& coefficients() const { return coefficients_; }
+    [[nodiscard]] const std::vector<double>& standard_errors() const { return standard_errors_; }
+
+    // "1", "hit", "crit", "hit*crit", ... in the order of coefficients()
+    [[nodiscard]] std::vector<std::string> term_names() const;
+
+    // one row per simulated point with the fitted value next to the simulated one
+    [[nodiscard]] std::string to_csv() const;
+
+    [[nodiscard]] std::string to_json() const;
+
+private:
+    [[nodiscard]] std::vector<double> terms(const std::vector<double>& x) const;
+
+    std::vector<Stat_axis> axes_;
+    std::vector<Point> points_{};
+    std::vector<double> coefficients_{};
+    std::vector<double> standard_errors_{};
+};
+
+#endif // WOW_SIMULATOR_RESPONSE_SURFACE_HPP
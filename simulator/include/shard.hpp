@@ -0,0 +1,36 @@
+#ifndef WOW_SIMULATOR_SHARD_HPP
+#define WOW_SIMULATOR_SHARD_HPP
+
+#include "Combat_simulator.hpp"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+// A job of n_batches split into shards that can run in separate processes. Batches draw their random numbers from
+// (seed, batch index) only, so a shard gives the same result wherever and however often it runs, and merging all
+// shards in batch order gives the same result as one process running simulate_parallel over the whole job.
+struct Shard_header
+{
+    static constexpr uint32_t magic = 0x44485357; // "WSHD"
+    static constexpr uint32_t version = 5;
+
+    int seed{};
+    int first_batch{};
+    int n_batches{};
+    int total_batches{}; // of the whole job, so a merge can tell which shards are missing
+};
+
+// batches of shard shard_index out of shard_count, the first shards get one more batch if it doesn't divide evenly
+Shard_header shard_range(int seed, int total_batches, int shard_index, int shard_count);
+
+// runs the batches of the shard and writes the partial results to path
+bool run_shard(const Combat_simulator_config& config, const Character& character, const Shard_header& shard,
+               const std::string& path);
+
+bool write_shard(const std::string& path, const Shard_header& shard, const Combat_simulator& results);
+
+// loads the partial results of a shard file into results (a fresh simulator). empty if the file is missing or broken
+std::optional<Shard_header> read_shard(const std::string& path, Combat_simulator& results);
+
+#endif // WOW_SIMULATOR_SHARD_HPP
@@ -3,16 +3,19 @@
 
 #include "weapon_sim.hpp"
 #include "Character.hpp"
+#include "stat_accumulator.hpp"
 
 struct Sim_state
 {
-    Sim_state(Weapon_sim& main_hand_weapon, Weapon_sim& off_hand_weapon, bool is_dual_wield,
+    Sim_state(Weapon_state& main_hand, Weapon_state& off_hand, bool is_dual_wield,
               Special_stats special_stats, const Character::talents_t& talents,
               std::vector<Damage_instance>& damage_instances, bool log_damage_instances) :
-        main_hand_weapon(main_hand_weapon),
-        off_hand_weapon(off_hand_weapon),
+        main_hand(main_hand),
+        off_hand(off_hand),
+        main_hand_weapon(main_hand.weapon),
+        off_hand_weapon(off_hand.weapon),
         is_dual_wield(is_dual_wield),
-        special_stats(special_stats),
+        stats(special_stats),
         talents(talents),
         damage_sources(),
         damage_instances(damage_instances),
@@ -23,10 +26,12 @@ struct Sim_state
         if (log_damage_instances) damage_instances.clear();
     }
 
-    Weapon_sim& main_hand_weapon;
-    Weapon_sim& off_hand_weapon;
+    Weapon_state& main_hand;
+    Weapon_state& off_hand;
+    const Weapon_sim& main_hand_weapon;
+    const Weapon_sim& off_hand_weapon;
     const bool is_dual_wield;
-    Special_stats special_stats;
+    Stat_accumulator stats;
     const Character::talents_t& talents;
     Damage_sources damage_sources;
     std::vector<Damage_instance>& damage_instances;
@@ -34,6 +39,8 @@ struct Sim_state
     int flurry_charges;
     int rampage_stacks;
 
+    [[nodiscard]] const Special_stats& special_stats() const { return stats.get(); }
+
     void add_damage(Damage_source source, double damage, int current_time)
     {
         damage_sources.add_damage(source, damage);
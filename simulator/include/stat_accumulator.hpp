@@ -0,0 +1,114 @@
+#ifndef WOW_SIMULATOR_STAT_ACCUMULATOR_HPP
+#define WOW_SIMULATOR_STAT_ACCUMULATOR_HPP
+
+#include "Attributes.hpp"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+enum class Stat_field : uint8_t
+{
+    critical_strike, // order as in Special_stats
+    hit,
+    attack_power,
+    bonus_attack_power,
+    haste,
+    damage_mod_physical,
+    stat_multiplier,
+    bonus_damage,
+    crit_multiplier,
+    spell_crit,
+    damage_mod_spell,
+    expertise,
+    sword_expertise,
+    mace_expertise,
+    axe_expertise,
+    gear_armor_pen,
+    ap_multiplier,
+    attack_speed,
+    size,
+};
+
+constexpr size_t n_stat_fields = static_cast<size_t>(Stat_field::size);
+
+using Stat_mask = uint32_t;
+
+constexpr Stat_mask stat_mask(Stat_field field) { return Stat_mask{1} << static_cast<unsigned>(field); }
+
+template <typename... Fields>
+constexpr Stat_mask stat_mask(Stat_field field, Fields... fields)
+{
+    return stat_mask(field) | stat_mask(fields...);
+}
+
+// The non-zero fields of a Special_stats, built once per buff so that gaining or losing it only touches those fields
+struct Stat_delta
+{
+    struct Entry
+    {
+        Stat_field field;
+        double value;
+    };
+
+    Stat_delta() = default;
+
+    explicit Stat_delta(const Special_stats& special_stats);
+
+    [[nodiscard]] bool empty() const { return entries.empty(); }
+
+    std::vector<Entry> entries{};
+};
+
+// Keeps the additive (sums) and multiplicative (products) parts of all active buffs apart, and materializes them into
+// a Special_stats on top of the starting stats. Removing a buff undoes its own contribution instead of re-composing
+// all fields, and a field snaps back to its starting value once nothing modifies it anymore, so there is no drift
+// over long fights.
+class Stat_accumulator
+{
+public:
+    Stat_accumulator() = default;
+
+    explicit Stat_accumulator(const Special_stats& base) { reset(base); }
+
+    void reset(const Special_stats& base);
+
+    void add(const Stat_delta& delta, int stacks = 1);
+
+    void remove(const Stat_delta& delta, int stacks = 1);
+
+    [[nodiscard]] const Special_stats& get() const { return stats_; }
+
+    // true if any of the fields in mask changed since the last call, the bits are cleared. Lets dependent state
+    // (hit tables, armor mitigation) be rebuilt only when its own inputs changed.
+    [[nodiscard]] bool take_dirty(Stat_mask mask)
+    {
+        const bool dirty = (dirty_ & mask) != 0;
+        dirty_ &= ~mask;
+        return dirty;
+    }
+
+    [[nodiscard]] static double value_of(const Special_stats& special_stats, Stat_field field);
+
+    static void set_value(Special_stats& special_stats, Stat_field field, double value);
+
+private:
+    [[nodiscard]] static bool is_multiplicative(Stat_field field)
+    {
+        return field == Stat_field::damage_mod_physical || field == Stat_field::stat_multiplier ||
+               field == Stat_field::crit_multiplier || field == Stat_field::damage_mod_spell ||
+               field == Stat_field::ap_multiplier || field == Stat_field::attack_speed;
+    }
+
+    [[nodiscard]] double multiplied(Stat_field field) const;
+
+    void update(Stat_field field);
+
+    Special_stats base_{};
+    Special_stats stats_{};
+    std::array<double, n_stat_fields> components_{}; // sum for additive fields, product for multiplicative ones
+    std::array<int, n_stat_fields> active_{};
+    Stat_mask dirty_{};
+};
+
+#endif // WOW_SIMULATOR_STAT_ACCUMULATOR_HPP
@@ -0,0 +1,37 @@
+#ifndef WOW_SIMULATOR_STAT_GRADIENT_HPP
+#define WOW_SIMULATOR_STAT_GRADIENT_HPP
+
+#include "Combat_simulator.hpp"
+
+#include <vector>
+
+// how far a delta can be stepped up and down from special_stats, as fractions of it in [0, 1]. no stat may go below
+//  zero, and hit may not cross the yellow or dual wield hit cap of the target, where its gain drops off. at or above a
+//  cap only the step up is left, so past the last one the gain found is nothing
+struct Stat_step
+{
+    double up{1};
+    double down{1};
+};
+
+Stat_step stat_step(const Combat_simulator_config& config, const Special_stats& special_stats, const Special_stats& delta);
+
+// the dps gained by each of the deltas, in the order they were given, with the standard errors of the fit
+struct Stat_gradient
+{
+    std::vector<double> gains;
+    std::vector<double> standard_errors;
+};
+
+// The gains of several stat changes from a single set of fights. The fights are split into design rows, and in every
+// row each delta is added or subtracted with a random sign. Every row is simulated twice, once as is and once with all
+// signs flipped, on the same batches (common random numbers), so half the paired dps difference is
+// sum_j sign_j * dps_gain_j with the noise of the fights themselves mostly cancelled, and with curvature cancelled as
+// well since it is a central difference. Regressing those differences on the signs gives every gain at once, with a
+// standard error, for about the cost of simulating config.n_batches fights of the character.
+// Near a bound a delta is only stepped as far as stat_step allows, and its gain scaled back up to the full delta. A
+// step that is cut on one side only is no longer central, so the curvature of that stat isn't cancelled there.
+Stat_gradient simulate_stat_gradient(const Combat_simulator_config& config, const Character& character,
+                                     const std::vector<Special_stats>& deltas);
+
+#endif // WOW_SIMULATOR_STAT_GRADIENT_HPP
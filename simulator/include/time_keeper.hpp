@@ -37,8 +37,8 @@ public:
         time = prepare_time;
     }
 
-    [[nodiscard]] int get_next_event(int next_mh_swing, int next_oh_swing,
-                                     int next_buff_event, int next_slam_finish, int sim_time) const
+    [[nodiscard]] int get_next_event(int next_mh_swing, int next_oh_swing, int next_buff_event,
+                                     int next_encounter_event, int next_slam_finish, int sim_time) const
     {
         int next_event = std::numeric_limits<int>::max();
         if (overpower_cd_ > time && overpower_cd_ < next_event) next_event = overpower_cd_;
@@ -52,6 +52,7 @@ public:
         if (next_oh_swing > time && next_oh_swing < next_event) next_event = next_oh_swing;
         if (next_slam_finish > time && next_slam_finish < next_event) next_event = next_slam_finish;
         if (next_buff_event < next_event) next_event = next_buff_event;
+        if (next_encounter_event < next_event) next_event = next_encounter_event;
         if (sim_time < next_event) next_event = sim_time;
         return next_event;
     }
@@ -2,6 +2,10 @@
 #define WOW_SIMULATOR_WEAPON_SIM_HPP
 
 #include "Item.hpp"
+#include "random_generator.hpp"
+
+#include <array>
+#include <vector>
 
 class Weapon_sim
 {
@@ -24,12 +28,69 @@ public:
 
     double swing_speed;
     double normalized_swing_speed;
-    int next_swing;
     double average_damage;
     Socket socket;
     Weapon_type weapon_type;
     Weapon_socket weapon_socket;
-    std::vector<Hit_effect> hit_effects;
+    std::vector<Hit_effect> hit_effects; // complete before the first fight, read-only from then on
+};
+
+// a hit effect that a hit result can touch
+struct Proc_candidate
+{
+    size_t index; // in Weapon_sim::hit_effects
+    bool procs;   // false: only loses a charge (darkmoon_card_wrath)
+};
+
+// The part of a wielded weapon that changes while simulating. Weapon_sim stays untouched, so any number of these
+// can share one. Hit effects are referred to by their index in Weapon_sim::hit_effects
+struct Weapon_state
+{
+    explicit Weapon_state(const Weapon_sim& weapon);
+
+    // before every fight: swing timer and cooldowns back to 0, and a new proc order
+    void reset(Random_generator& rng);
+
+    // the hit effects to check for a hit result, in the proc order of the current fight
+    [[nodiscard]] const std::vector<Proc_candidate>& candidates(Hit_result hit_result) const
+    {
+        return candidates_[slot(hit_result)];
+    }
+
+    const Weapon_sim& weapon;
+
+    int next_swing{};
+    std::vector<int> ready_at{}; // cooldown end per hit effect
+
+    // kept over all fights
+    std::vector<double> proc_chance{}; // per hit effect, with ppm already turned into a chance per swing
+    std::vector<int> procs{};
+    std::vector<int> combat_buff_idx{}; // -1 until the hit effect first added its buff
+    std::vector<int> shared_cooldown{}; // index of the same hit effect on the other weapon, or -1
+
+private:
+    static constexpr size_t slot(Hit_result hit_result)
+    {
+        switch (hit_result)
+        {
+        case Hit_result::miss:
+            return 1;
+        case Hit_result::dodge:
+            return 2;
+        case Hit_result::glancing:
+            return 3;
+        case Hit_result::crit:
+            return 4;
+        case Hit_result::hit:
+            return 5;
+        default:
+            return 0;
+        }
+    }
+
+    std::vector<size_t> name_order_{};
+    std::vector<size_t> order_{}; // in which order the hit effects are checked for procs
+    std::array<std::vector<Proc_candidate>, 6> candidates_{}; // per slot(), rebuilt with the proc order
 };
 
 #endif // WOW_SIMULATOR_WEAPON_SIM_HPP
@@ -4,30 +4,59 @@
 
 #include <algorithm>
 
-void Buff_manager::initialize(std::vector<Hit_effect>& hit_effects_mh_input, std::vector<Hit_effect>& hit_effects_oh_input,
+void Buff_manager::initialize(Weapon_state& main_hand_input, Weapon_state* off_hand_input,
                 Use_effects::Schedule& use_effects_schedule_input, Rage_manager* rage_manager_input)
 {
-    hit_effects_mh = &hit_effects_mh_input;
-    hit_effects_oh = &hit_effects_oh_input;
+    main_hand = &main_hand_input;
+    off_hand = off_hand_input;
 
     use_effects_schedule = use_effects_schedule_input;
 
     rage_manager = rage_manager_input;
-}
 
-void Buff_manager::reset(Sim_state& state)
-{
-    sim_state = &state;
+    auto find_index = [](const Weapon_state* weapon, const std::string& name) {
+        if (weapon == nullptr) return -1;
+        const auto& hit_effects = weapon->weapon.hit_effects;
+        auto it = std::find_if(hit_effects.begin(), hit_effects.end(), [&name](auto& he) { return he.name == name; });
+        return it == hit_effects.end() ? -1 : static_cast<int>(it - hit_effects.begin());
+    };
 
-    for (auto& he : *hit_effects_mh)
+    // effects with the same name share their cooldown between the weapons, resolve that once instead of on every proc
+    for (size_t i = 0; i < main_hand->weapon.hit_effects.size(); ++i)
     {
-        he.time_counter = 0;
+        const auto oh_index = find_index(off_hand, main_hand->weapon.hit_effects[i].name);
+        main_hand->shared_cooldown[i] = oh_index;
+        if (oh_index >= 0) off_hand->shared_cooldown[oh_index] = static_cast<int>(i);
     }
 
-    for (auto& he : *hit_effects_oh)
+    hit_auras.clear();
+    for (const auto& scheduled : use_effects_schedule)
     {
-        he.time_counter = 0;
+        const auto& use_effect = scheduled.second.get();
+        if (use_effect.hit_effects.empty()) continue;
+        if (std::any_of(hit_auras.begin(), hit_auras.end(), [&use_effect](auto& ha) { return ha.name == use_effect.name; })) continue;
+
+        const auto mh_index = find_index(main_hand, use_effect.name);
+        assert(mh_index >= 0);
+        hit_auras.emplace_back(use_effect.name, mh_index, find_index(off_hand, use_effect.name));
     }
+}
+
+void Buff_manager::clear()
+{
+    combat_buffs.clear();
+    over_time_buffs.clear();
+    hit_auras.clear();
+    min_combat_buff = std::numeric_limits<int>::max();
+    min_over_time_buff = std::numeric_limits<int>::max();
+    min_hit_aura = std::numeric_limits<int>::max();
+    min_use_effect = std::numeric_limits<int>::max();
+    use_effect_index = 0;
+}
+
+void Buff_manager::reset(Sim_state& state)
+{
+    sim_state = &state;
 
     for (auto& buff : combat_buffs)
     {
@@ -44,26 +73,13 @@ void Buff_manager::reset(Sim_state& state)
 
     for (auto& hit_aura : hit_auras)
     {
-        // update hit effect pointers, since hit_effects are permutated now
-        auto mh = std::find_if(hit_effects_mh->begin(), hit_effects_mh->end(), [&hit_aura](auto& he) { return he.name == hit_aura.name; });
-        assert(mh != hit_effects_mh->end());
-        hit_aura.hit_effect_mh = &(*mh);
-
-        auto oh = std::find_if(hit_effects_oh->begin(), hit_effects_oh->end(), [&hit_aura](auto& he) { return he.name == hit_aura.name; });
-        assert(oh != hit_effects_oh->end());
-        hit_aura.hit_effect_oh = &(*oh);
-
         hit_aura.next_fade = Hit_aura::inactive;
-        hit_aura.hit_effect_mh->time_counter = std::numeric_limits<int>::max();
-        hit_aura.hit_effect_oh->time_counter = std::numeric_limits<int>::max();
+        set_hit_aura_ready(hit_aura, std::numeric_limits<int>::max());
     }
     min_hit_aura = std::numeric_limits<int>::max();
 
     use_effect_index = 0;
     min_use_effect = use_effects_schedule.empty() ? std::numeric_limits<int>::max() : use_effects_schedule[0].first - 1;
-
-    need_to_recompute_mitigation = true;
-    need_to_recompute_hit_tables = true;
 }
 
 void Buff_manager::update_aura_uptimes(int current_time) {
@@ -102,13 +118,18 @@ void Buff_manager::increment(Time_keeper& time_keeper, Logger& logger)
 
 void Buff_manager::remove_charge(const Hit_effect& hit_effect, int current_time, Logger& logger)
 {
-    if (hit_effect.combat_buff_idx == -1)
+    remove_charge(hit_effect.combat_buff_idx, current_time, logger);
+}
+
+void Buff_manager::remove_charge(int combat_buff_idx, int current_time, Logger& logger)
+{
+    if (combat_buff_idx == -1)
     {
         // it's required that hit_effect can be successfully registered (i.e. combat_buff_idx is eventually set)
         return; // not up
     }
 
-    auto& buff = combat_buffs[hit_effect.combat_buff_idx];
+    auto& buff = combat_buffs[combat_buff_idx];
     if (buff.stacks == 0) return;
     buff.charges -= 1;
     if (buff.charges > 0) return;
@@ -121,51 +142,57 @@ void Buff_manager::remove_charge(const Hit_effect& hit_effect, int current_time,
 //  so each hit_effect would have a one-to-one connection to the corresponding buff),
 //  and would simply apply with different percentages
 void Buff_manager::add_combat_buff(Hit_effect& hit_effect, int current_time)
+{
+    add_combat_buff(hit_effect, hit_effect.combat_buff_idx, current_time);
+}
+
+void Buff_manager::add_combat_buff(const Hit_effect& hit_effect, int& combat_buff_idx, int current_time)
 {
     assert(hit_effect.max_stacks >= 1);
     assert(hit_effect.max_charges >= 1);
 
     // "registration", essentially - once per hit_effect, connects each hit_effect w/ a combat buff
-    if (hit_effect.combat_buff_idx == -1)
+    if (combat_buff_idx == -1)
     {
         for (size_t i = 0; i < combat_buffs.size(); ++i)
         {
             if (combat_buffs[i].name == hit_effect.name)
             {
-                hit_effect.combat_buff_idx = static_cast<int>(i);
-                return do_add_combat_buff(hit_effect, current_time);
+                combat_buff_idx = static_cast<int>(i);
+                return do_add_combat_buff(hit_effect, combat_buff_idx, current_time);
             }
         }
 
-        auto& buff = combat_buffs.emplace_back(hit_effect, sim_state->special_stats, current_time);
-        gain_stats(buff.special_stats_boost);
+        auto& buff = combat_buffs.emplace_back(hit_effect, sim_state->special_stats(), current_time);
+        gain_stats(buff);
         if (buff.next_fade < min_combat_buff) min_combat_buff = buff.next_fade;
-        hit_effect.combat_buff_idx = static_cast<int>(combat_buffs.size()) - 1;
+        combat_buff_idx = static_cast<int>(combat_buffs.size()) - 1;
         return;
     }
 
-    do_add_combat_buff(hit_effect, current_time);
+    do_add_combat_buff(hit_effect, combat_buff_idx, current_time);
 }
 
-void Buff_manager::add_hit_aura(const std::string& name, Hit_effect& hit_effect, int duration, int current_time)
+void Buff_manager::add_hit_aura(const std::string& name, int duration, int current_time)
 {
     for (auto& hit_aura : hit_auras)
     {
         if (hit_aura.name == name)
         {
-            hit_aura.hit_effect_mh->time_counter = 0; // re-enable hit_effects, and queue fade
-            hit_aura.hit_effect_oh->time_counter = 0;
+            set_hit_aura_ready(hit_aura, 0); // re-enable hit_effects, and queue fade
             hit_aura.next_fade = current_time + duration;
             if (hit_aura.next_fade < min_hit_aura) min_hit_aura = hit_aura.next_fade;
             return;
         }
     }
 
-    auto& hit_aura = hit_auras.emplace_back(Hit_aura(name, current_time, duration));
-    hit_effect.sanitize();
-    hit_aura.hit_effect_mh = &hit_effects_mh->emplace_back(hit_effect);
-    hit_aura.hit_effect_oh = &hit_effects_oh->emplace_back(hit_effect);
-    if (hit_aura.next_fade < min_hit_aura) min_hit_aura = hit_aura.next_fade;
+    assert(false && "hit aura wasn't registered in initialize()");
+}
+
+void Buff_manager::set_hit_aura_ready(const Hit_aura& hit_aura, int ready_at)
+{
+    main_hand->ready_at[hit_aura.mh_index] = ready_at;
+    if (hit_aura.oh_index >= 0) off_hand->ready_at[hit_aura.oh_index] = ready_at;
 }
 
 void Buff_manager::add_over_time_buff(Over_time_effect& over_time_effect, int current_time)
@@ -256,7 +283,7 @@ void Buff_manager::increment_over_time_buffs(int current_time, Logger& logger)
         }
         else
         {
-            sim_state->special_stats += buff.special_stats;
+            sim_state->stats.add(buff.stat_delta);
         }
 
         if (buff.next_fade == current_time)
@@ -296,17 +323,15 @@ void Buff_manager::increment_hit_auras(int current_time, Logger& logger)
 
         assert(current_time == hit_aura.next_fade);
 
-        assert(hit_aura.hit_effect_mh != nullptr);
-        assert(hit_aura.hit_effect_oh != nullptr);
-
         // or have a specialized add_combat_buff() here, probably
-        assert(hit_aura.hit_effect_mh->combat_buff_idx >= 0);
-        assert(hit_aura.hit_effect_oh->combat_buff_idx == -1 || hit_aura.hit_effect_oh->combat_buff_idx == hit_aura.hit_effect_mh->combat_buff_idx);
+        const auto combat_buff_idx = main_hand->combat_buff_idx[hit_aura.mh_index];
+        assert(combat_buff_idx >= 0);
+        assert(hit_aura.oh_index < 0 || off_hand->combat_buff_idx[hit_aura.oh_index] == -1 ||
+               off_hand->combat_buff_idx[hit_aura.oh_index] == combat_buff_idx);
 
-        hit_aura.hit_effect_mh->time_counter = std::numeric_limits<int>::max(); // effectively disable hit_effects
-        hit_aura.hit_effect_oh->time_counter = std::numeric_limits<int>::max();
+        set_hit_aura_ready(hit_aura, std::numeric_limits<int>::max()); // effectively disable hit_effects
 
-        auto& buff = combat_buffs[hit_aura.hit_effect_mh->combat_buff_idx];
+        auto& buff = combat_buffs[combat_buff_idx];
         buff.next_fade = hit_aura.next_fade; // for correct uptime bookkeeping
         do_fade_buff(buff, logger);
 
@@ -343,7 +368,7 @@ void Buff_manager::increment_use_effects(int current_time, Time_keeper& time_kee
 
     if (!use_effect.hit_effects.empty())
     {
-        add_hit_aura(use_effect.name, use_effect.hit_effects[0], use_effect.hit_effects[0].duration, current_time);
+        add_hit_aura(use_effect.name, use_effect.hit_effects[0].duration, current_time);
     }
     else if (!use_effect.over_time_effects.empty())
     {
@@ -389,15 +414,9 @@ void Buff_manager::increment_use_effects(int current_time, Time_keeper& time_kee
 
 void Buff_manager::do_fade_buff(Combat_buff& buff, Logger& logger)
 {
-    const auto& ssb = buff.special_stats_boost;
-    for (int i = 0; i < buff.stacks; i++)
-    {
-        sim_state->special_stats -= ssb;
-    }
+    sim_state->stats.remove(buff.stat_delta, buff.stacks);
     buff.stacks = 0;
     buff.charges = 0;
-    need_to_recompute_hit_tables |= (ssb.critical_strike > 0 || ssb.hit > 0 || ssb.expertise > 0);
-    need_to_recompute_mitigation |= (ssb.gear_armor_pen > 0);
 
     // special case, should be removed
     if (buff.name == "battle_stance")
@@ -410,21 +429,19 @@ void Buff_manager::do_fade_buff(Combat_buff& buff, Logger& logger)
     logger.print(buff.name, " fades.");
 }
 
-void Buff_manager::gain_stats(const Special_stats& ssb)
+void Buff_manager::gain_stats(const Combat_buff& buff)
 {
-    sim_state->special_stats += ssb;
-    need_to_recompute_hit_tables |= (ssb.hit > 0 || ssb.critical_strike > 0 || ssb.expertise > 0);
-    need_to_recompute_mitigation |= (ssb.gear_armor_pen > 0);
+    sim_state->stats.add(buff.stat_delta);
 }
 
-void Buff_manager::do_add_combat_buff(Hit_effect& hit_effect, int current_time)
+void Buff_manager::do_add_combat_buff(const Hit_effect& hit_effect, int combat_buff_idx, int current_time)
 {
-    auto& buff = combat_buffs[hit_effect.combat_buff_idx];
+    auto& buff = combat_buffs[combat_buff_idx];
     if (buff.next_fade < current_time || buff.stacks < hit_effect.max_stacks)
     {
         if (buff.next_fade < current_time) assert(buff.stacks == 0 && buff.charges == 0);
         if (buff.stacks == 0) buff.last_gain = current_time;
-        gain_stats(buff.special_stats_boost);
+        gain_stats(buff);
         buff.stacks += 1;
     }
     buff.next_fade = current_time + hit_effect.duration; // or keep unchanged for "temporary hit effects"
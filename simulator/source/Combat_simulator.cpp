@@ -2,10 +2,14 @@
 
 #include "Statistics.hpp"
 #include "Use_effects.hpp"
+#include "binary_io.hpp"
+#include "encounter.hpp"
 #include "item_heuristics.hpp"
+#include "parallel.hpp"
 #include "sim_state.hpp"
 
 #include <algorithm>
+#include <numeric>
 
 namespace
 {
@@ -34,6 +38,68 @@ Combat_simulator::Combat_simulator(const Combat_simulator_config& config) : conf
     }
 }
 
+void Combat_simulator::reset(const Combat_simulator_config& new_config)
+{
+    config = new_config;
+    armor_reduction_from_spells_ = 800 * config.curse_of_recklessness_active + 610 * config.faerie_fire_feral_active;
+    armor_reduction_delayed_ = config.exposed_armor ? 3075 : 0;
+
+    // the hit tables are rebuilt by the next run, everything below is what a run adds up
+    compute_hit_table_stats_ = {};
+    damage_distribution_ = Damage_sources();
+    dps_distribution_ = Distribution();
+    antithetic_pair_dps_ = Distribution();
+    dps_sketch_ = Quantile_sketch();
+    min_fight_ = {};
+    max_fight_ = {};
+    first_fight_ = 0;
+    fight_dps_.clear();
+    roll_luck_ = {};
+    dps_control_variates_ = Control_variates(4);
+    fight_lengths_.clear();
+    fight_length_dps_.clear();
+
+    flurry_uptime_ = 0;
+    oh_queued_uptime_ = 0;
+    rampage_uptime_ = 0;
+    rage_gained_ = 0;
+    rage_spent_ = 0;
+    rage_spent_on_execute_ = 0;
+    rage_lost_stance_swap_ = 0;
+    rage_lost_capped_ = 0;
+    avg_rage_spent_executing_ = 0;
+
+    proc_data_.clear();
+    longest_hit_chain_ = 0;
+    aura_uptimes_.clear();
+    damage_time_lapse_.clear();
+    hist_x.clear();
+    hist_y.clear();
+    logger_ = Logger();
+
+    // the buffs of the last character go, and with them the links to them
+    buff_manager_.clear();
+    pending_hits_.clear();
+    resolving_pending_hits_ = false;
+    battle_stance_.combat_buff_idx = -1;
+    destroyer_2_set_.combat_buff_idx = -1;
+    windfury_attack_.combat_buff_idx = -1;
+    deep_wound_effect_.over_time_buff_idx = -1;
+    recompute_mitigation_ = false;
+    apply_delayed_armor_reduction = false;
+    armor_reduction_factor_ = 0;
+    armor_reduction_factor_add = 0;
+
+    has_run = false;
+}
+
+Combat_simulator& Combat_simulator::pooled(const Combat_simulator_config& config)
+{
+    thread_local Combat_simulator simulator(config);
+    simulator.reset(config);
+    return simulator;
+}
+
 void Combat_simulator::add_talent_effects(const Character& character)
 {
     execute_rage_cost_ = std::vector<int>{15, 13, 10}[character.talents.improved_execute] - 3 * has_onslaught_2_set_;
@@ -45,7 +111,9 @@ void Combat_simulator::add_talent_effects(const Character& character)
     tactical_mastery_rage_ = 10 + character.talents.tactical_mastery * 5;
 
     have_flurry_ = character.talents.flurry > 0;
-    flurry_.attack_speed = character.talents.flurry * 0.05;
+    Special_stats flurry{};
+    flurry.attack_speed = character.talents.flurry * 0.05;
+    flurry_ = Stat_delta(flurry);
 
     deep_wounds_ = character.talents.deep_wounds && config.deep_wounds;
     use_rampage_ = character.talents.rampage && config.combat.use_rampage;
@@ -54,9 +122,33 @@ void Combat_simulator::add_talent_effects(const Character& character)
     use_sweeping_strikes_ = character.talents.sweeping_strikes && config.use_sweeping_strikes && config.multi_target_mode_;
 }
 
+Combat_simulator::Level_table Combat_simulator::level_table(int target_level)
+{
+    switch (target_level)
+    {
+    case 72:
+        return {6.0, 0.0, 6.0, 18.0, 15.0, 2.0};
+    case 71:
+        return {5.5, 0.0, 5.5, 12.0, 5.0, 1.0};
+    case 70:
+        return {5.0, 0.0, 5.0, 6.0, 5.0, 0.0};
+    default:
+        return {8.0, 1.0, 6.5, 24.0, 25.0, 4.8};
+    }
+}
+
+double Combat_simulator::yellow_hit_cap(int target_level)
+{
+    const auto level = level_table(target_level);
+    return level.miss + level.hit_suppression;
+}
+
 void Combat_simulator::compute_hit_tables(const Character& character, const Special_stats& special_stats, const Weapon_sim& weapon)
 {
-    if (special_stats.hit == compute_hit_table_stats_.hit && special_stats.expertise == compute_hit_table_stats_.expertise)
+    const auto& last = compute_hit_table_stats_;
+    if (special_stats.hit == last.hit && special_stats.expertise == last.expertise &&
+        special_stats.sword_expertise == last.sword_expertise && special_stats.mace_expertise == last.mace_expertise &&
+        special_stats.axe_expertise == last.axe_expertise && special_stats.crit_multiplier == last.crit_multiplier)
     {
         auto crit_delta = special_stats.critical_strike - compute_hit_table_stats_.critical_strike;
         if (crit_delta == 0)
@@ -79,43 +171,16 @@ void Combat_simulator::compute_hit_tables(const Character& character, const Spec
         return;
     }
 
-    auto miss = 8.0;
-    auto hit_suppression = 1.0;
-    auto dodge = 6.5;
-    auto glance = 24.0;
-    auto glance_dr = 25.0;
-    auto crit_suppression = 4.8;
-
-    if (config.main_target_level == 72)
-    {
-        miss = 6.0;
-        hit_suppression = 0.0;
-        dodge = 6.0;
-        glance = 18.0;
-        glance_dr = 15.0;
-        crit_suppression = 2.0;
-    }
-    else if (config.main_target_level == 71)
-    {
-        miss = 5.5;
-        hit_suppression = 0.0;
-        dodge = 5.5;
-        glance = 12.0;
-        glance_dr = 5.0;
-        crit_suppression = 1.0;
-    }
-    else if (config.main_target_level == 70)
-    {
-        miss = 5.0;
-        hit_suppression = 0.0;
-        dodge = 5.0;
-        glance = 6.0;
-        glance_dr = 5.0;
-        crit_suppression = 0.0;
-    }
+    const auto level = level_table(config.main_target_level);
+    auto miss = level.miss;
+    const auto hit_suppression = level.hit_suppression;
+    auto dodge = level.dodge;
+    const auto glance = level.glance;
+    const auto glance_dr = level.glance_dr;
+    const auto crit_suppression = level.crit_suppression;
 
     auto sw_miss = std::max(miss - std::max(special_stats.hit - hit_suppression, 0.0), 0.0);
-    auto dw_miss = std::max(miss + 19.0 - std::max(special_stats.hit - hit_suppression, 0.0), 0.0);
+    auto dw_miss = std::max(miss + dual_wield_miss - std::max(special_stats.hit - hit_suppression, 0.0), 0.0);
     miss = weapon.weapon_socket == Weapon_socket::two_hand ? sw_miss : dw_miss;
 
     auto expertise = special_stats.expertise;
@@ -272,14 +337,17 @@ Combat_simulator::Hit_outcome Combat_simulator::generate_hit(Sim_state& state, c
 
     if (boss_target)
     {
-        damage *= armor_reduction_factor_ * (1 + state.special_stats.damage_mod_physical);
+        damage *= armor_reduction_factor_ * (1 + state.special_stats().damage_mod_physical);
     }
     else
     {
-        damage *= armor_reduction_factor_add * (1 + state.special_stats.damage_mod_physical);
+        damage *= armor_reduction_factor_add * (1 + state.special_stats().damage_mod_physical);
     }
 
-    auto hit_outcome = hit_table.generate_hit(damage);
+    const auto roll = get_uniform_random(100);
+    auto hit_outcome = hit_table.generate_hit(roll, damage, config.antithetic_batches);
+    roll_luck_.crits += (hit_outcome.hit_result == Hit_result::crit ? 1 : 0) - std::max(hit_table.crit(), 0.0) / 100;
+    roll_luck_.avoided += (hit_table.isMissOrDodge(roll) ? 1 : 0) - (hit_table.miss() + hit_table.dodge()) / 100;
 
     cout_damage_parse(weapon, hit_table, hit_outcome);
 
@@ -326,7 +394,7 @@ Combat_simulator::Hit_outcome Combat_simulator::generate_hit(Sim_state& state, c
             //  - weapon_damage_done% (e.g. 1H/2H weapon spec; this might just be calculated here, locally)
             //  - mod_damage_taken% (blood frenzy)
 
-            const auto& ss = state.special_stats;
+            const auto& ss = state.special_stats();
             const auto& w = state.main_hand_weapon;
 
             // deep wound double dips from "bonus damage": it's additionally added to each tick
@@ -352,28 +420,28 @@ Combat_simulator::Hit_outcome Combat_simulator::generate_hit(Sim_state& state, c
     return hit_outcome;
 }
 
-void Combat_simulator::maybe_gain_flurry(Hit_result hit_result, int& flurry_charges, Special_stats& special_stats) const
+void Combat_simulator::maybe_gain_flurry(Hit_result hit_result, int& flurry_charges, Stat_accumulator& stats) const
 {
     if (!have_flurry_ || flurry_charges == 3 || hit_result != Hit_result::crit) return;
 
-    if (flurry_charges == 0) special_stats += flurry_;
+    if (flurry_charges == 0) stats.add(flurry_);
     flurry_charges = 3;
 }
 
-void Combat_simulator::maybe_remove_flurry(int& flurry_charges, Special_stats& special_stats) const
+void Combat_simulator::maybe_remove_flurry(int& flurry_charges, Stat_accumulator& stats) const
 {
     if (!have_flurry_ || flurry_charges == 0) return;
 
-    if (flurry_charges == 1) special_stats -= flurry_;
+    if (flurry_charges == 1) stats.remove(flurry_);
     flurry_charges -= 1;
 }
 
-void Combat_simulator::maybe_add_rampage_stack(Hit_result hit_result, int& rampage_stacks, Special_stats& special_stats)
+void Combat_simulator::maybe_add_rampage_stack(Hit_result hit_result, int& rampage_stacks, Stat_accumulator& stats)
 {
     if (!use_rampage_ || rampage_stacks == 5 || rampage_stacks == 0 || hit_result == Hit_result::miss || hit_result == Hit_result::dodge) return;
 
     rampage_stacks += 1;
-    special_stats += {0, 0, 50};
+    stats.add(rampage_stack_);
     logger_.print(rampage_stacks, " rampage stacks");
 }
 
@@ -388,7 +456,7 @@ void Combat_simulator::unbridled_wrath(Sim_state& state, const Weapon_sim& weapo
 
 bool Combat_simulator::start_cast_slam(Sim_state& state, bool mh_swing, const Weapon_sim& weapon)
 {
-    double next_swing = to_millis(weapon.swing_speed) / (1 + state.special_stats.haste);
+    double next_swing = to_millis(weapon.swing_speed) / (1 + state.special_stats().haste);
 
     if (mh_swing && next_swing >= config.combat.slam_spam_max_time)
     {
@@ -408,12 +476,12 @@ void Combat_simulator::slam(Sim_state& state)
 {
     if (config.dpr_settings.compute_dpr_sl_)
     {
-        spend_rage(hit_table_yellow_mh_.isMissOrDodge() ? 3 : 15);
+        spend_rage(hit_table_yellow_mh_.isMissOrDodge(get_uniform_random(100)) ? 3 : 15);
         time_keeper_.global_cast(1500);
         return;
     }
     logger_.print("Slam!");
-    double damage = state.main_hand_weapon.swing(state.special_stats) + 140;
+    double damage = state.main_hand_weapon.swing(state.special_stats()) + 140;
     const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_yellow_mh_, damage);
     if (hit_outcome.hit_result == Hit_result::miss || hit_outcome.hit_result == Hit_result::dodge)
     {
@@ -426,8 +494,8 @@ void Combat_simulator::slam(Sim_state& state)
     else
     {
         spend_rage(15);
-        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
-        hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon);
+        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
+        hit_effects(state, hit_outcome.hit_result, state.main_hand);
     }
     state.add_damage(Damage_source::slam, hit_outcome.damage, time_keeper_.time);
     logger_.print("Current rage: ", int(rage));
@@ -437,13 +505,13 @@ void Combat_simulator::mortal_strike(Sim_state& state)
 {
     if (config.dpr_settings.compute_dpr_ms_)
     {
-        spend_rage(hit_table_yellow_mh_.isMissOrDodge() ? 0.2 * mortal_strike_rage_cost_ : mortal_strike_rage_cost_);
+        spend_rage(hit_table_yellow_mh_.isMissOrDodge(get_uniform_random(100)) ? 0.2 * mortal_strike_rage_cost_ : mortal_strike_rage_cost_);
         time_keeper_.mortal_strike_cast(6000 - state.talents.improved_mortal_strike * 200);
         time_keeper_.global_cast(1500);
         return;
     }
     logger_.print("Mortal Strike!");
-    double damage = (state.main_hand_weapon.normalized_swing(state.special_stats) + 210) * (100 + state.talents.improved_mortal_strike) / 100 * (100 + 5 * has_onslaught_4_set_) / 100;
+    double damage = (state.main_hand_weapon.normalized_swing(state.special_stats()) + 210) * (100 + state.talents.improved_mortal_strike) / 100 * (100 + 5 * has_onslaught_4_set_) / 100;
     const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_yellow_mh_, damage);
     if (hit_outcome.hit_result == Hit_result::miss || hit_outcome.hit_result == Hit_result::dodge)
     {
@@ -456,8 +524,8 @@ void Combat_simulator::mortal_strike(Sim_state& state)
     else
     {
         spend_rage(mortal_strike_rage_cost_);
-        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
-        hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon, Hit_type::spell, {}, Special_type::ms_bt);
+        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
+        hit_effects(state, hit_outcome.hit_result, state.main_hand, Hit_type::spell, {}, Special_type::ms_bt);
     }
     time_keeper_.mortal_strike_cast(6000 - state.talents.improved_mortal_strike * 200);
     time_keeper_.global_cast(1500);
@@ -469,14 +537,14 @@ void Combat_simulator::bloodthirst(Sim_state& state)
 {
     if (config.dpr_settings.compute_dpr_bt_)
     {
-        spend_rage(hit_table_yellow_mh_.isMissOrDodge() ? 0.2 * bloodthirst_rage_cost_ : bloodthirst_rage_cost_);
+        spend_rage(hit_table_yellow_mh_.isMissOrDodge(get_uniform_random(100)) ? 0.2 * bloodthirst_rage_cost_ : bloodthirst_rage_cost_);
         time_keeper_.blood_thirst_cast(6000);
         time_keeper_.global_cast(1500);
         return;
     }
     logger_.print("Bloodthirst!");
     // logger_.print("(DEBUG) AP: ", special_stats.attack_power);
-    double damage = (state.special_stats.attack_power * 0.45 + state.special_stats.bonus_damage) * (100 + 5 * has_onslaught_4_set_) / 100;
+    double damage = (state.special_stats().attack_power * 0.45 + state.special_stats().bonus_damage) * (100 + 5 * has_onslaught_4_set_) / 100;
     const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_yellow_mh_, damage);
     if (hit_outcome.hit_result == Hit_result::miss || hit_outcome.hit_result == Hit_result::dodge)
     {
@@ -489,8 +557,8 @@ void Combat_simulator::bloodthirst(Sim_state& state)
     else
     {
         spend_rage(bloodthirst_rage_cost_);
-        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
-        hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon, Hit_type::spell, {}, Special_type::ms_bt);
+        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
+        hit_effects(state, hit_outcome.hit_result, state.main_hand, Hit_type::spell, {}, Special_type::ms_bt);
     }
     time_keeper_.blood_thirst_cast(6000);
     time_keeper_.global_cast(1500);
@@ -512,14 +580,14 @@ void Combat_simulator::overpower(Sim_state& state)
     logger_.print("Changed stance: Battle Stance.");
     logger_.print("Overpower!");
     buff_manager_.add_combat_buff(battle_stance_, time_keeper_.time);
-    double damage = state.main_hand_weapon.normalized_swing(state.special_stats) + 35;
+    double damage = state.main_hand_weapon.normalized_swing(state.special_stats()) + 35;
     const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_overpower_, damage);
     swap_stance();
     spend_rage(5);
     if (hit_outcome.hit_result != Hit_result::miss && hit_outcome.hit_result != Hit_result::dodge)
     {
-        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
-        hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon);
+        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
+        hit_effects(state, hit_outcome.hit_result, state.main_hand);
     }
     if (has_destroyer_2_set_)
     {
@@ -543,8 +611,8 @@ void Combat_simulator::whirlwind(Sim_state& state)
     logger_.print("Whirlwind! #targets = boss + ", number_of_extra_targets_, " adds");
     logger_.print("Whirlwind hits: ", std::min(number_of_extra_targets_ + 1, 4), " targets");
     spend_rage(whirlwind_rage_cost_); // spend rage before hit_effects
-    double mh_damage = state.main_hand_weapon.normalized_swing(state.special_stats);
-    double oh_damage = state.is_dual_wield ? state.off_hand_weapon.normalized_swing(state.special_stats) * (1 + 0.05 * state.talents.dual_wield_specialization) : 0;
+    double mh_damage = state.main_hand_weapon.normalized_swing(state.special_stats());
+    double oh_damage = state.is_dual_wield ? state.off_hand_weapon.normalized_swing(state.special_stats()) * (1 + 0.05 * state.talents.dual_wield_specialization) : 0;
     double total_damage = 0;
     for (int i = 0; i < std::min(number_of_extra_targets_ + 1, 4); i++)
     {
@@ -552,8 +620,8 @@ void Combat_simulator::whirlwind(Sim_state& state)
         total_damage += mh_outcome.damage;
         if (mh_outcome.hit_result != Hit_result::miss && mh_outcome.hit_result != Hit_result::dodge)
         {
-            maybe_gain_flurry(mh_outcome.hit_result, state.flurry_charges, state.special_stats);
-            hit_effects(state, mh_outcome.hit_result, state.main_hand_weapon);
+            maybe_gain_flurry(mh_outcome.hit_result, state.flurry_charges, state.stats);
+            hit_effects(state, mh_outcome.hit_result, state.main_hand);
         }
         else if (mh_outcome.hit_result == Hit_result::dodge)
         {
@@ -565,9 +633,9 @@ void Combat_simulator::whirlwind(Sim_state& state)
             total_damage += oh_outcome.damage;
             if (oh_outcome.hit_result != Hit_result::miss && oh_outcome.hit_result != Hit_result::dodge)
             {
-                maybe_gain_flurry(oh_outcome.hit_result, state.flurry_charges, state.special_stats);
+                maybe_gain_flurry(oh_outcome.hit_result, state.flurry_charges, state.stats);
                 // most likely doesn't proc any non-weapon-specific hit effect
-                hit_effects(state, oh_outcome.hit_result, state.off_hand_weapon);
+                hit_effects(state, oh_outcome.hit_result, state.off_hand);
             }
         }
     }
@@ -584,12 +652,12 @@ void Combat_simulator::execute(Sim_state& state)
         logger_.print("Execute (DPR)!");
         spend_rage(execute_rage_cost_);
         time_keeper_.global_cast(1500);
-        if (hit_table_yellow_mh_.isMissOrDodge()) return;
+        if (hit_table_yellow_mh_.isMissOrDodge(get_uniform_random(100))) return;
         spend_all_rage();
         return;
     }
     logger_.print("Execute!");
-    double damage = 925 + (rage - execute_rage_cost_) * 21 + state.special_stats.bonus_damage;
+    double damage = 925 + (rage - execute_rage_cost_) * 21 + state.special_stats().bonus_damage;
     const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_yellow_mh_, damage);
     spend_rage(execute_rage_cost_);
     time_keeper_.global_cast(1500);
@@ -603,8 +671,8 @@ void Combat_simulator::execute(Sim_state& state)
         return;
     }
     spend_all_rage();
-    maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
-    hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon);
+    maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
+    hit_effects(state, hit_outcome.hit_result, state.main_hand);
     state.add_damage(Damage_source::execute, hit_outcome.damage, time_keeper_.time);
     logger_.print("Current rage: ", int(rage));
 }
@@ -613,12 +681,12 @@ void Combat_simulator::hamstring(Sim_state& state)
 {
     if (config.dpr_settings.compute_dpr_ha_)
     {
-        spend_rage(hit_table_yellow_mh_.isMissOrDodge() ? 2 : 10);
+        spend_rage(hit_table_yellow_mh_.isMissOrDodge(get_uniform_random(100)) ? 2 : 10);
         time_keeper_.global_cast(1500);
         return;
     }
     logger_.print("Hamstring!");
-    double damage = 63 + state.special_stats.bonus_damage;
+    double damage = 63 + state.special_stats().bonus_damage;
     const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_yellow_mh_, damage);
     time_keeper_.global_cast(1500);
     if (hit_outcome.hit_result == Hit_result::miss || hit_outcome.hit_result == Hit_result::dodge)
@@ -632,8 +700,8 @@ void Combat_simulator::hamstring(Sim_state& state)
     else
     {
         spend_rage(10);
-        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
-        hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon);
+        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
+        hit_effects(state, hit_outcome.hit_result, state.main_hand);
     }
     state.add_damage(Damage_source::hamstring, hit_outcome.damage, time_keeper_.time);
     logger_.print("Current rage: ", int(rage));
@@ -642,7 +710,7 @@ void Combat_simulator::hamstring(Sim_state& state)
 void Combat_simulator::sunder_armor(Sim_state& state)
 {
     logger_.print("Sunder Armor!");
-    auto hit_outcome = hit_table_yellow_mh_.generate_hit(0);
+    auto hit_outcome = hit_table_yellow_mh_.generate_hit(get_uniform_random(100), 0);
     time_keeper_.global_cast(1500);
     if (hit_outcome.hit_result == Hit_result::miss || hit_outcome.hit_result == Hit_result::dodge)
     {
@@ -655,7 +723,7 @@ void Combat_simulator::sunder_armor(Sim_state& state)
     else
     {
         spend_rage(15);
-        hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon);
+        hit_effects(state, hit_outcome.hit_result, state.main_hand);
         sunder_armor_stacks_++;
         logger_.print("Current Sunder Armor stacks: ", sunder_armor_stacks_);
         recompute_mitigation_ = true;
@@ -663,12 +731,48 @@ void Combat_simulator::sunder_armor(Sim_state& state)
     logger_.print("Current rage: ", int(rage));
 }
 
-void Combat_simulator::hit_effects(Sim_state& state, Hit_result hit_result, Weapon_sim& weapon, Hit_type hit_type, Extra_attack_chain chain,
+void Combat_simulator::hit_effects(Sim_state& state, Hit_result hit_result, Weapon_state& weapon, Hit_type hit_type, Extra_attack_chain chain,
                                     Special_type special_type)
 {
-    maybe_add_rampage_stack(Hit_result::hit, state.rampage_stacks, state.special_stats);
+    proc_hit_effects(state, hit_result, weapon, hit_type, chain, special_type);
+    if (resolving_pending_hits_) return;
+
+    // the hits queued while resolving one go to the back, the index keeps up with them
+    resolving_pending_hits_ = true;
+    for (size_t i = 0; i < pending_hits_.size(); ++i)
+    {
+        const auto pending_hit = pending_hits_[i];
+        if (pending_hit.extra_attack)
+        {
+            swing_main_hand(state, pending_hit.chain);
+        }
+        else
+        {
+            proc_hit_effects(state, pending_hit.hit_result, state.main_hand, Hit_type::spell, {}, Special_type::none);
+        }
+    }
+    longest_hit_chain_ = std::max(longest_hit_chain_, static_cast<int>(pending_hits_.size()));
+    pending_hits_.clear();
+    resolving_pending_hits_ = false;
+}
+
+void Combat_simulator::queue_hit(const Pending_hit& pending_hit)
+{
+    if (pending_hits_.size() >= max_pending_hits)
+    {
+        logger_.print("Too many extra hits queued, dropping one");
+        return;
+    }
+    pending_hits_.push_back(pending_hit);
+}
+
+void Combat_simulator::proc_hit_effects(Sim_state& state, Hit_result hit_result, Weapon_state& weapon, Hit_type hit_type,
+                                        Extra_attack_chain chain, Special_type special_type)
+{
+    maybe_add_rampage_stack(Hit_result::hit, state.rampage_stacks, state.stats);
 
-    if (state.talents.mace_specialization > 0 && weapon.weapon_type == Weapon_type::mace && get_uniform_random(60) < state.talents.mace_specialization * 0.3 * weapon.swing_speed)
+    const auto swing_speed = weapon.weapon.swing_speed;
+    if (state.talents.mace_specialization > 0 && weapon.weapon.weapon_type == Weapon_type::mace && get_uniform_random(60) < state.talents.mace_specialization * 0.3 * swing_speed)
     {
         gain_rage(7);
         logger_.print("Mace specialization. Current rage: ", int(rage));
@@ -676,22 +780,27 @@ void Combat_simulator::hit_effects(Sim_state& state, Hit_result hit_result, Weap
 
     auto extra_attack_procced = false; // melee/next_melee attacks only allow one extra attack per swing (but any number in a chain)
 
-    for (auto& hit_effect : weapon.hit_effects)
+    for (const auto& candidate : weapon.candidates(hit_result))
     {
-        if (hit_effect.time_counter > time_keeper_.time) continue; // on cooldown
+        const auto i = candidate.index;
+        if (weapon.ready_at[i] > time_keeper_.time) continue; // on cooldown
 
-        if (!hit_effect.is_procced_by(hit_result)) // wrong trigger
+        if (!candidate.procs)
         {
-            // darkmoon_card_wrath charges are removed on any crit hit
-            if (hit_effect.name == "darkmoon_card_wrath")
-            {
-                buff_manager_.remove_charge(hit_effect, time_keeper_.time, logger_);
-            }
+            buff_manager_.remove_charge(weapon.combat_buff_idx[i], time_keeper_.time, logger_);
             continue;
         }
 
-        auto probability = hit_effect.ppm > 0 ? hit_effect.ppm * weapon.swing_speed / 60 : hit_effect.probability;
-        if (probability < 1 && get_uniform_random(1) >= probability) continue; // no chance ;)
+        const auto& hit_effect = weapon.weapon.hit_effects[i];
+        const auto probability = weapon.proc_chance[i];
+        if (probability < 1)
+        {
+            const bool procced = get_uniform_random(1) < probability;
+            const bool is_extra_attack = hit_effect.type == Hit_effect::Type::windfury_hit || hit_effect.type == Hit_effect::Type::sword_spec ||
+                                         hit_effect.type == Hit_effect::Type::extra_hit;
+            (is_extra_attack ? roll_luck_.extra_attacks : roll_luck_.procs) += (procced ? 1 : 0) - probability;
+            if (!procced) continue; // no chance ;)
+        }
 
         switch (hit_effect.type)
         {
@@ -699,70 +808,70 @@ void Combat_simulator::hit_effects(Sim_state& state, Hit_result hit_result, Weap
             if (hit_type == Hit_type::spell || chain.windfury) break;
 
             auto ineffective = extra_attack_procced;
-            on_proc(hit_effect, "PROC: extra hit from: ", hit_effect.name, ineffective ? " (ineffective)" : "");
+            on_proc(weapon, i, "PROC: extra hit from: ", hit_effect.name, ineffective ? " (ineffective)" : "");
             chain.windfury = true;
             windfury_attack_.duration = hit_type == Hit_type::next_melee ? 1500 : 10; // even if the extra attack is ineffective, the buff is still up
             buff_manager_.add_combat_buff(windfury_attack_, time_keeper_.time);
             if (ineffective) break;
 
             extra_attack_procced = true;
-            swing_main_hand(state, chain);
+            queue_hit({true, chain});
             break;
         }
         case Hit_effect::Type::sword_spec: { // only once per chain (which is guaranteed via ICD already)
             if (chain.sword_spec) break;
 
             auto ineffective = hit_type != Hit_type::spell && extra_attack_procced;
-            on_proc(hit_effect, "PROC: extra hit from: ", hit_effect.name, ineffective ? " (ineffective)" : "");
+            on_proc(weapon, i, "PROC: extra hit from: ", hit_effect.name, ineffective ? " (ineffective)" : "");
             chain.sword_spec = true;
             if (ineffective) break;
 
             extra_attack_procced = true;
-            swing_main_hand(state, chain);
+            queue_hit({true, chain});
             break;
         }
         case Hit_effect::Type::extra_hit: { // no restrictions
             auto ineffective = hit_type != Hit_type::spell && extra_attack_procced;
-            on_proc(hit_effect, "PROC: extra hit from: ", hit_effect.name, ineffective ? " (ineffective)" : "");
+            on_proc(weapon, i, "PROC: extra hit from: ", hit_effect.name, ineffective ? " (ineffective)" : "");
             if (ineffective) break;
 
             extra_attack_procced = true;
-            swing_main_hand(state, chain);
+            queue_hit({true, chain});
             break;
         }
         case Hit_effect::Type::stat_boost: {
-            on_proc(hit_effect, "PROC: ", hit_effect.name, " stats increased for ", hit_effect.duration * 0.001, "s");
-            buff_manager_.add_combat_buff(hit_effect, time_keeper_.time);
+            on_proc(weapon, i, "PROC: ", hit_effect.name, " stats increased for ", hit_effect.duration * 0.001, "s");
+            buff_manager_.add_combat_buff(hit_effect, weapon.combat_buff_idx[i], time_keeper_.time);
             break;
         }
         case Hit_effect::Type::rage_boost: {
-            on_proc(hit_effect, "PROC: ", hit_effect.name, ". Current rage: ", int(rage));
+            on_proc(weapon, i, "PROC: ", hit_effect.name, ". Current rage: ", int(rage));
             gain_rage(hit_effect.damage);
             break;
         }
         case Hit_effect::Type::damage_magic: {
             // * 0.83 Assumes a static 17% chance to resist.
             // (100 + special_stats.spell_crit / 2) / 100 is the average damage gained from a x1.5 spell crit
-            double effect_damage = hit_effect.damage * 0.83 * (100 + state.special_stats.spell_crit / 2) / 100 *
-                                   (1 + state.special_stats.damage_mod_spell);
-            on_proc(hit_effect, "PROC: ", hit_effect.name, " does ", effect_damage, " magic damage.");
+            double effect_damage = hit_effect.damage * 0.83 * (100 + state.special_stats().spell_crit / 2) / 100 *
+                                   (1 + state.special_stats().damage_mod_spell);
+            on_proc(weapon, i, "PROC: ", hit_effect.name, " does ", effect_damage, " magic damage.");
             state.add_damage(Damage_source::item_hit_effects, effect_damage, time_keeper_.time);
             break;
         }
         case Hit_effect::Type::damage_physical: {
             const auto& hit_outcome = generate_hit(state, state.main_hand_weapon, hit_table_yellow_mh_, hit_effect.damage);
-            on_proc(hit_effect, "PROC: ", hit_effect.name, " does ", hit_outcome.damage, " physical damage.");
+            on_proc(weapon, i, "PROC: ", hit_effect.name, " does ", hit_outcome.damage, " physical damage.");
             state.add_damage(Damage_source::item_hit_effects, hit_outcome.damage, time_keeper_.time);
             if (hit_outcome.hit_result != Hit_result::miss && hit_outcome.hit_result != Hit_result::dodge)
             {
-                hit_effects(state, hit_outcome.hit_result, state.main_hand_weapon);
+                queue_hit({false, {}, hit_outcome.hit_result});
             }
             break;
         }
         case Hit_effect::Type::ashtongue_talisman_of_valor: {
             if (special_type != Special_type::ms_bt) break;
-            on_proc(hit_effect, "PROC: ", hit_effect.name, " stats increased for ", hit_effect.duration * 0.001, "s");
-            buff_manager_.add_combat_buff(hit_effect, time_keeper_.time);
+            on_proc(weapon, i, "PROC: ", hit_effect.name, " stats increased for ", hit_effect.duration * 0.001, "s");
+            buff_manager_.add_combat_buff(hit_effect, weapon.combat_buff_idx[i], time_keeper_.time);
             break;
         }
         default:
@@ -786,7 +895,7 @@ void Combat_simulator::swing_main_hand(Sim_state& state, Extra_attack_chain chai
 {
     auto& weapon = state.main_hand_weapon;
 
-    maybe_remove_flurry(state.flurry_charges, state.special_stats);
+    maybe_remove_flurry(state.flurry_charges, state.stats);
 
     auto white_replaced = false;
     if (ability_queue_manager.heroic_strike_queued)
@@ -795,13 +904,13 @@ void Combat_simulator::swing_main_hand(Sim_state& state, Extra_attack_chain chai
         if (rage >= heroic_strike_rage_cost_ && config.dpr_settings.compute_dpr_hs_)
         {
             logger_.print("Performing Heroic Strike (DPR)");
-            spend_rage(hit_table_yellow_mh_.isMissOrDodge() ? heroic_strike_rage_cost_ :
+            spend_rage(hit_table_yellow_mh_.isMissOrDodge(get_uniform_random(100)) ? heroic_strike_rage_cost_ :
                                                               0.2 * heroic_strike_rage_cost_);
         }
         else if (rage >= heroic_strike_rage_cost_)
         {
             logger_.print("Performing Heroic Strike");
-            double damage = weapon.swing(state.special_stats) + 176;
+            double damage = weapon.swing(state.special_stats()) + 176;
             const auto& hit_outcome = generate_hit(state, weapon, hit_table_yellow_mh_, damage);
             if (hit_outcome.hit_result == Hit_result::miss || hit_outcome.hit_result == Hit_result::dodge)
             {
@@ -811,9 +920,9 @@ void Combat_simulator::swing_main_hand(Sim_state& state, Extra_attack_chain chai
             else
             {
                 spend_rage(heroic_strike_rage_cost_);
-                maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
+                maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
                 unbridled_wrath(state, weapon);
-                hit_effects(state, hit_outcome.hit_result, weapon, Hit_type::next_melee, chain);
+                hit_effects(state, hit_outcome.hit_result, state.main_hand, Hit_type::next_melee, chain);
             }
             state.add_damage(Damage_source::heroic_strike, hit_outcome.damage, time_keeper_.time);
             white_replaced = true;
@@ -838,7 +947,7 @@ void Combat_simulator::swing_main_hand(Sim_state& state, Extra_attack_chain chai
             logger_.print("Performing Cleave! #targets = boss + ", number_of_extra_targets_, " adds");
             logger_.print("Cleave hits: ", std::min(number_of_extra_targets_ + 1, 2), " targets");
             spend_rage(20);
-            double damage = weapon.swing(state.special_stats) + 70 * (1 + 0.4 * state.talents.improved_cleave);
+            double damage = weapon.swing(state.special_stats()) + 70 * (1 + 0.4 * state.talents.improved_cleave);
             double total_damage = 0;
             for (int i = 0, n = number_of_extra_targets_ > 0 ? 2 : 1; i < n; i++)
             {
@@ -846,9 +955,9 @@ void Combat_simulator::swing_main_hand(Sim_state& state, Extra_attack_chain chai
                 total_damage += hit_outcome.damage;
                 if (hit_outcome.hit_result != Hit_result::miss && hit_outcome.hit_result != Hit_result::dodge)
                 {
-                    maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
+                    maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
                     unbridled_wrath(state, weapon);
-                    hit_effects(state, hit_outcome.hit_result, weapon, Hit_type::next_melee, chain);
+                    hit_effects(state, hit_outcome.hit_result, state.main_hand, Hit_type::next_melee, chain);
                 }
                 else if (hit_outcome.hit_result == Hit_result::dodge)
                 {
@@ -867,15 +976,15 @@ void Combat_simulator::swing_main_hand(Sim_state& state, Extra_attack_chain chai
 
     if (!white_replaced)
     {
-        auto damage = weapon.swing(state.special_stats);
+        auto damage = weapon.swing(state.special_stats());
         const auto& hit_outcome = generate_hit(state, weapon, hit_table_white_mh_, damage);
         buff_manager_.remove_charge(windfury_attack_, time_keeper_.time, logger_);
         if (hit_outcome.hit_result != Hit_result::miss && hit_outcome.hit_result != Hit_result::dodge)
         {
             gain_rage(rage_generation(state, hit_outcome, weapon));
-            maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
+            maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
             unbridled_wrath(state, weapon);
-            hit_effects(state, hit_outcome.hit_result, weapon, Hit_type::melee, chain);
+            hit_effects(state, hit_outcome.hit_result, state.main_hand, Hit_type::melee, chain);
         }
         else if (hit_outcome.hit_result == Hit_result::dodge)
         {
@@ -896,20 +1005,20 @@ void Combat_simulator::swing_off_hand(Sim_state& state)
 {
     auto& weapon = state.off_hand_weapon;
 
-    maybe_remove_flurry(state.flurry_charges, state.special_stats);
+    maybe_remove_flurry(state.flurry_charges, state.stats);
 
     auto is_queued = (ability_queue_manager.heroic_strike_queued && !config.dpr_settings.compute_dpr_hs_) || (ability_queue_manager.cleave_queued && !config.dpr_settings.compute_dpr_cl_);
     auto hit_table = is_queued ? hit_table_white_oh_queued_ : hit_table_white_oh_;
 
-    auto damage = weapon.swing(state.special_stats) * (1 + 0.05 * state.talents.dual_wield_specialization);
+    auto damage = weapon.swing(state.special_stats()) * (1 + 0.05 * state.talents.dual_wield_specialization);
     const auto& hit_outcome = generate_hit(state, weapon, hit_table, damage);
     buff_manager_.remove_charge(windfury_attack_, time_keeper_.time, logger_);
     if (hit_outcome.hit_result != Hit_result::miss && hit_outcome.hit_result != Hit_result::dodge)
     {
         gain_rage(rage_generation(state, hit_outcome, weapon));
-        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.special_stats);
+        maybe_gain_flurry(hit_outcome.hit_result, state.flurry_charges, state.stats);
         unbridled_wrath(state, weapon);
-        hit_effects(state, hit_outcome.hit_result, weapon, Hit_type::melee);
+        hit_effects(state, hit_outcome.hit_result, state.off_hand, Hit_type::melee);
     }
     else if (hit_outcome.hit_result == Hit_result::dodge)
     {
@@ -927,15 +1036,15 @@ void Combat_simulator::swing_off_hand(Sim_state& state)
 
 void Combat_simulator::update_swing_timers(Sim_state& state, double oldHaste)
 {
-    auto& mh = state.main_hand_weapon;
-    auto haste = state.special_stats.haste;
+    auto& mh = state.main_hand;
+    auto haste = state.special_stats().haste;
     auto current_time = time_keeper_.time;
 
     assert(mh.next_swing >= current_time);
 
     if (mh.next_swing == current_time)
     {
-        mh.next_swing = from_offset(1000 * mh.swing_speed / (1 + haste));
+        mh.next_swing = from_offset(1000 * mh.weapon.swing_speed / (1 + haste));
     }
     else if (haste != oldHaste)
     {
@@ -944,13 +1053,13 @@ void Combat_simulator::update_swing_timers(Sim_state& state, double oldHaste)
 
     if (!state.is_dual_wield) return;
 
-    auto& oh = state.off_hand_weapon;
+    auto& oh = state.off_hand;
 
     assert(oh.next_swing >= current_time);
 
     if (oh.next_swing == current_time)
     {
-        oh.next_swing = from_offset(1000 * oh.swing_speed / (1 + haste));
+        oh.next_swing = from_offset(1000 * oh.weapon.swing_speed / (1 + haste));
     }
     else if (haste != oldHaste)
     {
@@ -965,17 +1074,330 @@ void Combat_simulator::simulate(const Character& character, bool log_data)
 
 Distribution Combat_simulator::simulate(const Combat_simulator_config& config, const Character& character)
 {
-    Combat_simulator sim(config);
+    auto& sim = pooled(config);
     sim.simulate(character, false);
     return sim.get_dps_distribution();
 }
 
+Distribution Combat_simulator::schedule_search_gain(const Combat_simulator_config& config, const Character& character)
+{
+    auto searched_config = config;
+    searched_config.search_use_effect_schedule = true;
+    searched_config.target_precision = 0;
+    auto computed_config = searched_config;
+    computed_config.search_use_effect_schedule = false;
+
+    // with log_data the dps of every fight is kept, the chunks are merged in batch order
+    Combat_simulator searched(searched_config);
+    searched.simulate_parallel(character, true);
+    Combat_simulator computed(computed_config);
+    computed.simulate_parallel(character, true);
+
+    Distribution gain{};
+    for (size_t i = 0; i < searched.fight_dps_.size() && i < computed.fight_dps_.size(); ++i)
+    {
+        gain.add_sample(searched.fight_dps_[i] - computed.fight_dps_[i]);
+    }
+    return gain;
+}
+
 void Combat_simulator::simulate(const Character& character, const std::function<bool(const Distribution&)>& target, bool log_data)
 {
     // TODO(vigo) remove me soonish
     assert(!has_run);
     has_run = true;
 
+    run_batches(character, target, 0, log_data);
+
+    if (log_data)
+    {
+        normalize_timelapse();
+        prune_histogram();
+    }
+}
+
+void Combat_simulator::simulate(const Character& character, int first_batch, int n_batches, bool log_data)
+{
+    assert(!has_run);
+    has_run = true;
+
+    run_batches(character, [n_batches](const auto& d) { return d.samples() == n_batches; }, first_batch, log_data);
+}
+
+Combat_simulator::Fight_replay Combat_simulator::replay_fight(const Combat_simulator_config& config,
+                                                              const Character& character, int batch)
+{
+    auto replay_config = config;
+    replay_config.display_combat_debug = true;
+    Combat_simulator simulator(replay_config);
+    simulator.simulate(character, batch, 1);
+    return {simulator.get_dps_distribution().mean(), simulator.get_debug_topic()};
+}
+
+void Combat_simulator::simulate_parallel(const Character& character, bool log_data)
+{
+    assert(!has_run);
+    has_run = true;
+
+    if (log_data)
+    {
+        reset_time_lapse();
+        init_histogram();
+    }
+
+    // the chunks own the actual fights, but the use effects are needed for compute_use_effects_schedule() later on
+    add_use_effects(character);
+
+    const int n_threads = Parallel::thread_count(config.n_threads);
+    int next_batch = 0;
+    bool done = false;
+
+    // the simulators for the chunks are reset and reused from one round of chunks to the next
+    std::vector<Combat_simulator> chunk_sims;
+    chunk_sims.reserve(n_threads);
+    while (!done && next_batch < config.n_batches)
+    {
+        std::vector<std::pair<int, int>> chunks;
+        for (int i = 0; i < n_threads && next_batch < config.n_batches; i++)
+        {
+            int n = std::min(batches_per_chunk, config.n_batches - next_batch);
+            chunks.emplace_back(next_batch, n);
+            next_batch += n;
+        }
+
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            if (i < chunk_sims.size())
+            {
+                chunk_sims[i].reset(config);
+            }
+            else
+            {
+                chunk_sims.emplace_back(config);
+            }
+        }
+
+        Parallel::for_each_index(static_cast<int>(chunks.size()), [&](int i) {
+            chunk_sims[i].simulate(character, chunks[i].first, chunks[i].second, log_data);
+        }, n_threads);
+
+        // chunks that were simulated beyond the point of reaching the target precision are discarded
+        for (size_t i = 0; i < chunks.size(); i++)
+        {
+            const auto& chunk_sim = chunk_sims[i];
+            merge(chunk_sim);
+            if (is_precision_reached())
+            {
+                done = true;
+                break;
+            }
+        }
+    }
+
+    if (log_data)
+    {
+        normalize_timelapse();
+        prune_histogram();
+    }
+}
+
+bool Combat_simulator::is_precision_reached() const
+{
+    if (config.target_precision <= 0 || dps_distribution_.samples() < 2) return false;
+
+    static const double q95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
+    const double std_of_the_mean = config.control_variates ? dps_control_variates_.std_of_the_mean() :
+                                                             get_dps_std_of_the_mean();
+    return q95 * std_of_the_mean <= config.target_precision;
+}
+
+double Combat_simulator::get_dps_std_of_the_mean() const
+{
+    if (config.antithetic_batches && antithetic_pair_dps_.samples() >= 2) return antithetic_pair_dps_.std_of_the_mean();
+    return dps_distribution_.std_of_the_mean();
+}
+
+bool Combat_simulator::can_merge(const Combat_simulator& other) const
+{
+    if (other.damage_time_lapse_.empty()) return true;
+    if (damage_time_lapse_.empty()) return dps_distribution_.samples() == 0;
+    return damage_time_lapse_.size() == other.damage_time_lapse_.size() &&
+           damage_time_lapse_.front().size() == other.damage_time_lapse_.front().size();
+}
+
+void Combat_simulator::merge(const Combat_simulator& other)
+{
+    const int n = dps_distribution_.samples();
+    const int n_other = other.dps_distribution_.samples();
+    if (n_other == 0) return;
+    assert(can_merge(other));
+
+    auto merge_mean = [n, n_other](double mean, double mean_other) {
+        return (mean * n + mean_other * n_other) / (n + n_other);
+    };
+    flurry_uptime_ = merge_mean(flurry_uptime_, other.flurry_uptime_);
+    oh_queued_uptime_ = merge_mean(oh_queued_uptime_, other.oh_queued_uptime_);
+    rampage_uptime_ = merge_mean(rampage_uptime_, other.rampage_uptime_);
+    avg_rage_spent_executing_ = merge_mean(avg_rage_spent_executing_, other.avg_rage_spent_executing_);
+
+    dps_distribution_.add(other.dps_distribution_);
+    antithetic_pair_dps_.add(other.antithetic_pair_dps_);
+    dps_sketch_.add(other.dps_sketch_);
+    if (other.min_fight_.batch >= 0 && (min_fight_.batch < 0 || other.min_fight_.dps < min_fight_.dps))
+    {
+        min_fight_ = other.min_fight_;
+    }
+    if (other.max_fight_.batch >= 0 && (max_fight_.batch < 0 || other.max_fight_.dps > max_fight_.dps))
+    {
+        max_fight_ = other.max_fight_;
+    }
+    const bool continues_fights = n == 0 || (!fight_dps_.empty() && other.first_fight_ == first_fight_ + n);
+    if (continues_fights && other.fight_dps_.size() == static_cast<size_t>(n_other))
+    {
+        if (n == 0) first_fight_ = other.first_fight_;
+        fight_dps_.insert(fight_dps_.end(), other.fight_dps_.begin(), other.fight_dps_.end());
+    }
+    else
+    {
+        fight_dps_.clear();
+    }
+    dps_control_variates_.add(other.dps_control_variates_);
+    if (fight_lengths_.empty()) fight_lengths_ = other.fight_lengths_;
+    fight_length_dps_.resize(other.fight_length_dps_.size());
+    for (size_t i = 0; i < other.fight_length_dps_.size(); ++i)
+    {
+        fight_length_dps_[i].add(other.fight_length_dps_[i]);
+    }
+    damage_distribution_ += other.damage_distribution_;
+
+    rage_gained_ += other.rage_gained_;
+    rage_spent_ += other.rage_spent_;
+    rage_lost_stance_swap_ += other.rage_lost_stance_swap_;
+    rage_lost_capped_ += other.rage_lost_capped_;
+
+    for (const auto& proc : other.proc_data_)
+    {
+        proc_data_[proc.first] += proc.second;
+    }
+    longest_hit_chain_ = std::max(longest_hit_chain_, other.longest_hit_chain_);
+    for (const auto& aura : other.aura_uptimes_)
+    {
+        aura_uptimes_[aura.first] += aura.second;
+    }
+
+    if (damage_time_lapse_.empty())
+    {
+        if (n == 0) damage_time_lapse_ = other.damage_time_lapse_;
+    }
+    else if (!other.damage_time_lapse_.empty() && can_merge(other))
+    {
+        for (size_t i = 0; i < damage_time_lapse_.size(); i++)
+        {
+            for (size_t j = 0; j < damage_time_lapse_[i].size(); j++)
+            {
+                damage_time_lapse_[i][j] += other.damage_time_lapse_[i][j];
+            }
+        }
+    }
+    if (!other.hist_y.empty())
+    {
+        while (hist_y.size() < other.hist_y.size())
+        {
+            hist_x.push_back(static_cast<int>(hist_x.size()) * histogram_dps_resolution);
+            hist_y.push_back(0);
+        }
+        for (size_t i = 0; i < other.hist_y.size(); i++)
+        {
+            hist_y[i] += other.hist_y[i];
+        }
+    }
+}
+
+void Combat_simulator::save_results(std::ostream& os) const
+{
+    Binary_writer writer{os};
+    dps_distribution_.save(writer);
+    antithetic_pair_dps_.save(writer);
+    dps_sketch_.save(writer);
+    writer.write(min_fight_.batch);
+    writer.write(min_fight_.dps);
+    writer.write(max_fight_.batch);
+    writer.write(max_fight_.dps);
+    writer.write(first_fight_);
+    writer.write(fight_dps_);
+    dps_control_variates_.save(writer);
+    writer.write(fight_lengths_);
+    writer.write(static_cast<uint64_t>(fight_length_dps_.size()));
+    for (const auto& distribution : fight_length_dps_)
+    {
+        distribution.save(writer);
+    }
+    writer.write(damage_distribution_.damage);
+    writer.write(damage_distribution_.counts);
+
+    writer.write(flurry_uptime_);
+    writer.write(oh_queued_uptime_);
+    writer.write(rampage_uptime_);
+    writer.write(avg_rage_spent_executing_);
+    writer.write(rage_gained_);
+    writer.write(rage_spent_);
+    writer.write(rage_lost_stance_swap_);
+    writer.write(rage_lost_capped_);
+
+    writer.write_map(proc_data_);
+    writer.write(longest_hit_chain_);
+    writer.write_map(aura_uptimes_);
+    writer.write(damage_time_lapse_);
+    writer.write(hist_x);
+    writer.write(hist_y);
+}
+
+bool Combat_simulator::load_results(std::istream& is)
+{
+    Binary_reader reader{is};
+    dps_distribution_.load(reader);
+    antithetic_pair_dps_.load(reader);
+    dps_sketch_.load(reader);
+    reader.read(min_fight_.batch);
+    reader.read(min_fight_.dps);
+    reader.read(max_fight_.batch);
+    reader.read(max_fight_.dps);
+    reader.read(first_fight_);
+    reader.read(fight_dps_);
+    dps_control_variates_.load(reader);
+    reader.read(fight_lengths_);
+    uint64_t n_fight_lengths{};
+    reader.read(n_fight_lengths);
+    if (!reader.good() || n_fight_lengths != fight_lengths_.size()) return false;
+    fight_length_dps_.assign(n_fight_lengths, {});
+    for (auto& distribution : fight_length_dps_)
+    {
+        distribution.load(reader);
+    }
+    reader.read(damage_distribution_.damage);
+    reader.read(damage_distribution_.counts);
+
+    reader.read(flurry_uptime_);
+    reader.read(oh_queued_uptime_);
+    reader.read(rampage_uptime_);
+    reader.read(avg_rage_spent_executing_);
+    reader.read(rage_gained_);
+    reader.read(rage_spent_);
+    reader.read(rage_lost_stance_swap_);
+    reader.read(rage_lost_capped_);
+
+    reader.read_map(proc_data_);
+    reader.read(longest_hit_chain_);
+    reader.read_map(aura_uptimes_);
+    reader.read(damage_time_lapse_);
+    reader.read(hist_x);
+    reader.read(hist_y);
+    return reader.good();
+}
+
+void Combat_simulator::run_batches(const Character& character, const std::function<bool(const Distribution&)>& target,
+                                   int first_batch, bool log_data)
+{
     if (log_data)
     {
         reset_time_lapse();
@@ -1039,42 +1461,97 @@ void Combat_simulator::simulate(const Character& character, const std::function<
     const int sim_time = to_millis(config.sim_time);
     const int time_execute_phase = to_millis(config.sim_time * (100.0 - config.execute_phase_percentage_) / 100.0);
 
+    // fight length sweep: damage done until the execute phase of every swept length starts, and until the one of
+    //  the simulated fight starts (for its execute phase dps)
+    fight_lengths_.clear();
+    for (double fight_length : config.fight_length_sweep)
+    {
+        if (fight_length > 0 && to_millis(fight_length) <= sim_time) fight_lengths_.push_back(fight_length);
+    }
+    // the checkpoints are passed in order, the config may come in any order
+    std::sort(fight_lengths_.begin(), fight_lengths_.end());
+    fight_lengths_.erase(std::unique(fight_lengths_.begin(), fight_lengths_.end(),
+                                     [](double a, double b) { return to_millis(a) == to_millis(b); }),
+                         fight_lengths_.end());
+    fight_length_dps_.resize(fight_lengths_.size());
+    std::vector<int> checkpoints;
+    if (!fight_lengths_.empty())
+    {
+        for (double fight_length : fight_lengths_)
+        {
+            checkpoints.push_back(to_millis(fight_length * (100.0 - config.execute_phase_percentage_) / 100.0));
+        }
+        checkpoints.push_back(time_execute_phase);
+    }
+    std::vector<double> checkpoint_damage(checkpoints.size());
+
+    const auto encounter = compile_encounter(config);
+    const bool encounter_has_adds = std::any_of(encounter.begin(), encounter.end(), [](const Encounter_event& event) {
+        return event.type == Encounter_event::Type::extra_targets;
+    });
+
     add_use_effects(character);
     add_over_time_effects(character);
 
     auto use_effect_schedule = compute_use_effects_schedule(character);
 
-    auto empty_hit_effects = std::vector<Hit_effect>();
-    if (is_dual_wield)
-    {
-        buff_manager_.initialize(weapons[0].hit_effects,weapons[1].hit_effects, use_effect_schedule, this);
-    }
-    else
+    // hit effects granted by use effects sit disabled on the weapons until the use effect activates them,
+    //  that way the weapons are complete (and read-only) before the first fight
+    for (const auto& scheduled : use_effect_schedule)
     {
-        buff_manager_.initialize(weapons[0].hit_effects,empty_hit_effects, use_effect_schedule, this);
+        const auto& use_effect = scheduled.second.get();
+        if (use_effect.hit_effects.empty()) continue;
+
+        for (size_t i = 0; i < (is_dual_wield ? 2 : 1); ++i)
+        {
+            auto& hit_effects = weapons[i].hit_effects;
+            if (std::any_of(hit_effects.begin(), hit_effects.end(), [&use_effect](auto& he) { return he.name == use_effect.name; })) continue;
+
+            auto& hit_effect = hit_effects.emplace_back(use_effect.hit_effects[0]);
+            hit_effect.sanitize();
+        }
     }
 
-    std::vector<Damage_instance> damage_instances{};
+    std::vector<Weapon_state> weapon_states(weapons.begin(), weapons.end());
+    buff_manager_.initialize(weapon_states[0], is_dual_wield ? &weapon_states[1] : nullptr, use_effect_schedule, this);
+
+    double previous_dps_sample{};
+    std::vector<double> previous_covariates{};
 
     while (!target(dps_distribution_))
     {
         ability_queue_manager.reset();
+        pending_hits_.clear();
         logger_.reset();
         slam_manager = Slam_manager(1500 - 500 * character.talents.improved_slam);
         rage = config.initial_rage;
         sunder_armor_stacks_ = config.n_sunder_armor_stacks;
+        roll_luck_ = {};
+
+        // every batch draws from its own stream, so it can be reproduced independently of the other batches. antithetic
+        //  pairs share one, the odd batch mirrored
+        const int batch = first_batch + dps_distribution_.samples();
+        if (config.antithetic_batches)
+        {
+            rng_.seed(config.seed, batch / 2, batch % 2 == 1);
+        }
+        else
+        {
+            rng_.seed(config.seed, batch);
+        }
 
-        // permute hit_effect order between runs - this isn't strictly necessary, but closer to what happens in-game, it seems
-        std::next_permutation(weapons[0].hit_effects.begin(), weapons[0].hit_effects.end(), [](const auto& he1, const auto& he2) { return he1.name < he2.name; });
-        if (is_dual_wield) std::next_permutation(weapons[1].hit_effects.begin(), weapons[1].hit_effects.end(), [](const auto& he1, const auto& he2) { return he1.name < he2.name; });
+        for (auto& weapon : weapon_states)
+        {
+            weapon.reset(rng_);
+        }
 
         Sim_state state(
-            weapons[0],
-            is_dual_wield ? weapons[1] : weapons[0],
+            weapon_states[0],
+            is_dual_wield ? weapon_states[1] : weapon_states[0],
             is_dual_wield,
             starting_special_stats,
             character.talents,
-            damage_instances,
+            damage_instances_,
             log_data
         );
 
@@ -1084,6 +1561,9 @@ void Combat_simulator::simulate(const Character& character, const std::function<
 
         apply_delayed_armor_reduction = false;
         bool in_execute_phase = false;
+        size_t next_encounter_event = 0;
+        int downtimes = 0; // overlapping windows nest
+        int target_switches = 0;
 
         double flurry_uptime = 0.0;
 
@@ -1092,18 +1572,11 @@ void Combat_simulator::simulate(const Character& character, const std::function<
         int oh_hits_w_queued = 0;
         int mh_hits_w_rampage = 0;
 
-        state.main_hand_weapon.next_swing = 0;
-        if (state.is_dual_wield) state.off_hand_weapon.next_swing = to_millis(0.5 * state.off_hand_weapon.swing_speed / (1 + state.special_stats.haste)); // de-sync mh/oh swing timers
+        state.main_hand.next_swing = 0;
+        if (state.is_dual_wield) state.off_hand.next_swing = to_millis(0.5 * state.off_hand_weapon.swing_speed / (1 + state.special_stats().haste)); // de-sync mh/oh swing timers
 
-        // Combat configuration
-        if (!config.multi_target_mode_)
-        {
-            number_of_extra_targets_ = 0;
-        }
-        else
-        {
-            number_of_extra_targets_ = config.number_of_extra_targets;
-        }
+        // the extra targets of multi target mode arrive with the first encounter event
+        number_of_extra_targets_ = 0;
 
         // Check if the simulator should use any use effects before the fight
         for (const auto& ue : use_effect_schedule)
@@ -1132,60 +1605,104 @@ void Combat_simulator::simulate(const Character& character, const std::function<
             ability_queue_manager.queue_heroic_strike();
         }
 
+        size_t next_checkpoint = 0;
+
         while (time_keeper_.time < sim_time)
         {
-            int next_mh_swing = state.main_hand_weapon.next_swing;
-            int next_oh_swing = state.is_dual_wield ? state.off_hand_weapon.next_swing : -1;
+            int next_mh_swing = state.main_hand.next_swing;
+            int next_oh_swing = state.is_dual_wield ? state.off_hand.next_swing : -1;
             int next_buff_event = buff_manager_.next_event(time_keeper_.time);
+            int next_encounter_time = next_encounter_event < encounter.size() ? encounter[next_encounter_event].time : sim_time;
             int next_slam_finish = slam_manager.next_finish();
-            int next_event = time_keeper_.get_next_event(next_mh_swing, next_oh_swing,
-                                                         next_buff_event, next_slam_finish, sim_time);
+            int next_event = time_keeper_.get_next_event(next_mh_swing, next_oh_swing, next_buff_event,
+                                                         next_encounter_time, next_slam_finish, sim_time);
+            while (next_checkpoint < checkpoints.size() && next_event >= checkpoints[next_checkpoint])
+            {
+                checkpoint_damage[next_checkpoint++] = state.damage_sources.sum_damage_sources();
+            }
             if (state.flurry_charges > 0) flurry_uptime += next_event - time_keeper_.time;
             time_keeper_.increment(next_event);
 
-            double oldHaste = state.special_stats.haste;
+            double oldHaste = state.special_stats().haste;
 
             buff_manager_.increment(time_keeper_, logger_);
 
-            if (buff_manager_.need_to_recompute_hit_tables)
+            if (state.stats.take_dirty(hit_table_inputs))
             {
-                compute_hit_tables(character, state.special_stats, state.main_hand_weapon);
+                compute_hit_tables(character, state.special_stats(), state.main_hand_weapon);
                 if (state.is_dual_wield)
                 {
-                    compute_hit_tables(character, state.special_stats, state.off_hand_weapon);
+                    compute_hit_tables(character, state.special_stats(), state.off_hand_weapon);
                 }
-                compute_hit_table_stats_ = state.special_stats;
-
-                buff_manager_.need_to_recompute_hit_tables = false;
+                compute_hit_table_stats_ = state.special_stats();
             }
 
-            if (buff_manager_.need_to_recompute_mitigation)
+            if (state.stats.take_dirty(mitigation_inputs))
             {
                 recompute_mitigation_ = true;
-                buff_manager_.need_to_recompute_mitigation = false;
             }
 
-            if (!apply_delayed_armor_reduction && time_keeper_.time >= 6000 && config.exposed_armor)
+            while (next_encounter_event < encounter.size() && encounter[next_encounter_event].time <= time_keeper_.time)
             {
-                apply_delayed_armor_reduction = true;
-                recompute_mitigation_ = true;
-                logger_.print("Applying improved exposed armor!");
+                const auto& event = encounter[next_encounter_event++];
+                switch (event.type)
+                {
+                case Encounter_event::Type::armor_reduction:
+                    apply_delayed_armor_reduction = true;
+                    recompute_mitigation_ = true;
+                    logger_.print("Applying improved exposed armor!");
+                    break;
+                case Encounter_event::Type::execute_phase:
+                    logger_.print("------------ Execute phase! ------------");
+                    in_execute_phase = true;
+                    break;
+                case Encounter_event::Type::extra_targets:
+                    number_of_extra_targets_ = std::max(number_of_extra_targets_ + event.value, 0);
+                    if (event.value > 0)
+                    {
+                        logger_.print(event.value, " extra targets arrive.");
+                    }
+                    else
+                    {
+                        logger_.print("Extra targets die.");
+                    }
+                    break;
+                case Encounter_event::Type::downtime_start:
+                    if (downtimes++ == 0) logger_.print("Downtime, nothing to attack.");
+                    break;
+                case Encounter_event::Type::downtime_end:
+                    if (--downtimes == 0) logger_.print("Downtime ends.");
+                    break;
+                case Encounter_event::Type::target_switch_start:
+                    if (target_switches++ == 0) logger_.print("Switching to an add.");
+                    recompute_mitigation_ = true;
+                    break;
+                case Encounter_event::Type::target_switch_end:
+                    if (--target_switches == 0) logger_.print("Switching back to the boss.");
+                    recompute_mitigation_ = true;
+                    break;
+                }
             }
 
             if (recompute_mitigation_)
             {
                 int target_armor =
-                    config.main_target_initial_armor_ - armor_reduction_from_spells_ - state.special_stats.gear_armor_pen - 520 * sunder_armor_stacks_;
+                    config.main_target_initial_armor_ - armor_reduction_from_spells_ - state.special_stats().gear_armor_pen - 520 * sunder_armor_stacks_;
                 if (apply_delayed_armor_reduction)
                 {
                     target_armor -= armor_reduction_delayed_ - 520 * sunder_armor_stacks_;
                 }
+                if (target_switches > 0)
+                {
+                    // the debuffs stay on the boss
+                    target_armor = config.extra_target_initial_armor_ - state.special_stats().gear_armor_pen;
+                }
                 target_armor = std::max(target_armor, 0);
                 armor_reduction_factor_ = armor_reduction_factor(target_armor);
                 logger_.print("Target armor: ", target_armor, ". Mitigation factor: ", 100 * (1 - armor_reduction_factor_), "%.");
-                if (config.multi_target_mode_)
+                if (config.multi_target_mode_ || encounter_has_adds)
                 {
-                    int extra_target_armor = config.extra_target_initial_armor_ - state.special_stats.gear_armor_pen;
+                    int extra_target_armor = config.extra_target_initial_armor_ - state.special_stats().gear_armor_pen;
                     extra_target_armor = std::max(extra_target_armor, 0);
                     armor_reduction_factor_add = armor_reduction_factor(extra_target_armor);
 
@@ -1195,13 +1712,6 @@ void Combat_simulator::simulate(const Character& character, const std::function<
                 recompute_mitigation_ = false;
             }
 
-            if (config.multi_target_mode_ && number_of_extra_targets_ > 0 &&
-                time_keeper_.time >= sim_time * config.extra_target_percentage / 100)
-            {
-                logger_.print("Extra targets die.");
-                number_of_extra_targets_ = 0;
-            }
-
             if (slam_manager.is_slam_casting())
             {
                 if (!slam_manager.ready(time_keeper_.time))
@@ -1213,16 +1723,22 @@ void Combat_simulator::simulate(const Character& character, const std::function<
                 slam(state);
                 slam_manager.finish_slam();
 
-                state.main_hand_weapon.next_swing = from_offset(1000 * state.main_hand_weapon.swing_speed / (1 + state.special_stats.haste));
+                state.main_hand.next_swing = from_offset(1000 * state.main_hand_weapon.swing_speed / (1 + state.special_stats().haste));
                 if (state.is_dual_wield)
                 {
-                    state.off_hand_weapon.next_swing = from_offset(1000 * state.off_hand_weapon.swing_speed / (1 + state.special_stats.haste));
+                    state.off_hand.next_swing = from_offset(1000 * state.off_hand_weapon.swing_speed / (1 + state.special_stats().haste));
                 }
-                oldHaste = state.special_stats.haste; // keep update_swing_timer() from applying haste changes again
+                oldHaste = state.special_stats().haste; // keep update_swing_timer() from applying haste changes again
+            }
+
+            if (downtimes > 0)
+            {
+                update_swing_timers(state, oldHaste); // the swings that come due go nowhere
+                continue;
             }
 
-            bool mh_swing = state.main_hand_weapon.next_swing == time_keeper_.time;
-            bool oh_swing = state.is_dual_wield && state.off_hand_weapon.next_swing == time_keeper_.time;
+            bool mh_swing = state.main_hand.next_swing == time_keeper_.time;
+            bool oh_swing = state.is_dual_wield && state.off_hand.next_swing == time_keeper_.time;
 
             if (mh_swing)
             {
@@ -1244,15 +1760,6 @@ void Combat_simulator::simulate(const Character& character, const std::function<
                 swing_off_hand(state);
             }
 
-            if (!in_execute_phase)
-            {
-                if (time_keeper_.time > time_execute_phase)
-                {
-                    logger_.print("------------ Execute phase! ------------");
-                    in_execute_phase = true;
-                }
-            }
-
             if (use_sweeping_strikes_)
             {
                 if (time_keeper_.sweeping_strikes_ready() && time_keeper_.global_ready() && rage >= 30)
@@ -1282,7 +1789,7 @@ void Combat_simulator::simulate(const Character& character, const std::function<
             {
                 if (time_keeper_.rampage_ready() && state.rampage_stacks > 0)
                 {
-                    state.special_stats -= {0, 0, 50.0 * state.rampage_stacks};
+                    state.stats.remove(rampage_stack_, state.rampage_stacks);
                     state.rampage_stacks = 0;
                     logger_.print("Rampage fades.");
                 }
@@ -1318,10 +1825,53 @@ void Combat_simulator::simulate(const Character& character, const std::function<
 
         double dps_sample = state.damage_sources.sum_damage_sources() * 1000 / sim_time;
         dps_distribution_.add_sample(dps_sample);
+        dps_sketch_.add_sample(dps_sample);
+        if (min_fight_.batch < 0 || dps_sample < min_fight_.dps) min_fight_ = {batch, dps_sample};
+        if (max_fight_.batch < 0 || dps_sample > max_fight_.dps) max_fight_ = {batch, dps_sample};
+        if (log_data)
+        {
+            if (fight_dps_.empty()) first_fight_ = batch;
+            fight_dps_.push_back(dps_sample);
+        }
+        const std::vector<double> covariates{roll_luck_.crits, roll_luck_.avoided, roll_luck_.extra_attacks, roll_luck_.procs};
+        if (!config.antithetic_batches)
+        {
+            dps_control_variates_.add_sample(dps_sample, covariates);
+        }
+        else if (batch % 2 == 1 && batch > first_batch)
+        {
+            // the regression would take the twins for independent samples, it gets the pair means instead
+            std::vector<double> pair_covariates(covariates.size());
+            for (size_t i = 0; i < covariates.size(); ++i)
+            {
+                pair_covariates[i] = (previous_covariates[i] + covariates[i]) / 2;
+            }
+            dps_control_variates_.add_sample((previous_dps_sample + dps_sample) / 2, pair_covariates);
+            antithetic_pair_dps_.add_sample((previous_dps_sample + dps_sample) / 2);
+        }
+        previous_dps_sample = dps_sample;
+        previous_covariates = covariates;
 
         int num_samples = dps_distribution_.samples();
 
-        damage_distribution_ = damage_distribution_ + state.damage_sources;
+        damage_distribution_ += state.damage_sources;
+
+        if (!fight_lengths_.empty())
+        {
+            const double total_damage = state.damage_sources.sum_damage_sources();
+            while (next_checkpoint < checkpoints.size())
+            {
+                checkpoint_damage[next_checkpoint++] = total_damage;
+            }
+            const int execute_time = sim_time - time_execute_phase;
+            const double execute_dpms = execute_time > 0 ? (total_damage - checkpoint_damage.back()) / execute_time : 0.0;
+            for (size_t i = 0; i < fight_lengths_.size(); ++i)
+            {
+                const int fight_time = to_millis(fight_lengths_[i]);
+                const double damage = checkpoint_damage[i] + execute_dpms * (fight_time - checkpoints[i]);
+                fight_length_dps_[i].add_sample(damage * 1000 / fight_time);
+            }
+        }
 
         rampage_uptime_ = Statistics::update_mean(rampage_uptime_, num_samples, double(mh_hits_w_rampage) / mh_hits);
         if (is_dual_wield)
@@ -1334,26 +1884,21 @@ void Combat_simulator::simulate(const Character& character, const std::function<
         if (log_data)
         {
             add_damage_source_to_time_lapse(state.damage_instances);
-            hist_y[static_cast<int>(dps_sample / histogram_dps_resolution)]++;
+            add_to_histogram(dps_sample);
         }
     }
 
-    for (const auto& he : weapons[0].hit_effects)
-    {
-        proc_data_[he.name] += he.procs;
-    }
-    if (is_dual_wield)
+    for (const auto& weapon : weapon_states)
     {
-        for (const auto& he : weapons[1].hit_effects)
+        for (size_t i = 0; i < weapon.procs.size(); ++i)
         {
-            proc_data_[he.name] += he.procs;
+            proc_data_[weapon.weapon.hit_effects[i].name] += weapon.procs[i];
         }
     }
 
-    if (log_data)
+    for (const auto& aura : buff_manager_.get_aura_uptimes_map())
     {
-        normalize_timelapse();
-        prune_histogram();
+        aura_uptimes_[aura.first] += aura.second;
     }
 }
 
@@ -1371,7 +1916,7 @@ void Combat_simulator::execute_phase(Sim_state& state, bool mh_swing)
             spend_rage(20);
             if (state.rampage_stacks == 0)
             {
-                state.special_stats += {0, 0, 50};
+                state.stats.add(rampage_stack_);
                 state.rampage_stacks = 1;
             }
             logger_.print("Rampage!");
@@ -1458,7 +2003,7 @@ void Combat_simulator::normal_phase(Sim_state& state, bool mh_swing)
             spend_rage(20);
             if (state.rampage_stacks == 0)
             {
-                state.special_stats += {0, 0, 50};
+                state.stats.add(rampage_stack_);
                 state.rampage_stacks = 1;
             }
             logger_.print("Rampage!");
@@ -1757,7 +2302,12 @@ Use_effects::Schedule Combat_simulator::compute_use_effects_schedule(const Chara
         ap_equiv = get_character_ap_equivalent(character.total_special_stats, character.weapons[0],
                                                sim_time, {});
     }
-    return Use_effects::compute_schedule(use_effects_, character.total_special_stats, sim_time, ap_equiv, config.reverse_cooldown);
+    auto schedule = Use_effects::compute_schedule(use_effects_, character.total_special_stats, sim_time, ap_equiv, config.reverse_cooldown);
+    if (config.search_use_effect_schedule)
+    {
+        Use_effects::optimize_schedule(schedule, character.total_special_stats, sim_time, ap_equiv);
+    }
+    return schedule;
 }
 
 void Combat_simulator::init_histogram()
@@ -1771,13 +2321,25 @@ void Combat_simulator::init_histogram()
     hist_y.assign(n, 0);
 }
 
+void Combat_simulator::add_to_histogram(double dps_sample)
+{
+    // grows beyond the initial range if needed, instead of writing past the end for very high dps
+    const auto idx = static_cast<size_t>(dps_sample / histogram_dps_resolution);
+    while (idx >= hist_y.size())
+    {
+        hist_x.push_back(static_cast<int>(hist_x.size()) * histogram_dps_resolution);
+        hist_y.push_back(0);
+    }
+    hist_y[idx]++;
+}
+
 void Combat_simulator::normalize_timelapse()
 {
     for (auto& damage_time_lapse_i : damage_time_lapse_)
     {
         for (auto& singe_damage_instance : damage_time_lapse_i)
         {
-            singe_damage_instance /= config.n_batches;
+            singe_damage_instance /= dps_distribution_.samples();
         }
     }
 }
@@ -1800,37 +2362,37 @@ void Combat_simulator::prune_histogram()
     hist_y = std::vector<int>(&hist_y[start_idx], &hist_y[end_idx] + 1);
 }
 
-std::vector<std::string> Combat_simulator::get_aura_uptimes() const
+std::vector<std::pair<std::string, double>> Combat_simulator::get_aura_uptimes() const
 {
-    std::vector<std::string> aura_uptimes;
-    double total_sim_time = config.n_batches * config.sim_time;
-    for (const auto& aura : buff_manager_.get_aura_uptimes_map())
+    std::vector<std::pair<std::string, double>> aura_uptimes;
+    double total_sim_time = dps_distribution_.samples() * config.sim_time;
+    for (const auto& aura : aura_uptimes_)
     {
         double uptime = aura.second / total_sim_time;
-        aura_uptimes.emplace_back(aura.first + " " + std::to_string(100 * uptime));
+        aura_uptimes.emplace_back(aura.first, 100 * uptime);
     }
     if (flurry_uptime_ != 0.0)
     {
-        aura_uptimes.emplace_back("Flurry " + std::to_string(100 * flurry_uptime_));
+        aura_uptimes.emplace_back("Flurry", 100 * flurry_uptime_);
     }
     if (oh_queued_uptime_ != 0.0)
     {
-        aura_uptimes.emplace_back("'Heroic_strike_bug' " + std::to_string(100 * oh_queued_uptime_));
+        aura_uptimes.emplace_back("'Heroic_strike_bug'", 100 * oh_queued_uptime_);
     }
     if (rampage_uptime_ != 0.0)
     {
-        aura_uptimes.emplace_back("Rampage " + std::to_string(100 * rampage_uptime_));
+        aura_uptimes.emplace_back("Rampage", 100 * rampage_uptime_);
     }
     return aura_uptimes;
 }
 
-std::vector<std::string> Combat_simulator::get_proc_statistics() const
+std::vector<std::pair<std::string, double>> Combat_simulator::get_proc_statistics() const
 {
-    std::vector<std::string> proc_counter;
+    std::vector<std::pair<std::string, double>> proc_counter;
     for (const auto& proc : proc_data_)
     {
-        double counter = static_cast<double>(proc.second) / config.n_batches;
-        proc_counter.emplace_back(proc.first + " " + std::to_string(counter));
+        double counter = static_cast<double>(proc.second) / dps_distribution_.samples();
+        proc_counter.emplace_back(proc.first, counter);
     }
     return proc_counter;
 }
@@ -1853,6 +2415,30 @@ void Combat_simulator::add_damage_source_to_time_lapse(const std::vector<Damage_
     }
 }
 
+std::vector<std::pair<std::string, Combat_simulator::Fight_record>> Combat_simulator::get_notable_fights() const
+{
+    std::vector<std::pair<std::string, Fight_record>> fights{};
+    if (min_fight_.batch < 0) return fights;
+
+    fights.emplace_back("min", min_fight_);
+    if (!fight_dps_.empty() && fight_dps_.size() == static_cast<size_t>(dps_distribution_.samples()))
+    {
+        std::vector<size_t> order(fight_dps_.size());
+        std::iota(order.begin(), order.end(), size_t{0});
+        auto lower_dps = [this](size_t a, size_t b) {
+            return fight_dps_[a] < fight_dps_[b] || (fight_dps_[a] == fight_dps_[b] && a < b);
+        };
+        for (const auto& [name, quantile] : {std::pair<const char*, double>{"p5", 0.05}, {"median", 0.5}, {"p95", 0.95}})
+        {
+            const auto nth = order.begin() + static_cast<std::ptrdiff_t>(std::round(quantile * (order.size() - 1)));
+            std::nth_element(order.begin(), nth, order.end(), lower_dps);
+            fights.emplace_back(name, Fight_record{first_fight_ + static_cast<int>(*nth), fight_dps_[*nth]});
+        }
+    }
+    fights.emplace_back("max", max_fight_);
+    return fights;
+}
+
 std::string Combat_simulator::get_debug_topic() const
 {
     return logger_.get_debug_topic();
@@ -1,15 +1,21 @@
-
 #include "Config.hpp"
 
+#include <algorithm>
+#include <iostream>
+
 Combat_simulator_config::Combat_simulator_config(const Sim_input& input)
 {
-    parse_combat_simulator_config(input);
+    Option_index options{input.options, input.float_options_string, input.float_options_val};
+    *this = Combat_simulator_config{input, options};
+}
+
+Combat_simulator_config::Combat_simulator_config(const Sim_input& input, Option_index& options)
+{
+    parse_combat_simulator_config(options);
 
-    n_batches = static_cast<int>(
-        String_helpers::find_value(input.float_options_string, input.float_options_val, "n_simulations_dd"));
-    if (String_helpers::find_string(input.options, "item_strengths") ||
-        String_helpers::find_string(input.options, "wep_strengths") || !input.stat_weights.empty() ||
-        String_helpers::find_string(input.options, "compute_dpr"))
+    n_batches = static_cast<int>(options.value("n_simulations_dd"));
+    if (options.has("item_strengths") || options.has("wep_strengths") || !input.stat_weights.empty() ||
+        options.has("compute_dpr"))
     {
         if (n_batches < 100000)
         {
@@ -18,5 +24,146 @@ Combat_simulator_config::Combat_simulator_config(const Sim_input& input)
             //n_batches = 100000;
         }
     }
+    // both optional - by default all n_batches are simulated, on all available threads
+    target_precision = options.find("target_precision_dd", 0);
+    control_variates = options.has("control_variates");
+    antithetic_batches = options.has("antithetic_batches");
+    n_threads = static_cast<int>(options.find("n_threads_dd", 0));
     seed = 110000;
+
+    // read even without the sweep, so that they count as known options
+    const double min_time = options.find("fight_length_sweep_min_dd", 120);
+    const double max_time = options.find("fight_length_sweep_max_dd", 600);
+    const double step = std::max(options.find("fight_length_sweep_step_dd", 60), 1.0);
+    if (options.has("fight_length_sweep"))
+    {
+        for (double t = min_time; t <= max_time + 1e-9; t += step)
+        {
+            fight_length_sweep.push_back(t);
+        }
+    }
+
+    // up to max_encounter_windows windows of each kind, e.g. adds_2_start_dd, adds_2_end_dd and adds_2_count_dd (s)
+    const std::vector<std::pair<std::string, Encounter_window::Type>> window_kinds{
+        {"adds", Encounter_window::Type::adds},
+        {"downtime", Encounter_window::Type::downtime},
+        {"target_switch", Encounter_window::Type::target_switch},
+    };
+    for (const auto& [name, type] : window_kinds)
+    {
+        for (int i = 1; i <= max_encounter_windows; ++i)
+        {
+            const auto prefix = name + "_" + std::to_string(i);
+            const double start = options.find(prefix + "_start_dd", -1);
+            const double end = options.find(prefix + "_end_dd", -1);
+            int count = 0;
+            if (type == Encounter_window::Type::adds)
+            {
+                count = static_cast<int>(options.find(prefix + "_count_dd", 1));
+            }
+            if (start >= 0 && end > start)
+            {
+                encounter_windows.push_back({type, start, end, count});
+            }
+        }
+    }
+}
+
+void Combat_simulator_config::parse_combat_simulator_config(Option_index& options)
+{
+    // n_batches - set from e.g. n_simulations_talent_dd
+
+    // combat_debug - special run mode "debug on"
+    // seed - only used in multi, at the moment
+
+    sim_time = options.find("fight_time_dd"); // TODO(vigo) probably convert to millis as well - but this is kinda infiltrative
+
+    main_target_level = options.find("opponent_level_dd");
+    main_target_initial_armor_ = options.find("boss_armor_dd");
+
+    n_sunder_armor_stacks = options.find("sunder_armor_dd");
+    exposed_armor = options.has("exposed_armor");
+    curse_of_recklessness_active = options.has("curse_of_recklessness");
+    faerie_fire_feral_active = options.has("faerie_fire");
+
+    multi_target_mode_ = options.has("multi_target_mode");
+    number_of_extra_targets = options.find("number_of_extra_targets_dd");
+    extra_target_percentage = options.find("extra_target_percentage_dd", 100); // renamed from extra_target_duration
+    extra_target_initial_armor_ = options.find("extra_target_armor_dd");
+    // extra_target_level isn't currently supported (it would require a second set of hit tables)
+
+    take_periodic_damage_ = options.has("periodic_damage");
+    periodic_damage_amount_ = options.find("periodic_damage_amount_dd");
+    periodic_damage_interval_ = options.find("periodic_damage_interval_dd");
+    essence_of_the_red_ = options.has("essence_of_the_red");
+
+    execute_phase_percentage_ = options.find("execute_phase_percentage_dd");
+
+    initial_rage = options.find("initial_rage_dd");
+    sunder_armor_globals_ = options.find("sunder_armor_globals_dd", 0);
+
+    solarians_sapphire_preshout = options.has("solarians_sapphire_preshout");
+    t2_set_preshout = options.has("t2_set_preshout");
+
+    enable_bloodrage = true;
+    enable_recklessness = options.has("recklessness");
+    enable_blood_fury = options.has("enable_blood_fury");
+    enable_berserking = options.has("enable_berserking");
+    berserking_haste_ = options.find("berserking_haste_dd");
+    use_death_wish = options.has("death_wish");
+    use_sweeping_strikes = options.has("use_sweeping_strikes");
+    enable_extra_bloodlust = options.has("enable_extra_bloodlust");
+    extra_bloodlust_count_ = options.find("extra_bloodlust_dd");
+    reverse_cooldown = options.has("reverse_cooldown");
+    search_use_effect_schedule = options.has("search_use_effect_schedule");
+
+    enable_unleashed_rage = options.has("enable_unleashed_rage");
+    unleashed_rage_start_ = options.find("unleashed_rage_dd");
+
+    deep_wounds = options.has("deep_wounds");
+
+    combat.use_bloodthirst = options.has("use_bloodthirst");
+    combat.use_bt_in_exec_phase = options.has("use_bt_in_exec_phase");
+    combat.bt_whirlwind_cooldown_thresh = to_millis(options.find("bt_whirlwind_cooldown_thresh_dd"));
+
+    combat.use_mortal_strike = options.has("use_mortal_strike");
+    combat.use_ms_in_exec_phase = options.has("use_ms_in_exec_phase");
+    combat.ms_whirlwind_cooldown_thresh = to_millis(options.find("ms_whirlwind_cooldown_thresh_dd"));
+
+    combat.use_whirlwind = options.has("use_whirlwind");
+    combat.use_ww_in_exec_phase = options.has("use_ww_in_exec_phase");
+    combat.whirlwind_rage_thresh = options.find("whirlwind_rage_thresh_dd");
+    combat.whirlwind_bt_cooldown_thresh = to_millis(options.find("whirlwind_bt_cooldown_thresh_dd"));
+
+    combat.use_slam = options.has("use_slam");
+    combat.use_sl_in_exec_phase = options.has("use_sl_in_exec_phase");
+    combat.slam_rage_thresh = options.find("slam_rage_thresh_dd", 0); // renamed from slam_rage
+    combat.slam_spam_max_time = to_millis(options.find("slam_spam_max_time_dd"));
+    combat.slam_spam_rage = options.find("slam_spam_rage_dd");
+    combat.slam_latency = to_millis(options.find("slam_latency_dd"));
+
+    combat.use_rampage = options.has("use_rampage");
+    combat.rampage_use_thresh = to_millis(options.find("rampage_use_thresh_dd"));
+
+    combat.use_heroic_strike = options.has("use_heroic_strike");
+    combat.use_hs_in_exec_phase = options.has("use_hs_in_exec_phase");
+    combat.first_hit_heroic_strike = options.has("first_hit_heroic_strike");
+    combat.heroic_strike_rage_thresh = options.find("heroic_strike_rage_thresh_dd");
+
+    combat.cleave_if_adds = options.has("cleave_if_adds");
+    combat.cleave_rage_thresh = options.find("cleave_rage_thresh_dd");
+
+    combat.use_overpower = options.has("use_overpower");
+    combat.overpower_rage_thresh = options.find("overpower_rage_thresh_dd");
+    combat.overpower_bt_cooldown_thresh = to_millis(options.find("overpower_bt_cooldown_thresh_dd"));
+    combat.overpower_ww_cooldown_thresh = to_millis(options.find("overpower_ww_cooldown_thresh_dd"));
+
+    combat.use_hamstring = options.has("use_hamstring");
+    combat.hamstring_rage_thresh = options.find("hamstring_rage_thresh_dd", 70); // renamed from hamstring_thresh
+    combat.hamstring_cd_thresh = to_millis(options.find("hamstring_cd_thresh_dd"));
+    combat.dont_use_hm_when_ss = options.has("dont_use_hm_when_ss");
+
+    combat.use_sunder_armor = options.has("use_sunder_armor");
+    combat.sunder_armor_rage_thresh = options.find("sunder_armor_rage_thresh_dd", 0);
+    combat.sunder_armor_cd_thresh = to_millis(options.find("sunder_armor_cd_thresh_dd"));
 }
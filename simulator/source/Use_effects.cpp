@@ -1,6 +1,7 @@
 #include "Use_effects.hpp"
 
 #include <algorithm>
+#include <cmath>
 
 int Use_effects::is_time_available(const Schedule& schedule, int check_time, int duration)
 {
@@ -136,6 +137,195 @@ Use_effects::Schedule Use_effects::compute_schedule(std::vector<Use_effect>& use
     return schedule;
 }
 
+namespace
+{
+// damage while an effect is up, relative to without it. ap and crit add up with the other effects,
+//  haste and damage modifiers multiply
+struct Surrogate_gain
+{
+    double additive{};
+    double multiplier{1};
+};
+
+Surrogate_gain surrogate_gain(const Use_effect& use_effect, const Special_stats& special_stats, double total_ap)
+{
+    const auto stats = use_effect.to_special_stats(special_stats);
+
+    Surrogate_gain gain;
+    gain.additive = stats.attack_power / std::max(total_ap, 1.0) + stats.critical_strike / 100;
+    if (use_effect.name == "badge_of_the_swarmguard")
+    {
+        gain.additive += 0.07; // same guess as in estimate_power()
+    }
+    gain.multiplier = (1 + stats.haste) * (1 + stats.attack_speed) * (1 + stats.damage_mod_physical) * (1 + stats.ap_multiplier);
+    return gain;
+}
+
+// timed by the raid or by rage rather than by damage - they stay where they are, but the others still line up with them
+bool is_pinned(const Use_effect& use_effect)
+{
+    const auto& name = use_effect.name;
+    return use_effect.cooldown <= 0 || name == "battle_shout" || name == "battle_shout_preshout_bonus" ||
+           name == "unleashed_rage" || name == "bloodlust" || name == "extra_bloodlust";
+}
+
+struct Activation
+{
+    Use_effects::Use_effect_ref use_effect;
+    Surrogate_gain gain;
+    int time; // as computed, kept for pinned ones
+    int cell;
+    int duration;
+    int spacing; // cooldown, in cells
+    bool shared;
+    bool pinned;
+};
+
+class Timeline
+{
+public:
+    explicit Timeline(int n_cells) : additive_(n_cells, 0.0), multiplier_(n_cells, 1.0) {}
+
+    [[nodiscard]] int size() const { return static_cast<int>(additive_.size()); }
+
+    void add(const Activation& activation)
+    {
+        for (int c = std::max(activation.cell, 0), end = std::min(activation.cell + activation.duration, size()); c < end; ++c)
+        {
+            additive_[c] += activation.gain.additive;
+            multiplier_[c] *= activation.gain.multiplier;
+        }
+    }
+
+    void remove(const Activation& activation)
+    {
+        for (int c = std::max(activation.cell, 0), end = std::min(activation.cell + activation.duration, size()); c < end; ++c)
+        {
+            additive_[c] -= activation.gain.additive;
+            multiplier_[c] /= activation.gain.multiplier;
+        }
+    }
+
+    // how much the activation would add if it started at cell
+    [[nodiscard]] double value(const Activation& activation, int cell) const
+    {
+        double value{};
+        for (int c = cell, end = std::min(cell + activation.duration, size()); c < end; ++c)
+        {
+            value += (1 + additive_[c] + activation.gain.additive) * multiplier_[c] * activation.gain.multiplier -
+                     (1 + additive_[c]) * multiplier_[c];
+        }
+        return value;
+    }
+
+private:
+    std::vector<double> additive_;
+    std::vector<double> multiplier_;
+};
+
+bool is_feasible(const std::vector<Activation>& activations, size_t index, const Activation& activation, int cell)
+{
+    for (size_t j = 0; j < activations.size(); ++j)
+    {
+        if (j == index) continue;
+
+        const auto& other = activations[j];
+        if (&other.use_effect.get() == &activation.use_effect.get() && std::abs(other.cell - cell) < activation.spacing)
+        {
+            return false;
+        }
+        if (activation.shared && other.shared && cell < other.cell + other.duration && other.cell < cell + activation.duration)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+void Use_effects::optimize_schedule(Schedule& schedule, const Special_stats& special_stats, int sim_time, double total_ap,
+                                    int step)
+{
+    const int n_cells = (sim_time + step - 1) / step;
+    if (n_cells <= 0 || schedule.empty()) return;
+
+    auto to_cells = [step](int time) { return (time + step - 1) / step; };
+
+    std::vector<Activation> activations;
+    for (const auto& entry : schedule)
+    {
+        const auto& use_effect = entry.second.get();
+        const bool pinned = is_pinned(use_effect);
+        const auto duration = to_cells(use_effect.duration);
+        activations.push_back({entry.second, surrogate_gain(use_effect, special_stats, total_ap), entry.first,
+                               pinned ? entry.first / step : std::clamp(entry.first / step, 0, n_cells - 1),
+                               duration, std::max(to_cells(use_effect.cooldown), duration),
+                               use_effect.effect_socket == Use_effect::Effect_socket::shared, pinned});
+    }
+
+    Timeline timeline{n_cells};
+    for (const auto& activation : activations)
+    {
+        timeline.add(activation);
+    }
+
+    auto best_cell = [&](size_t index, const Activation& activation, int current, double current_value) {
+        auto best = std::make_pair(current, current_value);
+        for (int cell = 0; cell < n_cells; ++cell)
+        {
+            if (!is_feasible(activations, index, activation, cell)) continue;
+            const auto value = timeline.value(activation, cell);
+            if (value > best.second + 1e-9) best = {cell, value};
+        }
+        return best;
+    };
+
+    // coordinate descent: one activation at a time moves to its best spot given all the others, until none moves. after
+    //  each round, effects get another activation wherever one fits
+    const size_t n_initial = activations.size();
+    for (int round = 0; round < 20; ++round)
+    {
+        bool improved = false;
+        for (size_t i = 0; i < activations.size(); ++i)
+        {
+            auto& activation = activations[i];
+            if (activation.pinned) continue;
+
+            timeline.remove(activation);
+            const auto best = best_cell(i, activation, activation.cell, timeline.value(activation, activation.cell));
+            improved |= best.first != activation.cell;
+            activation.cell = best.first;
+            timeline.add(activation);
+        }
+
+        for (size_t i = 0; i < n_initial; ++i)
+        {
+            if (activations[i].pinned) continue;
+
+            auto extra = activations[i];
+            const auto best = best_cell(activations.size(), extra, -1, 0.0);
+            if (best.first < 0) continue;
+
+            extra.cell = best.first;
+            activations.push_back(extra);
+            timeline.add(extra);
+            improved = true;
+        }
+
+        if (!improved) break;
+    }
+
+    schedule.clear();
+    for (const auto& activation : activations)
+    {
+        schedule.emplace_back(activation.pinned ? activation.time : activation.cell * step, activation.use_effect);
+    }
+
+    std::sort(schedule.begin(), schedule.end(), [](const auto& a, const auto& b) {
+      return a.first < b.first;
+    });
+}
+
 // TODO(vigo) this should use pre-defined or -calculated stat values, and consider uptime
 double estimate_power(const Use_effect& use_effect, const Special_stats& special_stats,
                                            double total_ap)
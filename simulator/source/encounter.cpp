@@ -0,0 +1,56 @@
+#include "encounter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+std::vector<Encounter_event> compile_encounter(const Combat_simulator_config& config)
+{
+    using Type = Encounter_event::Type;
+    const int sim_time = Combat_simulator_config::to_millis(config.sim_time);
+
+    std::vector<Encounter_event> events{};
+    if (config.exposed_armor)
+    {
+        events.push_back({6000, Type::armor_reduction});
+    }
+
+    // the execute phase starts after this time, not at it
+    const int time_execute_phase =
+        Combat_simulator_config::to_millis(config.sim_time * (100.0 - config.execute_phase_percentage_) / 100.0);
+    events.push_back({time_execute_phase + 1, Type::execute_phase});
+
+    if (config.multi_target_mode_ && config.number_of_extra_targets > 0)
+    {
+        const auto extra_targets_die = static_cast<int>(std::ceil(sim_time * config.extra_target_percentage / 100));
+        events.push_back({0, Type::extra_targets, config.number_of_extra_targets});
+        events.push_back({extra_targets_die, Type::extra_targets, -config.number_of_extra_targets});
+    }
+
+    for (const auto& window : config.encounter_windows)
+    {
+        const int start = Combat_simulator_config::to_millis(window.start);
+        const int end = Combat_simulator_config::to_millis(window.end);
+        if (end <= start) continue;
+
+        switch (window.type)
+        {
+        case Encounter_window::Type::adds:
+            if (window.count <= 0) break;
+            events.push_back({start, Type::extra_targets, window.count});
+            events.push_back({end, Type::extra_targets, -window.count});
+            break;
+        case Encounter_window::Type::downtime:
+            events.push_back({start, Type::downtime_start});
+            events.push_back({end, Type::downtime_end});
+            break;
+        case Encounter_window::Type::target_switch:
+            events.push_back({start, Type::target_switch_start});
+            events.push_back({end, Type::target_switch_end});
+            break;
+        }
+    }
+
+    // events at the same time keep the order above
+    std::stable_sort(events.begin(), events.end(), [](const auto& a, const auto& b) { return a.time < b.time; });
+    return events;
+}
@@ -0,0 +1,242 @@
+#include "response_surface.hpp"
+
+#include "Linear_regression.hpp"
+#include "parallel.hpp"
+#include "random_generator.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <numeric>
+#include <set>
+#include <sstream>
+
+std::optional<Stat_field> stat_axis_field(const std::string& name)
+{
+    if (name == "hit") return Stat_field::hit;
+    if (name == "crit") return Stat_field::critical_strike;
+    if (name == "expertise") return Stat_field::expertise;
+    if (name == "haste") return Stat_field::haste;
+    if (name == "arpen") return Stat_field::gear_armor_pen;
+    if (name == "ap") return Stat_field::attack_power;
+    return {};
+}
+
+Response_surface::Response_surface(std::vector<Stat_axis> axes) : axes_(std::move(axes))
+{
+    assert(std::all_of(axes_.begin(), axes_.end(), [](const Stat_axis& axis) { return axis.max > axis.min; }));
+}
+
+std::vector<std::vector<double>> Response_surface::grid_design() const
+{
+    std::vector<std::vector<double>> design{{}};
+    for (const auto& axis : axes_)
+    {
+        std::vector<std::vector<double>> extended;
+        for (const auto& point : design)
+        {
+            for (int level = 0; level < axis.levels; level++)
+            {
+                auto p = point;
+                p.push_back(axis.levels > 1 ? axis.min + (axis.max - axis.min) * level / (axis.levels - 1) : axis.min);
+                extended.emplace_back(std::move(p));
+            }
+        }
+        design = std::move(extended);
+    }
+    return design;
+}
+
+std::vector<std::vector<double>> Response_surface::latin_hypercube_design(int n_points, uint64_t seed) const
+{
+    // a stream of its own, the batches use the low ones
+    Random_generator rng(seed, ~uint64_t{1});
+    std::vector<std::vector<double>> design(n_points, std::vector<double>(axes_.size()));
+    std::vector<int> strata(n_points);
+    for (size_t i = 0; i < axes_.size(); i++)
+    {
+        std::iota(strata.begin(), strata.end(), 0);
+        rng.shuffle(strata.begin(), strata.end());
+        const double width = (axes_[i].max - axes_[i].min) / n_points;
+        for (int k = 0; k < n_points; k++)
+        {
+            design[k][i] = axes_[i].min + (strata[k] + rng.uniform(1.0)) * width;
+        }
+    }
+    return design;
+}
+
+std::vector<double> Response_surface::terms(const std::vector<double>& x) const
+{
+    std::vector<double> z(axes_.size());
+    for (size_t i = 0; i < axes_.size(); i++)
+    {
+        z[i] = 2 * (x[i] - axes_[i].min) / (axes_[i].max - axes_[i].min) - 1;
+    }
+    std::vector<double> t{1.0};
+    t.insert(t.end(), z.begin(), z.end());
+    for (size_t i = 0; i < z.size(); i++)
+    {
+        for (size_t j = i; j < z.size(); j++)
+        {
+            t.push_back(z[i] * z[j]);
+        }
+    }
+    return t;
+}
+
+std::vector<std::string> Response_surface::term_names() const
+{
+    std::vector<std::string> names{"1"};
+    for (const auto& axis : axes_)
+    {
+        names.push_back(axis.name);
+    }
+    for (size_t i = 0; i < axes_.size(); i++)
+    {
+        for (size_t j = i; j < axes_.size(); j++)
+        {
+            names.push_back(axes_[i].name + "*" + axes_[j].name);
+        }
+    }
+    return names;
+}
+
+void Response_surface::run(const Combat_simulator_config& config, const Character& character,
+                           const std::vector<std::vector<double>>& design)
+{
+    points_.assign(design.size(), {});
+    Parallel::for_each_index(static_cast<int>(design.size()), [&](int k) {
+        Character point_character = character;
+        for (size_t i = 0; i < axes_.size(); i++)
+        {
+            Stat_accumulator::set_value(point_character.total_special_stats, axes_[i].field, design[k][i]);
+        }
+
+        // every point runs the same batch indices, and with that the same random streams
+        auto& simulator = Combat_simulator::pooled(config);
+        simulator.simulate(point_character, 0, config.n_batches);
+        const auto& dps = simulator.get_dps_distribution();
+        points_[k] = {design[k], dps.mean(), dps.std_of_the_mean()};
+    }, Parallel::thread_count(config.n_threads));
+
+    coefficients_.clear();
+    standard_errors_.clear();
+
+    // a squared term needs at least three distinct values on its axis, otherwise it is the same column as the
+    // intercept. those are dropped from the fit by fixing their coefficient to zero
+    const auto names = term_names();
+    std::vector<bool> used(names.size(), true);
+    size_t term = 1 + axes_.size();
+    for (size_t i = 0; i < axes_.size(); i++)
+    {
+        std::set<double> values;
+        for (const auto& point : design)
+        {
+            values.insert(point[i]);
+        }
+        for (size_t j = i; j < axes_.size(); j++, term++)
+        {
+            if (i == j && values.size() < 3)
+            {
+                used[term] = false;
+            }
+        }
+    }
+    const auto n_used = static_cast<size_t>(std::count(used.begin(), used.end(), true));
+    if (points_.size() <= n_used)
+    {
+        return;
+    }
+
+    Linear_regression regression{n_used};
+    for (const auto& point : points_)
+    {
+        const auto t = terms(point.x);
+        std::vector<double> x;
+        x.reserve(n_used);
+        for (size_t i = 0; i < t.size(); i++)
+        {
+            if (used[i]) x.push_back(t[i]);
+        }
+        regression.add_sample(x, point.dps);
+    }
+    const auto b = regression.coefficients();
+    const auto se = regression.standard_errors();
+    coefficients_.assign(names.size(), 0.0);
+    standard_errors_.assign(names.size(), 0.0);
+    for (size_t i = 0, k = 0; i < names.size(); i++)
+    {
+        if (used[i])
+        {
+            coefficients_[i] = b[k];
+            standard_errors_[i] = se[k];
+            k++;
+        }
+    }
+}
+
+double Response_surface::predict(const std::vector<double>& x) const
+{
+    assert(!coefficients_.empty());
+    const auto t = terms(x);
+    double y = 0;
+    for (size_t i = 0; i < t.size(); i++)
+    {
+        y += coefficients_[i] * t[i];
+    }
+    return y;
+}
+
+std::string Response_surface::to_csv() const
+{
+    std::ostringstream out;
+    for (const auto& axis : axes_)
+    {
+        out << axis.name << ",";
+    }
+    out << "dps,std_of_the_mean" << (coefficients_.empty() ? "" : ",fitted") << "\n";
+    for (const auto& point : points_)
+    {
+        for (double x : point.x)
+        {
+            out << x << ",";
+        }
+        out << point.dps << "," << point.std_of_the_mean;
+        if (!coefficients_.empty())
+        {
+            out << "," << predict(point.x);
+        }
+        out << "\n";
+    }
+    return out.str();
+}
+
+std::string Response_surface::to_json() const
+{
+    std::ostringstream out;
+    out << "{\"axes\":[";
+    for (size_t i = 0; i < axes_.size(); i++)
+    {
+        out << (i ? "," : "") << "{\"name\":\"" << axes_[i].name << "\",\"min\":" << axes_[i].min
+            << ",\"max\":" << axes_[i].max << "}";
+    }
+    out << "],\"terms\":[";
+    const auto names = term_names();
+    for (size_t i = 0; i < coefficients_.size(); i++)
+    {
+        out << (i ? "," : "") << "{\"term\":\"" << names[i] << "\",\"coefficient\":" << coefficients_[i]
+            << ",\"standard_error\":" << standard_errors_[i] << "}";
+    }
+    out << "],\"points\":[";
+    for (size_t k = 0; k < points_.size(); k++)
+    {
+        out << (k ? "," : "") << "{\"x\":[";
+        for (size_t i = 0; i < points_[k].x.size(); i++)
+        {
+            out << (i ? "," : "") << points_[k].x[i];
+        }
+        out << "],\"dps\":" << points_[k].dps << ",\"std_of_the_mean\":" << points_[k].std_of_the_mean << "}";
+    }
+    out << "]}";
+    return out.str();
+}
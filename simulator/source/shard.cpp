@@ -0,0 +1,60 @@
+#include "shard.hpp"
+
+#include "binary_io.hpp"
+
+#include <fstream>
+
+Shard_header shard_range(int seed, int total_batches, int shard_index, int shard_count)
+{
+    assert(shard_count > 0 && shard_index >= 0 && shard_index < shard_count);
+    const int base = total_batches / shard_count;
+    const int remainder = total_batches % shard_count;
+    Shard_header shard{};
+    shard.seed = seed;
+    shard.first_batch = shard_index * base + std::min(shard_index, remainder);
+    shard.n_batches = base + (shard_index < remainder ? 1 : 0);
+    shard.total_batches = total_batches;
+    return shard;
+}
+
+bool run_shard(const Combat_simulator_config& config, const Character& character, const Shard_header& shard,
+               const std::string& path)
+{
+    auto shard_config = config;
+    shard_config.seed = shard.seed;
+    Combat_simulator simulator(shard_config);
+    simulator.simulate(character, shard.first_batch, shard.n_batches, true);
+    return write_shard(path, shard, simulator);
+}
+
+bool write_shard(const std::string& path, const Shard_header& shard, const Combat_simulator& results)
+{
+    std::ofstream file(path, std::ios::binary);
+    Binary_writer writer{file};
+    writer.write(Shard_header::magic);
+    writer.write(Shard_header::version);
+    writer.write(shard);
+    results.save_results(file);
+    return writer.good();
+}
+
+std::optional<Shard_header> read_shard(const std::string& path, Combat_simulator& results)
+{
+    std::ifstream file(path, std::ios::binary);
+    Binary_reader reader{file};
+    uint32_t magic{};
+    uint32_t version{};
+    Shard_header shard{};
+    reader.read(magic);
+    reader.read(version);
+    if (!reader.good() || magic != Shard_header::magic || version != Shard_header::version)
+    {
+        return {};
+    }
+    reader.read(shard);
+    if (!reader.good() || !results.load_results(file))
+    {
+        return {};
+    }
+    return shard;
+}
@@ -0,0 +1,269 @@
+#include "stat_accumulator.hpp"
+
+#include <cassert>
+#include <cmath>
+
+Stat_delta::Stat_delta(const Special_stats& special_stats)
+{
+    for (size_t i = 0; i < n_stat_fields; ++i)
+    {
+        const auto field = static_cast<Stat_field>(i);
+        const double value = Stat_accumulator::value_of(special_stats, field);
+        if (value != 0.0) entries.push_back({field, value});
+    }
+}
+
+double Stat_accumulator::value_of(const Special_stats& special_stats, Stat_field field)
+{
+    switch (field)
+    {
+    case Stat_field::critical_strike:
+        return special_stats.critical_strike;
+    case Stat_field::hit:
+        return special_stats.hit;
+    case Stat_field::attack_power:
+        return special_stats.attack_power;
+    case Stat_field::bonus_attack_power:
+        return special_stats.bonus_attack_power;
+    case Stat_field::haste:
+        return special_stats.haste;
+    case Stat_field::damage_mod_physical:
+        return special_stats.damage_mod_physical;
+    case Stat_field::stat_multiplier:
+        return special_stats.stat_multiplier;
+    case Stat_field::bonus_damage:
+        return special_stats.bonus_damage;
+    case Stat_field::crit_multiplier:
+        return special_stats.crit_multiplier;
+    case Stat_field::spell_crit:
+        return special_stats.spell_crit;
+    case Stat_field::damage_mod_spell:
+        return special_stats.damage_mod_spell;
+    case Stat_field::expertise:
+        return special_stats.expertise;
+    case Stat_field::sword_expertise:
+        return special_stats.sword_expertise;
+    case Stat_field::mace_expertise:
+        return special_stats.mace_expertise;
+    case Stat_field::axe_expertise:
+        return special_stats.axe_expertise;
+    case Stat_field::gear_armor_pen:
+        return special_stats.gear_armor_pen;
+    case Stat_field::ap_multiplier:
+        return special_stats.ap_multiplier;
+    case Stat_field::attack_speed:
+        return special_stats.attack_speed;
+    default:
+        assert(false);
+        return 0.0;
+    }
+}
+
+void Stat_accumulator::set_value(Special_stats& special_stats, Stat_field field, double value)
+{
+    switch (field)
+    {
+    case Stat_field::critical_strike:
+        special_stats.critical_strike = value;
+        break;
+    case Stat_field::hit:
+        special_stats.hit = value;
+        break;
+    case Stat_field::attack_power:
+        special_stats.attack_power = value;
+        break;
+    case Stat_field::bonus_attack_power:
+        special_stats.bonus_attack_power = value;
+        break;
+    case Stat_field::haste:
+        special_stats.haste = value;
+        break;
+    case Stat_field::damage_mod_physical:
+        special_stats.damage_mod_physical = value;
+        break;
+    case Stat_field::stat_multiplier:
+        special_stats.stat_multiplier = value;
+        break;
+    case Stat_field::bonus_damage:
+        special_stats.bonus_damage = value;
+        break;
+    case Stat_field::crit_multiplier:
+        special_stats.crit_multiplier = value;
+        break;
+    case Stat_field::spell_crit:
+        special_stats.spell_crit = value;
+        break;
+    case Stat_field::damage_mod_spell:
+        special_stats.damage_mod_spell = value;
+        break;
+    case Stat_field::expertise:
+        special_stats.expertise = value;
+        break;
+    case Stat_field::sword_expertise:
+        special_stats.sword_expertise = value;
+        break;
+    case Stat_field::mace_expertise:
+        special_stats.mace_expertise = value;
+        break;
+    case Stat_field::axe_expertise:
+        special_stats.axe_expertise = value;
+        break;
+    case Stat_field::gear_armor_pen:
+        special_stats.gear_armor_pen = static_cast<int>(std::round(value));
+        break;
+    case Stat_field::ap_multiplier:
+        special_stats.ap_multiplier = value;
+        break;
+    case Stat_field::attack_speed:
+        special_stats.attack_speed = value;
+        break;
+    default:
+        assert(false);
+    }
+}
+
+void Stat_accumulator::reset(const Special_stats& base)
+{
+    base_ = base;
+    stats_ = base;
+    for (size_t i = 0; i < n_stat_fields; ++i)
+    {
+        components_[i] = is_multiplicative(static_cast<Stat_field>(i)) ? 1.0 : 0.0;
+    }
+    active_.fill(0);
+    dirty_ = ~Stat_mask{0};
+}
+
+void Stat_accumulator::add(const Stat_delta& delta, int stacks)
+{
+    for (const auto& entry : delta.entries)
+    {
+        const auto i = static_cast<size_t>(entry.field);
+        if (is_multiplicative(entry.field))
+        {
+            for (int s = 0; s < stacks; ++s)
+            {
+                components_[i] *= 1 + entry.value;
+            }
+        }
+        else
+        {
+            components_[i] += entry.value * stacks;
+        }
+        active_[i] += stacks;
+        update(entry.field);
+    }
+}
+
+void Stat_accumulator::remove(const Stat_delta& delta, int stacks)
+{
+    for (const auto& entry : delta.entries)
+    {
+        const auto i = static_cast<size_t>(entry.field);
+        active_[i] -= stacks;
+        assert(active_[i] >= 0);
+        if (active_[i] == 0)
+        {
+            // nothing left modifying this field, drop the accumulated rounding error
+            components_[i] = is_multiplicative(entry.field) ? 1.0 : 0.0;
+        }
+        else if (is_multiplicative(entry.field))
+        {
+            for (int s = 0; s < stacks; ++s)
+            {
+                components_[i] /= 1 + entry.value;
+            }
+        }
+        else
+        {
+            components_[i] -= entry.value * stacks;
+        }
+        update(entry.field);
+    }
+}
+
+double Stat_accumulator::multiplied(Stat_field field) const
+{
+    const auto i = static_cast<size_t>(field);
+    const double base = value_of(base_, field);
+    return active_[i] == 0 ? base : (1 + base) * components_[i] - 1;
+}
+
+void Stat_accumulator::update(Stat_field field)
+{
+    const auto i = static_cast<size_t>(field);
+    dirty_ |= stat_mask(field);
+    switch (field)
+    {
+    case Stat_field::critical_strike:
+        stats_.critical_strike = base_.critical_strike + components_[i];
+        break;
+    case Stat_field::hit:
+        stats_.hit = base_.hit + components_[i];
+        break;
+    case Stat_field::bonus_attack_power:
+        stats_.bonus_attack_power = base_.bonus_attack_power + components_[i];
+        break;
+    case Stat_field::bonus_damage:
+        stats_.bonus_damage = base_.bonus_damage + components_[i];
+        break;
+    case Stat_field::spell_crit:
+        stats_.spell_crit = base_.spell_crit + components_[i];
+        break;
+    case Stat_field::expertise:
+        stats_.expertise = base_.expertise + components_[i];
+        break;
+    case Stat_field::sword_expertise:
+        stats_.sword_expertise = base_.sword_expertise + components_[i];
+        break;
+    case Stat_field::mace_expertise:
+        stats_.mace_expertise = base_.mace_expertise + components_[i];
+        break;
+    case Stat_field::axe_expertise:
+        stats_.axe_expertise = base_.axe_expertise + components_[i];
+        break;
+    case Stat_field::gear_armor_pen:
+        stats_.gear_armor_pen = base_.gear_armor_pen + static_cast<int>(std::lround(components_[i]));
+        break;
+    case Stat_field::damage_mod_physical:
+        stats_.damage_mod_physical = multiplied(field);
+        break;
+    case Stat_field::stat_multiplier:
+        stats_.stat_multiplier = multiplied(field);
+        break;
+    case Stat_field::crit_multiplier:
+        stats_.crit_multiplier = multiplied(field);
+        break;
+    case Stat_field::damage_mod_spell:
+        stats_.damage_mod_spell = multiplied(field);
+        break;
+    case Stat_field::attack_power:
+    case Stat_field::ap_multiplier:
+    {
+        // added attack power is scaled by the starting multiplier, everything by the multipliers gained on top
+        const auto ap = static_cast<size_t>(Stat_field::attack_power);
+        const auto apm = static_cast<size_t>(Stat_field::ap_multiplier);
+        dirty_ |= stat_mask(Stat_field::attack_power, Stat_field::ap_multiplier);
+        stats_.ap_multiplier = multiplied(Stat_field::ap_multiplier);
+        stats_.attack_power = (active_[ap] == 0 && active_[apm] == 0) ?
+                                  base_.attack_power :
+                                  (base_.attack_power + components_[ap] * (1 + base_.ap_multiplier)) * components_[apm];
+        break;
+    }
+    case Stat_field::haste:
+    case Stat_field::attack_speed:
+    {
+        // same composition for haste ratings and attack speed multipliers (flurry etc.)
+        const auto h = static_cast<size_t>(Stat_field::haste);
+        const auto as = static_cast<size_t>(Stat_field::attack_speed);
+        dirty_ |= stat_mask(Stat_field::haste, Stat_field::attack_speed);
+        stats_.attack_speed = multiplied(Stat_field::attack_speed);
+        stats_.haste = (active_[h] == 0 && active_[as] == 0) ?
+                           base_.haste :
+                           (1 + base_.haste + components_[h] * (1 + base_.attack_speed)) * components_[as] - 1;
+        break;
+    }
+    default:
+        assert(false);
+    }
+}
@@ -0,0 +1,128 @@
+#include "stat_gradient.hpp"
+
+#include "Linear_regression.hpp"
+#include "parallel.hpp"
+#include "random_generator.hpp"
+#include "stat_accumulator.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+Special_stats scaled(const Special_stats& special_stats, double factor)
+{
+    Special_stats result{};
+    for (size_t i = 0; i < n_stat_fields; i++)
+    {
+        const auto field = static_cast<Stat_field>(i);
+        Stat_accumulator::set_value(result, field, factor * Stat_accumulator::value_of(special_stats, field));
+    }
+    return result;
+}
+} // namespace
+
+Stat_step stat_step(const Combat_simulator_config& config, const Special_stats& special_stats, const Special_stats& delta)
+{
+    Stat_step step{};
+
+    // base + t * change has to stay on the same side of bound as base, for t in [-down, up]
+    auto keep_side = [&step](double base, double change, double bound) {
+        if (change == 0)
+        {
+            return;
+        }
+        const bool below = base < bound;
+        const double room = std::max(below ? bound - base : base - bound, 0.0) / std::abs(change);
+        if ((change > 0) == below)
+        {
+            step.up = std::min(step.up, room);
+        }
+        else
+        {
+            step.down = std::min(step.down, room);
+        }
+    };
+
+    for (size_t i = 0; i < n_stat_fields; i++)
+    {
+        const auto field = static_cast<Stat_field>(i);
+        const double change = Stat_accumulator::value_of(delta, field);
+        const double base = Stat_accumulator::value_of(special_stats, field);
+        if (change != 0 && base >= 0)
+        {
+            keep_side(base, change, 0);
+        }
+    }
+    keep_side(special_stats.hit, delta.hit, Combat_simulator::yellow_hit_cap(config.main_target_level));
+    keep_side(special_stats.hit, delta.hit, Combat_simulator::dual_wield_hit_cap(config.main_target_level));
+    return step;
+}
+
+Stat_gradient simulate_stat_gradient(const Combat_simulator_config& config, const Character& character,
+                                     const std::vector<Special_stats>& deltas)
+{
+    const size_t n_stats = deltas.size();
+    if (n_stats == 0)
+    {
+        return {};
+    }
+
+    const int n_rows = std::max(32, 4 * static_cast<int>(n_stats));
+    const int batches_per_row = std::max(1, config.n_batches / (2 * n_rows));
+
+    // the design itself comes from a stream no batch uses
+    Random_generator design_rng(config.seed, ~uint64_t{0});
+    std::vector<std::vector<double>> signs(n_rows, std::vector<double>(n_stats));
+    for (auto& row : signs)
+    {
+        for (auto& sign : row)
+        {
+            sign = (design_rng() >> 63u) ? 1.0 : -1.0;
+        }
+    }
+
+    std::vector<Stat_step> steps(n_stats);
+    for (size_t j = 0; j < n_stats; j++)
+    {
+        steps[j] = stat_step(config, character.total_special_stats, deltas[j]);
+    }
+
+    std::vector<double> row_dps(2 * n_rows);
+    Parallel::for_each_index(2 * n_rows, [&](int i) {
+        const int row = i / 2;
+        const double flip = (i % 2 == 0) ? 1.0 : -1.0;
+        Character permuted = character;
+        for (size_t j = 0; j < n_stats; j++)
+        {
+            if (signs[row][j] * flip > 0)
+            {
+                permuted.total_special_stats += scaled(deltas[j], steps[j].up);
+            }
+            else
+            {
+                permuted.total_special_stats -= scaled(deltas[j], steps[j].down);
+            }
+        }
+        auto& simulator = Combat_simulator::pooled(config);
+        simulator.simulate(permuted, row * batches_per_row, batches_per_row);
+        row_dps[i] = simulator.get_dps_distribution().mean();
+    }, Parallel::thread_count(config.n_threads));
+
+    Linear_regression regression{n_stats};
+    for (int row = 0; row < n_rows; row++)
+    {
+        regression.add_sample(signs[row], (row_dps[2 * row] - row_dps[2 * row + 1]) / 2);
+    }
+
+    // the coefficient of a delta is the gain over half its span, scaled back up to the whole delta
+    Stat_gradient gradient{regression.coefficients(), regression.standard_errors()};
+    for (size_t j = 0; j < n_stats; j++)
+    {
+        const double span = steps[j].up + steps[j].down;
+        const double scale = span > 0 ? 2 / span : 0;
+        gradient.gains[j] *= scale;
+        gradient.standard_errors[j] *= scale;
+    }
+    return gradient;
+}
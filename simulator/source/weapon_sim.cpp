@@ -1,8 +1,10 @@
 #include "weapon_sim.hpp"
 
+#include <algorithm>
+#include <numeric>
+
 Weapon_sim::Weapon_sim(const Weapon& weapon) :
         swing_speed(weapon.swing_speed),
-        next_swing(0),
         average_damage(0.5 * (weapon.min_damage + weapon.max_damage) + weapon.buff.bonus_damage),
         socket(weapon.socket),
         weapon_type(weapon.type),
@@ -22,3 +24,49 @@ Weapon_sim::Weapon_sim(const Weapon& weapon) :
         normalized_swing_speed = 2.4;
     }
 }
+
+Weapon_state::Weapon_state(const Weapon_sim& weapon) :
+        weapon(weapon),
+        ready_at(weapon.hit_effects.size()),
+        proc_chance(weapon.hit_effects.size()),
+        procs(weapon.hit_effects.size()),
+        combat_buff_idx(weapon.hit_effects.size(), -1),
+        shared_cooldown(weapon.hit_effects.size(), -1),
+        name_order_(weapon.hit_effects.size())
+{
+    std::iota(name_order_.begin(), name_order_.end(), size_t{0});
+    std::sort(name_order_.begin(), name_order_.end(), [&weapon](size_t a, size_t b) {
+        return weapon.hit_effects[a].name < weapon.hit_effects[b].name;
+    });
+
+    for (size_t i = 0; i < weapon.hit_effects.size(); ++i)
+    {
+        const auto& hit_effect = weapon.hit_effects[i];
+        proc_chance[i] = hit_effect.ppm > 0 ? hit_effect.ppm * weapon.swing_speed / 60 : hit_effect.probability;
+    }
+}
+
+void Weapon_state::reset(Random_generator& rng)
+{
+    next_swing = 0;
+    std::fill(ready_at.begin(), ready_at.end(), 0);
+
+    // permute hit_effect order between runs - this isn't strictly necessary, but closer to what happens in-game, it seems.
+    //  starting from the name order makes the permutation depend on the random stream only
+    order_ = name_order_;
+    rng.shuffle(order_.begin(), order_.end());
+
+    for (auto hit_result : {Hit_result::TBD, Hit_result::miss, Hit_result::dodge, Hit_result::glancing, Hit_result::crit,
+                            Hit_result::hit})
+    {
+        auto& candidates = candidates_[slot(hit_result)];
+        candidates.clear();
+        for (auto i : order_)
+        {
+            const auto& hit_effect = weapon.hit_effects[i];
+            const bool procs = hit_effect.is_procced_by(hit_result);
+            // darkmoon_card_wrath loses a charge on every hit that doesn't proc it
+            if (procs || hit_effect.name == "darkmoon_card_wrath") candidates.push_back({i, procs});
+        }
+    }
+}
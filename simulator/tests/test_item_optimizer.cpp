@@ -0,0 +1,77 @@
+#include "Item_optimizer.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+
+namespace
+{
+template <typename Item>
+std::vector<std::string> names(const std::vector<Item>& items)
+{
+    std::vector<std::string> result{};
+    for (const auto& item : items) result.push_back(item.name);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+} // namespace
+
+TEST(TestSuite, test_remove_weaker_items)
+{
+    const std::vector<Armor> armors{
+        {"ap_10", {}, {0, 0, 10}, Socket::head},
+        {"ap_40", {}, {0, 0, 40}, Socket::head},
+        {"ap_20", {}, {0, 0, 20}, Socket::head},
+        {"ap_30", {}, {0, 0, 30}, Socket::head},
+        {"ap_30_crit", {}, {1, 0, 30}, Socket::head},
+        {"ap_5_set", {}, {0, 0, 5}, Socket::head, Set::ragesteel},
+        {"equipped", {}, {0, 0, 1}, Socket::head},
+    };
+    auto filter = [](const Armor& armor) { return armor.name == "equipped"; };
+
+    // only ap_40 and ap_30_crit have less than two stronger ones. set items aren't judged by their stats, and the
+    //  filtered one isn't a candidate at all
+    std::string debug_message{};
+    const auto kept = Item_optimizer::remove_weaker_items(armors, {}, &debug_message, 2, filter);
+    const std::vector<std::string> expected{"ap_30_crit", "ap_40", "ap_5_set"};
+    EXPECT_EQ(names(kept), expected);
+    EXPECT_NE(debug_message.find("REMOVED:<b> ap_10</b>"), std::string::npos);
+    EXPECT_NE(debug_message.find("REMOVED:<b> ap_30</b>"), std::string::npos);
+    EXPECT_EQ(debug_message.find("REMOVED:<b> ap_40</b>"), std::string::npos);
+
+    EXPECT_EQ(names(Item_optimizer::remove_weaker_items(armors, {}, nullptr, 2, filter)), expected);
+
+    // with more stronger ones needed, more are kept
+    const std::vector<std::string> expected_3{"ap_30", "ap_30_crit", "ap_40", "ap_5_set"};
+    EXPECT_EQ(names(Item_optimizer::remove_weaker_items(armors, {}, nullptr, 3, filter)), expected_3);
+}
+
+TEST(TestSuite, test_remove_weaker_weapons)
+{
+    const std::vector<Weapon> weapons{
+        {"sword_100", {}, {}, 2.6, 100, 100, Weapon_socket::one_hand, Weapon_type::sword},
+        {"sword_200", {}, {}, 2.6, 200, 200, Weapon_socket::one_hand, Weapon_type::sword},
+        {"sword_150", {}, {}, 2.6, 150, 150, Weapon_socket::one_hand, Weapon_type::sword},
+        {"axe_180", {}, {}, 2.6, 180, 180, Weapon_socket::one_hand, Weapon_type::axe},
+        {"fast_sword_120", {}, {}, 1.5, 120, 120, Weapon_socket::one_hand, Weapon_type::sword},
+        {"proc_sword_100", {}, {}, 2.6, 100, 100, Weapon_socket::one_hand, Weapon_type::sword,
+         {{"proc", Hit_effect::Type::extra_hit, {}, {}, 0, 0, 0, 0.05}}},
+        {"equipped", {}, {}, 2.6, 300, 300, Weapon_socket::one_hand, Weapon_type::sword},
+    };
+    auto filter = [](const Weapon& weapon) { return weapon.name == "equipped"; };
+
+    // the fast sword has the most damage per second, but loses 80 ap to the slow ones as a main hand. the proc sword
+    //  isn't judged by its stats
+    std::string debug_message{};
+    const auto kept = Item_optimizer::remove_weaker_weapons(Weapon_socket::main_hand, weapons, {}, &debug_message, 1, filter);
+    const std::vector<std::string> expected{"proc_sword_100", "sword_200"};
+    EXPECT_EQ(names(kept), expected);
+    EXPECT_NE(debug_message.find("is better than <b>sword_100</b> in all aspects"), std::string::npos);
+
+    EXPECT_EQ(names(Item_optimizer::remove_weaker_weapons(Weapon_socket::main_hand, weapons, {}, nullptr, 1, filter)),
+              expected);
+
+    // in the off hand the fast one is the best
+    const std::vector<std::string> expected_off_hand{"fast_sword_120", "proc_sword_100"};
+    EXPECT_EQ(names(Item_optimizer::remove_weaker_weapons(Weapon_socket::off_hand, weapons, {}, nullptr, 1, filter)),
+              expected_off_hand);
+}
@@ -0,0 +1,220 @@
+#include "sim_interface.hpp"
+#include "sim_output_renderer.hpp"
+#include "gtest/gtest.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+Sim_results fixed_results(bool dual_wield)
+{
+    Sim_results results{};
+    results.dual_wield = dual_wield;
+
+    results.character_stats = {300, 150.5, 9.5, 5, 25.123, 2400, 100, 1.1, -1, 5, -1, -1, -1};
+    results.set_bonuses = {"warbringer_battlegear"};
+
+    results.fight_stats.assign(static_cast<size_t>(Fight_stat::size), 0.0);
+    auto set_fight_stat = [&results](Fight_stat stat, double value) { results.fight_stats[static_cast<size_t>(stat)] = value; };
+    set_fight_stat(Fight_stat::yellow_mh_miss, 8);
+    set_fight_stat(Fight_stat::white_mh_miss, 27);
+    set_fight_stat(Fight_stat::yellow_mh_crit, 30.5);
+    set_fight_stat(Fight_stat::white_mh_crit, 28.1);
+    set_fight_stat(Fight_stat::white_mh_left_to_crit_cap, 10.4);
+    set_fight_stat(Fight_stat::glance_chance, 24);
+    set_fight_stat(Fight_stat::glancing_penalty, 35);
+    set_fight_stat(Fight_stat::mh_dodge, 6.5);
+    if (dual_wield)
+    {
+        set_fight_stat(Fight_stat::white_oh_miss, 27);
+        set_fight_stat(Fight_stat::white_oh_queued_miss, 8);
+        set_fight_stat(Fight_stat::yellow_oh_crit, 30.5);
+        set_fight_stat(Fight_stat::white_oh_crit, 28.1);
+        set_fight_stat(Fight_stat::white_oh_left_to_crit_cap, 10.4);
+        set_fight_stat(Fight_stat::oh_dodge, 6.5);
+    }
+
+    results.rage_lost_capped = 12.5;
+    results.rage_lost_stance = 3.25;
+
+    results.item_upgrades = {
+        {Socket::head, true, "warbringer_battle-helm", "helm_of_the_fallen_champion", 12.34, 3.21},
+        {Socket::head, true, "warbringer_battle-helm", "destroyers_battle-helm", -5.0, 1.04},
+        {Socket::trinket, true, "dragonspine_trophy", "bloodlust_brooch", -1.0, 0.5},
+        {Socket::trinket, false, "bloodlust_brooch", "hourglass_of_the_unraveller", 2.26, 0.84},
+        {Socket::main_hand, true, "hope_ender", "dragonmaw", 7.0, 2.0},
+    };
+    results.uneven_weapon_specializations = true;
+    return results;
+}
+
+Sim_input dual_wield_input(std::vector<std::string> options, std::vector<std::string> float_options = {},
+                           std::vector<double> float_values = {})
+{
+    const std::vector<std::string> empty{};
+    const std::vector<std::string> armor{
+        "warbringer_battle-helm", "choker_of_vile_intent",   "warbringer_shoulderplates", "vengeance_wrap",
+        "warbringer_breastplate", "bladespire_warbands",     "gauntlets_of_martial_perfection",
+        "girdle_of_the_endless_pit", "skulkers_greaves",     "ironstriders_of_urgency",   "ring_of_a_thousand_marks",
+        "shapeshifters_signet",   "bloodlust_brooch",        "dragonspine_trophy",        "mamas_insurance",
+    };
+    for (const auto& option : {"use_bloodthirst", "use_whirlwind"}) options.emplace_back(option);
+    const std::vector<std::string> fight{"n_simulations_dd", "fight_time_dd", "opponent_level_dd", "boss_armor_dd"};
+    const std::vector<double> fight_values{200, 60, 73, 7700};
+    for (size_t i = 0; i < fight.size(); i++)
+    {
+        if (std::find(float_options.begin(), float_options.end(), fight[i]) != float_options.end()) continue;
+        float_options.emplace_back(fight[i]);
+        float_values.emplace_back(fight_values[i]);
+    }
+    return {{"human"}, armor, {"hope_ender", "spiteblade"}, empty, empty, empty, empty, std::move(options),
+            std::move(float_options), std::move(float_values), empty, {}, empty, empty};
+}
+} // namespace
+
+// the strings the website got before Sim_results, rendered from the character and the hit tables directly
+TEST(TestSuite, test_sim_output_renderer_matches_legacy_strings)
+{
+    const auto results = fixed_results(true);
+
+    EXPECT_EQ(Sim_output_renderer::character_stats(results),
+              "<b>Character stats:</b> <br />"
+              "Strength: <b>300</b><br>"
+              "Agility: <b>150.5</b><br>"
+              "Hit: <b>9.5</b><br>"
+              "Expertise (before rounding down): <b>5</b><br>"
+              "Crit (spellbook): <b>25.12</b><br>"
+              "Attack Power: <b>2400 + 100</b><br>"
+              "Haste factor: <b>1.1</b><br>"
+              "Axe bonus expertise: <b>5</b><br>"
+              "<br>"
+              "Set bonuses:<br>"
+              "<b>warbringer_battlegear</b><br>");
+
+    EXPECT_EQ(Sim_output_renderer::fight_stats(results),
+              "<b>Fight stats vs. target:</b><br>"
+              "<b>Hit:</b><br>"
+              "Yellow hits: <b>8%</b> chance to miss<br>"
+              "Main-hand, white hits: <b>27%</b> chance to miss<br>"
+              "Off-hand, white hits: <b>27%</b> chance to miss<br>"
+              "Off-hand, while ability queued: <b>8%</b> chance to miss<br>"
+              "<b>Crit chance:</b><br>"
+              "Yellow main-hand: <b>30.5%</b> chance to crit per cast<br>"
+              "White main-hand: <b>28.1%</b> chance to crit. (<b>10.4%</b> left to crit-cap)<br>"
+              "Yellow off-hand: <b>30.5%</b> chance to crit per cast<br>"
+              "White off-hand: <b>28.1%</b> chance to crit. (<b>10.4%</b> left to crit-cap)<br>"
+              "<b>Glancing blows:</b><br>"
+              "Chance to occur: <b>24%</b> (based on level difference)<br>"
+              "Glancing damage: <b>35%</b> (based on level difference)<br>"
+              "<b>Other:</b><br>"
+              "Main-hand dodge chance: <b>6.5%</b> (based on level difference and expertise)<br>"
+              "Off-hand dodge chance: <b>6.5%</b> (based on level difference and expertise)<br>"
+              "<br><br>");
+
+    EXPECT_EQ(Sim_output_renderer::rage(results),
+              "<b>Rage Statistics:</b><br>"
+              "(Average per simulation)<br>"
+              "Rage lost to rage cap (gaining rage when at 100): <b>12.500</b><br>"
+              "</b>Rage lost when changing stance: <b>3.250</b><br>");
+
+    EXPECT_EQ(Sim_output_renderer::item_upgrades(results),
+              "<b>Character items and proposed upgrades:</b><br>"
+              "Current Helmet: <b>warbringer_battle-helm</b>"
+              "<br><b>Up</b>grade: <b>helm_of_the_fallen_champion</b> ( +<b>12.3 &plusmn 3.2</b> DPS)."
+              "<br><b>Down</b>grade: <b>destroyers_battle-helm</b> ( <b>-5.0 &plusmn 1.0</b> DPS)."
+              "<br><br>"
+              "Current Trinket: <b>dragonspine_trophy</b> is <b>BiS</b> in current configuration!"
+              "<br><b>Down</b>grade: <b>bloodlust_brooch</b> ( <b>-1.0 &plusmn 0.5</b> DPS)."
+              "<br><br>"
+              "Current Trinket: <b>bloodlust_brooch</b>"
+              "<br><b>Up</b>grade: <b>hourglass_of_the_unraveller</b> ( +<b>2.3 &plusmn 0.8</b> DPS)."
+              "<br><br>"
+              "Consider comparing weapons with all weapon specializations set to the same value (e.g. 5/5).<br><br>"
+              "Current Main hand: <b>hope_ender</b>"
+              "<br><b>Up</b>grade: <b>dragonmaw</b> ( +<b>7.0 &plusmn 2.0</b> DPS)."
+              "<br><br>"
+              "<br><br>");
+}
+
+TEST(TestSuite, test_sim_output_renderer_two_hand_and_no_upgrades)
+{
+    auto results = fixed_results(false);
+    results.item_upgrades.clear();
+
+    EXPECT_EQ(Sim_output_renderer::character_stats(results),
+              "<b>Character stats:</b> <br />"
+              "Strength: <b>300</b><br>"
+              "Agility: <b>150.5</b><br>"
+              "Hit: <b>9.5</b><br>"
+              "Expertise (before rounding down): <b>5</b><br>"
+              "Crit (spellbook): <b>25.12</b><br>"
+              "Attack Power: <b>2400 + 100</b><br>"
+              "Haste factor: <b>1.1</b><br>"
+              "Two Hand Axe expertise: <b>5</b><br>"
+              "<br>"
+              "Set bonuses:<br>"
+              "<b>warbringer_battlegear</b><br>");
+
+    const auto fight_stats = Sim_output_renderer::fight_stats(results);
+    EXPECT_EQ(fight_stats.find("Off-hand"), std::string::npos);
+    EXPECT_EQ(fight_stats.find("off-hand"), std::string::npos);
+
+    // without any item or weapon to compare there's no header either
+    EXPECT_EQ(Sim_output_renderer::item_upgrades(results), "");
+}
+
+TEST(TestSuite, test_structured_output_fills_results)
+{
+    Sim_interface sim_interface;
+    const auto rendered = sim_interface.simulate(dual_wield_input({}));
+    const auto structured = sim_interface.simulate(dual_wield_input({"structured_output"}));
+
+    // the typed fields are there either way, the strings only without structured_output
+    const auto& results = structured.results;
+    ASSERT_EQ(results.character_stats.size(), static_cast<size_t>(Character_stat::size));
+    EXPECT_GT(results.character_stats[static_cast<size_t>(Character_stat::strength)], 0);
+    EXPECT_GT(results.character_stats[static_cast<size_t>(Character_stat::attack_power)], 0);
+    EXPECT_EQ(results.character_stats, rendered.results.character_stats);
+    EXPECT_TRUE(results.dual_wield);
+    ASSERT_EQ(results.fight_stats.size(), static_cast<size_t>(Fight_stat::size));
+    EXPECT_GT(results.fight_stats[static_cast<size_t>(Fight_stat::white_oh_miss)], 0);
+    EXPECT_EQ(results.fight_stats, rendered.results.fight_stats);
+    EXPECT_FALSE(results.procs.empty());
+    EXPECT_FALSE(results.use_effects.empty());
+    EXPECT_GT(results.dps_std, 0);
+
+    EXPECT_TRUE(structured.messages.empty());
+    EXPECT_TRUE(structured.proc_counter.empty());
+    EXPECT_TRUE(structured.use_effect_order_string.empty());
+    EXPECT_TRUE(structured.extra_stats[0].empty());
+    EXPECT_TRUE(structured.histogram_details.empty());
+
+    ASSERT_EQ(rendered.messages.size(), 1);
+    EXPECT_EQ(rendered.messages[0], Sim_output_renderer::character_stats(rendered.results));
+    EXPECT_EQ(rendered.proc_counter, Sim_output_renderer::named_values(rendered.results.procs));
+    EXPECT_EQ(rendered.use_effect_order_string, Sim_output_renderer::use_effects(rendered.results.use_effects));
+}
+
+TEST(TestSuite, test_shard_files_are_named_after_the_job)
+{
+    auto shard_file = [](double fight_time, int index) {
+        const auto output = Sim_interface{}.simulate(
+            dual_wield_input({"shard"}, {"shard_count_dd", "shard_index_dd", "fight_time_dd"}, {2, static_cast<double>(index), fight_time}));
+        EXPECT_EQ(output.messages.size(), 1);
+        const auto& message = output.messages.front();
+        const auto path = message.substr(message.rfind(' ') + 1);
+        EXPECT_EQ(message.find("Could not write"), std::string::npos);
+        std::remove(path.c_str());
+        return path;
+    };
+
+    // the shards of one job only differ in their index, another job doesn't overwrite them
+    const auto first = shard_file(60, 0);
+    const auto second = shard_file(60, 1);
+    const auto other_job = shard_file(90, 0);
+    EXPECT_EQ(first.substr(0, 11), "shard_0_of_");
+    EXPECT_EQ(second.substr(0, 11), "shard_1_of_");
+    EXPECT_EQ(first.substr(11), second.substr(11));
+    EXPECT_NE(first, other_job);
+}
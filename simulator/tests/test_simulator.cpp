@@ -2,9 +2,15 @@
 #include "BinomialDistribution.hpp"
 #include "Combat_simulator.hpp"
 #include "Statistics.hpp"
+#include "encounter.hpp"
+#include "response_surface.hpp"
+#include "shard.hpp"
 #include "simulation_fixture.cpp"
+#include "stat_gradient.hpp"
 
+#include <algorithm>
 #include <chrono>
+#include <set>
 
 TEST_F(Sim_fixture, test_no_crit_equals_no_flurry_uptime)
 {
@@ -71,7 +77,7 @@ TEST_F(Sim_fixture, test_bloodthirst_count)
 
     auto distrib = sim.get_damage_distribution();
 
-    EXPECT_NEAR(distrib.bloodthirst_count, config.sim_time / 6.0 * config.n_batches, 1.0);
+    EXPECT_NEAR(distrib.get_count(Damage_source::bloodthirst), config.sim_time / 6.0 * config.n_batches, 1.0);
 }
 
 TEST_F(Sim_fixture, test_that_with_infinite_rage_all_hits_are_heroic_strike)
@@ -94,7 +100,7 @@ TEST_F(Sim_fixture, test_that_with_infinite_rage_all_hits_are_heroic_strike)
     auto hs_uptime = sim.get_hs_uptime();
     double expected_swings_per_simulation = (config.sim_time - 1.0) / character.weapons[0].swing_speed + 1;
     double tolerance = 1.0 / character.weapons[0].swing_speed;
-    EXPECT_NEAR(distrib.heroic_strike_count / double(config.n_batches), expected_swings_per_simulation, tolerance);
+    EXPECT_NEAR(distrib.get_count(Damage_source::heroic_strike) / double(config.n_batches), expected_swings_per_simulation, tolerance);
 
     EXPECT_FLOAT_EQ(hs_uptime, 1);
 }
@@ -164,8 +170,8 @@ TEST_F(Sim_fixture, test_hit_effects_extra_hit)
     // OH proc's trigger main hand swings
     expected_swings_mh += expected_procs_mh + expected_procs_oh;
 
-    EXPECT_NEAR(sources.white_mh_count, expected_swings_mh, 0.01 * expected_swings_mh);
-    EXPECT_NEAR(sources.white_oh_count, expected_swings_oh, 0.01 * expected_swings_oh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_mh), expected_swings_mh, 0.01 * expected_swings_mh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_oh), expected_swings_oh, 0.01 * expected_swings_oh);
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, conf_interval_mh / 2);
     EXPECT_NEAR(proc_data["test_wep_oh"], expected_procs_oh, conf_interval_oh / 2);
@@ -211,8 +217,8 @@ TEST_F(Sim_fixture, test_hit_effects_icd)
     // OH proc's trigger main hand swings
     expected_swings_mh += expected_procs_mh + expected_procs_oh;
 
-    EXPECT_NEAR(sources.white_mh_count, expected_swings_mh, 0.01 * expected_swings_mh);
-    EXPECT_NEAR(sources.white_oh_count, expected_swings_oh, 0.01 * expected_swings_oh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_mh), expected_swings_mh, 0.01 * expected_swings_mh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_oh), expected_swings_oh, 0.01 * expected_swings_oh);
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, conf_interval_mh / 2);
     EXPECT_NEAR(proc_data["test_wep_oh"], expected_procs_oh, conf_interval_oh / 2);
@@ -261,8 +267,8 @@ TEST_F(Sim_fixture, test_hit_effects_windfury_hit)
     // OH proc's trigger main hand swings
     expected_swings_mh += expected_procs_mh + expected_procs_oh;
 
-    EXPECT_NEAR(sources.white_mh_count, expected_swings_mh, 0.01 * expected_swings_mh);
-    EXPECT_NEAR(sources.white_oh_count, expected_swings_oh, 0.01 * expected_swings_oh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_mh), expected_swings_mh, 0.01 * expected_swings_mh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_oh), expected_swings_oh, 0.01 * expected_swings_oh);
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, conf_interval_mh / 2);
     EXPECT_NEAR(proc_data["test_wep_oh"], expected_procs_oh, conf_interval_oh / 2);
@@ -307,8 +313,8 @@ TEST_F(Sim_fixture, test_hit_effects_sword_spec)
     // OH proc's trigger main hand swings
     expected_swings_mh += expected_procs_mh + expected_procs_oh;
 
-    EXPECT_NEAR(sources.white_mh_count, expected_swings_mh, 0.01 * expected_swings_mh);
-    EXPECT_NEAR(sources.white_oh_count, expected_swings_oh, 0.01 * expected_swings_oh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_mh), expected_swings_mh, 0.01 * expected_swings_mh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_oh), expected_swings_oh, 0.01 * expected_swings_oh);
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, conf_interval_mh / 2);
     EXPECT_NEAR(proc_data["test_wep_oh"], expected_procs_oh, conf_interval_oh / 2);
@@ -354,10 +360,10 @@ TEST_F(Sim_fixture, test_hit_effects_physical_damage)
     expected_procs_mh += second_order_procs;
 
     double expected_total_procs = expected_procs_oh + expected_procs_mh;
-    EXPECT_NEAR(sources.white_mh_count, expected_swings_mh, 0.01 * expected_swings_mh);
-    EXPECT_NEAR(sources.white_oh_count, expected_swings_oh, 0.01 * expected_swings_oh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_mh), expected_swings_mh, 0.01 * expected_swings_mh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_oh), expected_swings_oh, 0.01 * expected_swings_oh);
 
-    EXPECT_NEAR(sources.item_hit_effects_count, expected_total_procs, 0.03 * expected_total_procs);
+    EXPECT_NEAR(sources.get_count(Damage_source::item_hit_effects), expected_total_procs, 0.03 * expected_total_procs);
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, 0.03 * expected_procs_mh);
     EXPECT_NEAR(proc_data["test_wep_oh"], expected_procs_oh, 0.03 * expected_procs_oh);
@@ -400,10 +406,10 @@ TEST_F(Sim_fixture, test_hit_effects_magic_damage)
     double conf_interval_mh = bin_dist_mh.confidence_interval_width(0.99);
 
     double expected_total_procs = expected_procs_oh + expected_procs_mh;
-    EXPECT_NEAR(sources.white_mh_count, expected_swings_mh, 0.01 * expected_swings_mh);
-    EXPECT_NEAR(sources.white_oh_count, expected_swings_oh, 0.01 * expected_swings_oh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_mh), expected_swings_mh, 0.01 * expected_swings_mh);
+    EXPECT_NEAR(sources.get_count(Damage_source::white_oh), expected_swings_oh, 0.01 * expected_swings_oh);
 
-    EXPECT_NEAR(sources.item_hit_effects_count, expected_total_procs, 0.03 * expected_total_procs);
+    EXPECT_NEAR(sources.get_count(Damage_source::item_hit_effects), expected_total_procs, 0.03 * expected_total_procs);
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, conf_interval_mh / 2);
     EXPECT_NEAR(proc_data["test_wep_oh"], expected_procs_oh, conf_interval_oh / 2);
@@ -439,10 +445,10 @@ TEST_F(Sim_fixture, test_hit_effects_stat_boost_short_duration)
     double dodge_chance = 6.5 / 100.0;
     double hit_chance = (1 - miss_chance - dodge_chance);
 
-    double expected_procs_oh = hit_chance * sources.white_oh_count * oh_proc_prob;
+    double expected_procs_oh = hit_chance * sources.get_count(Damage_source::white_oh) * oh_proc_prob;
     double expected_uptime_oh = expected_procs_oh * oh_proc_duration;
 
-    double expected_procs_mh = hit_chance * sources.white_mh_count * mh_proc_prob;
+    double expected_procs_mh = hit_chance * sources.get_count(Damage_source::white_mh) * mh_proc_prob;
     double expected_uptime_mh = expected_procs_mh * mh_proc_duration;
 
     EXPECT_NEAR(proc_data["test_wep_mh"], expected_procs_mh, 0.03 * expected_procs_mh);
@@ -484,14 +490,14 @@ TEST_F(Sim_fixture, test_hit_effects_stat_boost_long_duration)
     double dodge_chance = 6.5 / 100.0;
     double hit_chance = (1 - miss_chance - dodge_chance);
 
-    double expected_procs_oh = hit_chance * sources.white_oh_count * oh_proc_prob;
+    double expected_procs_oh = hit_chance * sources.get_count(Damage_source::white_oh) * oh_proc_prob;
     double expected_uptime_oh = expected_procs_oh * oh_proc_duration;
     double swings_during_uptime_oh = oh_proc_duration / character.weapons[1].swing_speed;
     double procs_during_uptime_oh = hit_chance * swings_during_uptime_oh * oh_proc_prob;
     double expected_procs_during_uptime_oh = expected_procs_oh * procs_during_uptime_oh;
     double overlap_duration_oh = expected_procs_during_uptime_oh * oh_proc_duration / 2;
 
-    double expected_procs_mh = hit_chance * sources.white_mh_count * mh_proc_prob;
+    double expected_procs_mh = hit_chance * sources.get_count(Damage_source::white_mh) * mh_proc_prob;
     double expected_uptime_mh = expected_procs_mh * mh_proc_duration;
     double swings_during_uptime_mh = mh_proc_duration / character.weapons[0].swing_speed;
     double procs_during_uptime_mh = hit_chance * swings_during_uptime_mh * mh_proc_prob;
@@ -566,8 +572,8 @@ TEST_F(Sim_fixture, test_deep_wounds)
 
     auto damage_sources = sim.get_damage_distribution();
 
-    EXPECT_GT(damage_sources.deep_wounds_count, 0);
-    EXPECT_NEAR(damage_sources.deep_wounds_damage / damage_sources.deep_wounds_count, dwTick, 0.01);
+    EXPECT_GT(damage_sources.get_count(Damage_source::deep_wounds), 0);
+    EXPECT_NEAR(damage_sources.get_damage(Damage_source::deep_wounds) / damage_sources.get_count(Damage_source::deep_wounds), dwTick, 0.01);
 }
 
 TEST_F(Sim_fixture, test_flurry_uptime)
@@ -600,8 +606,8 @@ TEST_F(Sim_fixture, test_flurry_uptime)
 
     auto dd = sim.get_damage_distribution();
 
-    EXPECT_NEAR(dd.white_oh_count / (config.sim_time / oh.swing_speed * haste), (1 - flurryUptime) + flurryUptime * flurryHaste, 0.0001);
-    EXPECT_NEAR((dd.white_mh_count + dd.heroic_strike_count) / (config.sim_time / mh.swing_speed * haste), (1 - flurryUptime) + flurryUptime * flurryHaste, 0.0001);
+    EXPECT_NEAR(dd.get_count(Damage_source::white_oh) / (config.sim_time / oh.swing_speed * haste), (1 - flurryUptime) + flurryUptime * flurryHaste, 0.0001);
+    EXPECT_NEAR((dd.get_count(Damage_source::white_mh) + dd.get_count(Damage_source::heroic_strike)) / (config.sim_time / mh.swing_speed * haste), (1 - flurryUptime) + flurryUptime * flurryHaste, 0.0001);
 }
 
 void time_simulate(Combat_simulator& sim, const Character& character)
@@ -624,18 +630,14 @@ void print_results(const std::string name, const Combat_simulator& sim, bool pri
     auto g = 60 * f;
 
     std::cout << std::fixed << std::setprecision(2);
-    std::cout << "white (mh)    = " << f * dd.white_mh_damage << " (" << g * dd.white_mh_count << "x)" << std::endl;
-    if (dd.white_oh_count > 0) std::cout << "white (oh)    = " << f * dd.white_oh_damage << " (" << g * dd.white_oh_count << "x)" << std::endl;
-    if (dd.mortal_strike_count > 0) std::cout << "mortal strike = " << f * dd.mortal_strike_damage << " (" << g * dd.mortal_strike_count << "x)" << std::endl;
-    if (dd.cleave_count > 0) std::cout << "cleave        = " << f * dd.cleave_damage << " (" << g * dd.cleave_count << "x)" << std::endl;
-    if (dd.bloodthirst_count > 0) std::cout << "bloodthirst   = " << f * dd.bloodthirst_damage << " (" << g * dd.bloodthirst_count << "x)" << std::endl;
-    if (dd.whirlwind_count > 0) std::cout << "whirlwind     = " << f * dd.whirlwind_damage << " (" << g * dd.whirlwind_count << "x)" << std::endl;
-    if (dd.slam_count > 0) std::cout << "slam          = " << f * dd.slam_damage << " (" << g * dd.slam_count << "x)" << std::endl;
-    if (dd.heroic_strike_count > 0) std::cout << "heroic strike = " << f * dd.heroic_strike_damage << " (" << g * dd.heroic_strike_count << "x)" << std::endl;
-    if (dd.execute_count > 0) std::cout << "execute       = " << f * dd.execute_damage << " (" << g * dd.execute_count << "x)" << std::endl;
-    if (dd.deep_wounds_count > 0) std::cout << "deep wounds   = " << f * dd.deep_wounds_damage << " (" << g * dd.deep_wounds_count << "x)" << std::endl;
-    if (dd.overpower_count > 0) std::cout << "overpower     = " << f * dd.overpower_damage << " (" << g * dd.overpower_count << "x)" << std::endl;
-    if (dd.item_hit_effects_count > 0) std::cout << "hit effects   = " << f * dd.item_hit_effects_damage << " (" << g * dd.item_hit_effects_count << "x)" << std::endl;
+    for (size_t i = 0; i < n_damage_sources; i++)
+    {
+        if (dd.counts[i] > 0 || i == static_cast<size_t>(Damage_source::white_mh))
+        {
+            std::cout << std::left << std::setw(17) << damage_source_names[i] << " = " << f * dd.damage[i] << " ("
+                      << g * dd.counts[i] << "x)" << std::endl;
+        }
+    }
     std::cout << "----------------------" << std::endl;
     std::cout << "total         = " << f * dd.sum_damage_sources() << std::endl;
     std::cout << std::endl;
@@ -974,7 +976,6 @@ TEST_F(Sim_fixture, test_multi)
     character.talents.weapon_mastery = 2;
     character.talents.bloodthirst = 1;
 
-    srand(110000);
     auto start = std::chrono::steady_clock::now();
     const auto& single = Combat_simulator::simulate(config, character);
     auto end = std::chrono::steady_clock::now();
@@ -982,12 +983,12 @@ TEST_F(Sim_fixture, test_multi)
 
     std::cout << single << std::endl;
 
-    srand(110000);
     start = std::chrono::steady_clock::now();
     config.n_batches = 250;
     Distribution multi{};
     for (auto i = 0; i < 100; ++i)
     {
+        config.seed = 110000 + i; // same seed would just repeat the same 250 batches
         multi.add(Combat_simulator::simulate(config, character));
     }
     end = std::chrono::steady_clock::now();
@@ -996,4 +997,662 @@ TEST_F(Sim_fixture, test_multi)
     std::cout << multi << std::endl;
 
     SUCCEED();
-}
\ No newline at end of file
+}
+
+TEST_F(Sim_fixture, test_parallel_matches_serial)
+{
+    config.n_batches = 1100;
+    config.n_threads = 3;
+
+    Combat_simulator serial(config);
+    serial.simulate(character);
+
+    Combat_simulator parallel(config);
+    parallel.simulate_parallel(character);
+
+    const auto& serial_dps = serial.get_dps_distribution();
+    const auto& parallel_dps = parallel.get_dps_distribution();
+    EXPECT_EQ(parallel_dps.samples(), serial_dps.samples());
+    EXPECT_NEAR(parallel_dps.mean(), serial_dps.mean(), 1e-6);
+    EXPECT_NEAR(parallel_dps.std(), serial_dps.std(), 1e-6);
+    EXPECT_EQ(parallel.get_damage_distribution().get_count(Damage_source::white_mh), serial.get_damage_distribution().get_count(Damage_source::white_mh));
+}
+
+TEST_F(Sim_fixture, test_reset_matches_new_simulator)
+{
+    config.n_batches = 300;
+
+    // a first run with a stat boost proc and other settings, which should leave nothing behind
+    auto first_config = config;
+    first_config.combat.use_whirlwind = true;
+    first_config.seed = 17;
+    auto first_character = character;
+    first_character.weapons[0].hit_effects.push_back({"test_boost", Hit_effect::Type::stat_boost, {}, {0, 0, 300}, 0, 10, 0, 0.2});
+
+    Combat_simulator reused(first_config);
+    reused.simulate(first_character, true);
+
+    config.combat.use_bloodthirst = true;
+    reused.reset(config);
+    reused.simulate(character, true);
+
+    Combat_simulator fresh(config);
+    fresh.simulate(character, true);
+
+    EXPECT_EQ(reused.get_dps_distribution().samples(), fresh.get_dps_distribution().samples());
+    EXPECT_EQ(reused.get_dps_distribution().mean(), fresh.get_dps_distribution().mean());
+    EXPECT_EQ(reused.get_damage_distribution().get_count(Damage_source::bloodthirst),
+              fresh.get_damage_distribution().get_count(Damage_source::bloodthirst));
+    EXPECT_EQ(reused.get_proc_data(), fresh.get_proc_data());
+    EXPECT_EQ(reused.get_aura_uptimes_map(), fresh.get_aura_uptimes_map());
+    EXPECT_EQ(reused.get_hist_x(), fresh.get_hist_x());
+    EXPECT_EQ(reused.get_hist_y(), fresh.get_hist_y());
+
+    EXPECT_EQ(Combat_simulator::simulate(config, character).mean(), fresh.get_dps_distribution().mean());
+}
+
+TEST_F(Sim_fixture, test_extra_attack_chain_is_bounded)
+{
+    config.sim_time = 60.0;
+    config.n_batches = 20;
+
+    Combat_simulator plain(config);
+    plain.simulate(character);
+
+    // every landed extra attack procs the next one, a chain only ends with a miss, a dodge or a full queue. the queue
+    //  is emptied after each triggering hit, the bound is per triggering hit and not per fight
+    character.weapons[0].hit_effects.push_back({"endless", Hit_effect::Type::extra_hit, {}, {}, 0, 0, 0, 1.0});
+    Combat_simulator chained(config);
+    chained.simulate(character);
+
+    const auto plain_swings = plain.get_damage_distribution().get_count(Damage_source::white_mh);
+    const auto chained_swings = chained.get_damage_distribution().get_count(Damage_source::white_mh);
+    EXPECT_GT(chained_swings, plain_swings);
+    EXPECT_GT(chained.get_proc_data().at("endless"), 0);
+    EXPECT_GT(chained.get_longest_hit_chain(), 1);
+    EXPECT_EQ(plain.get_longest_hit_chain(), 0);
+
+    // without misses and dodges nothing ends the chain but the queue: every main hand swing (the only ones that proc
+    //  it) queues max_pending_hits extra attacks, whose last proc is dropped. that's max_pending_hits + 1 swings per
+    //  triggering hit, and one dropped proc each
+    character.total_special_stats.hit = 40;
+    character.total_special_stats.expertise = 30;
+    config.n_batches = 1;
+    config.sim_time = 20.0;
+    config.display_combat_debug = true;
+    Combat_simulator endless(config);
+    endless.simulate(character);
+    EXPECT_EQ(endless.get_longest_hit_chain(), static_cast<int>(Combat_simulator::max_pending_hits));
+
+    const auto log = endless.get_debug_topic();
+    const std::string dropped_line = "Too many extra hits queued";
+    int dropped = 0;
+    for (auto pos = log.find(dropped_line); pos != std::string::npos; pos = log.find(dropped_line, pos + 1)) dropped++;
+    const auto swings = endless.get_damage_distribution().get_count(Damage_source::white_mh);
+    const auto cap = static_cast<int>(Combat_simulator::max_pending_hits);
+    ASSERT_GT(dropped, 0);
+    EXPECT_EQ(swings, dropped * (cap + 1));
+}
+
+TEST_F(Sim_fixture, test_shared_cooldown_between_weapons)
+{
+    auto main_hand = character.weapons[0];
+    auto off_hand = character.weapons[1];
+    main_hand.hit_effects.push_back({"shared", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 20, 1.0});
+    off_hand.hit_effects.push_back({"other", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 20, 1.0});
+    off_hand.hit_effects.push_back({"shared", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 20, 1.0});
+    const Weapon_sim mh_sim(main_hand);
+    const Weapon_sim oh_sim(off_hand);
+    const auto mh_index = mh_sim.hit_effects.size() - 1;
+    const auto oh_index = oh_sim.hit_effects.size() - 1;
+
+    Weapon_state mh_state(mh_sim);
+    Weapon_state oh_state(oh_sim);
+    Use_effects::Schedule schedule{};
+    Buff_manager buff_manager{};
+    buff_manager.initialize(mh_state, &oh_state, schedule, nullptr);
+    ASSERT_EQ(mh_state.shared_cooldown[mh_index], static_cast<int>(oh_index));
+    ASSERT_EQ(oh_state.shared_cooldown[oh_index], static_cast<int>(mh_index));
+    EXPECT_EQ(oh_state.shared_cooldown[oh_index - 1], -1);
+
+    // a proc on either weapon blocks the effect on the other one, but nothing else
+    buff_manager.start_cooldown(mh_state, mh_index, 1000);
+    EXPECT_EQ(oh_state.ready_at[oh_index], 21000);
+    EXPECT_EQ(oh_state.ready_at[oh_index - 1], 0);
+    buff_manager.start_cooldown(oh_state, oh_index, 30000);
+    EXPECT_EQ(mh_state.ready_at[mh_index], 50000);
+
+    // in a fight every landed hit procs it once it's ready, for both weapons together that's one proc per 20 seconds
+    character.weapons[0].hit_effects.push_back({"shared", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 20, 1.0});
+    character.weapons[1].hit_effects.push_back({"shared", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 20, 1.0});
+    Combat_simulator shared(config);
+    shared.simulate(character);
+    const auto shared_procs = shared.get_proc_data().at("shared");
+    const auto windows = static_cast<int>(config.sim_time / 20) + 1;
+    EXPECT_GE(shared_procs, (windows - 1) * config.n_batches);
+    EXPECT_LE(shared_procs, windows * config.n_batches);
+
+    // under another name the off hand procs on its own cooldown, as often as the main hand
+    character.weapons[1].hit_effects.back().name = "separate";
+    Combat_simulator separate(config);
+    separate.simulate(character);
+    EXPECT_EQ(separate.get_proc_data().at("shared"), shared_procs);
+    EXPECT_GE(separate.get_proc_data().at("separate"), (windows - 1) * config.n_batches);
+}
+
+TEST_F(Sim_fixture, test_hit_aura_procs_while_active)
+{
+    config.n_batches = 20;
+
+    // procs on every landed hit, but only while the use effect is up: 10 of 60 seconds
+    character.weapons[0].hit_effects.push_back({"always", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 0, 1.0});
+    Hit_effect aura{"aura", Hit_effect::Type::stat_boost, {}, {0, 0, 1}, 0, 10, 0, 1.0};
+    character.use_effects.push_back({"aura", Use_effect::Effect_socket::unique, {}, {}, 0, 10, 300, false, {aura}});
+
+    Combat_simulator simulator(config);
+    simulator.simulate(character);
+
+    const auto always = simulator.get_proc_data().at("always");
+    const auto active = simulator.get_proc_data().at("aura");
+    EXPECT_GT(active, 0);
+    EXPECT_GT(active, always / 12);
+    EXPECT_LT(active, always / 3);
+    EXPECT_LE(simulator.get_aura_uptimes_map().at("aura"), 10.0 * config.n_batches);
+}
+
+TEST_F(Sim_fixture, test_proc_order_from_rng_stream)
+{
+    auto weapon = character.weapons[0];
+    weapon.hit_effects.clear();
+    for (const auto& name : {"a", "b", "c", "d", "e", "f"})
+    {
+        weapon.hit_effects.push_back({name, Hit_effect::Type::rage_boost, {}, {}, 1, 0, 0, 0.5});
+    }
+    const Weapon_sim weapon_sim(weapon);
+
+    Weapon_state first(weapon_sim);
+    Weapon_state second(weapon_sim);
+    Random_generator rng_first(1, 2);
+    Random_generator rng_second(1, 2);
+
+    auto order = [](const Weapon_state& state) {
+        std::vector<size_t> indices{};
+        for (const auto& candidate : state.candidates(Hit_result::hit)) indices.push_back(candidate.index);
+        return indices;
+    };
+
+    // states reset from the same stream check their procs in the same order, fight after fight
+    std::set<std::vector<size_t>> orders{};
+    for (int fight = 0; fight < 10; ++fight)
+    {
+        first.reset(rng_first);
+        second.reset(rng_second);
+        ASSERT_EQ(order(first).size(), weapon_sim.hit_effects.size());
+        EXPECT_EQ(order(first), order(second));
+        orders.insert(order(first));
+    }
+    EXPECT_GT(orders.size(), 1);
+}
+
+TEST_F(Sim_fixture, test_proc_candidates_by_hit_result)
+{
+    auto weapon = character.weapons[0];
+    weapon.hit_effects.clear();
+    weapon.hit_effects.push_back({"on_hit", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 0, 0.5});
+    weapon.hit_effects.push_back({"on_crit", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 0, 1.0, Hit_effect::Proc_type::crits});
+    weapon.hit_effects.push_back({"ppm", Hit_effect::Type::rage_boost, {}, {}, 1, 0, 0, 0, Hit_effect::Proc_type::hits, 1, 0, 1, 2.0});
+    weapon.hit_effects.push_back({"darkmoon_card_wrath", Hit_effect::Type::stat_boost, {}, {}, 0, 10, 0, 1.0, Hit_effect::Proc_type::crits});
+
+    const Weapon_sim weapon_sim(weapon);
+    Weapon_state state(weapon_sim);
+    Random_generator rng(1, 2);
+    state.reset(rng);
+
+    EXPECT_NEAR(state.proc_chance[2], 2.0 * weapon_sim.swing_speed / 60, 1e-12);
+
+    // the card only loses a charge on anything but a crit
+    const auto& on_hit = state.candidates(Hit_result::hit);
+    ASSERT_EQ(on_hit.size(), 3);
+    for (const auto& candidate : on_hit)
+    {
+        EXPECT_NE(candidate.index, 1);
+        EXPECT_EQ(candidate.procs, candidate.index != 3);
+    }
+    EXPECT_EQ(state.candidates(Hit_result::crit).size(), 4);
+    ASSERT_EQ(state.candidates(Hit_result::miss).size(), 1);
+    EXPECT_FALSE(state.candidates(Hit_result::miss)[0].procs);
+}
+
+TEST_F(Sim_fixture, test_replay_fight)
+{
+    config.n_batches = 1200;
+    config.n_threads = 2;
+
+    auto check_replays = [this](const Combat_simulator_config& run_config) {
+        Combat_simulator sim(run_config);
+        sim.simulate_parallel(character, true);
+
+        const auto fights = sim.get_notable_fights();
+        ASSERT_EQ(fights.size(), 5);
+        EXPECT_EQ(fights.front().first, "min");
+        EXPECT_EQ(fights.back().first, "max");
+        for (size_t i = 1; i < fights.size(); ++i)
+        {
+            EXPECT_LE(fights[i - 1].second.dps, fights[i].second.dps);
+        }
+
+        // the same fight, with the combat log on
+        for (const auto& [name, fight] : fights)
+        {
+            const auto replay = Combat_simulator::replay_fight(run_config, character, fight.batch);
+            EXPECT_EQ(replay.dps, fight.dps) << name;
+            EXPECT_FALSE(replay.combat_log.empty()) << name;
+            EXPECT_EQ(Combat_simulator::replay_fight(run_config, character, fight.batch).combat_log, replay.combat_log) << name;
+        }
+    };
+    check_replays(config);
+
+    // a batch of an antithetic pair draws from the stream of batch / 2, mirrored for the odd one. the replay of either
+    //  twin is that fight and not the other one
+    config.antithetic_batches = true;
+    check_replays(config);
+    const auto even = Combat_simulator::replay_fight(config, character, 100);
+    const auto odd = Combat_simulator::replay_fight(config, character, 101);
+    EXPECT_NE(even.dps, odd.dps);
+    Combat_simulator pair(config);
+    pair.simulate(character, 100, 2);
+    EXPECT_NEAR(pair.get_dps_distribution().mean(), (even.dps + odd.dps) / 2, 1e-9);
+}
+
+TEST_F(Sim_fixture, test_stat_gradient)
+{
+    config.n_batches = 4000;
+
+    Special_stats more_ap{};
+    more_ap.attack_power = 200;
+    Special_stats nothing{};
+
+    const auto gradient = simulate_stat_gradient(config, character, {more_ap, nothing});
+    ASSERT_EQ(gradient.gains.size(), 2);
+    ASSERT_EQ(gradient.standard_errors.size(), 2);
+
+    EXPECT_GT(gradient.gains[0], 5 * gradient.standard_errors[0]);
+    EXPECT_LT(std::abs(gradient.gains[1]), 4 * gradient.standard_errors[1]);
+}
+
+TEST_F(Sim_fixture, test_stat_step_stays_within_bounds)
+{
+    Special_stats hit{};
+    hit.hit = 2;
+    Special_stats base{};
+
+    // no hit below zero, and not across the yellow hit cap (9% at level 73)
+    base.hit = 0.5;
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).up, 1);
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).down, 0.25);
+    base.hit = 8;
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).up, 0.5);
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).down, 1);
+
+    // at a cap only the step up is left
+    base.hit = 9;
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).up, 1);
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).down, 0);
+    base.hit = 27;
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).up, 0.5);
+    EXPECT_DOUBLE_EQ(stat_step(config, base, hit).down, 1);
+
+    Special_stats ap{};
+    ap.attack_power = 200;
+    EXPECT_DOUBLE_EQ(stat_step(config, base, ap).down, 0);
+    base.attack_power = 2000;
+    EXPECT_DOUBLE_EQ(stat_step(config, base, ap).up, 1);
+    EXPECT_DOUBLE_EQ(stat_step(config, base, ap).down, 1);
+}
+
+TEST_F(Sim_fixture, test_stat_gradient_past_the_hit_cap)
+{
+    config.n_batches = 1000;
+    character.total_special_stats.hit = Combat_simulator::dual_wield_hit_cap(config.main_target_level);
+
+    Special_stats more_hit{};
+    more_hit.hit = 1.5;
+
+    // a central step would have stepped below the cap. only stepping up, the hit tables and so the fights of a row don't
+    //  change
+    const auto gradient = simulate_stat_gradient(config, character, {more_hit});
+    EXPECT_EQ(gradient.gains[0], 0);
+    EXPECT_EQ(gradient.standard_errors[0], 0);
+}
+
+TEST_F(Sim_fixture, test_target_precision)
+{
+    config.n_batches = 20000;
+    config.target_precision = 10.0;
+
+    Combat_simulator sim(config);
+    sim.simulate_parallel(character);
+
+    const auto& dps = sim.get_dps_distribution();
+    double q95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
+    EXPECT_LT(dps.samples(), config.n_batches);
+    EXPECT_LE(q95 * dps.std_of_the_mean(), config.target_precision);
+    EXPECT_EQ(dps.samples() % 500, 0); // stops on chunk boundaries
+}
+
+TEST_F(Sim_fixture, test_dps_percentiles)
+{
+    config.n_batches = 1000;
+
+    Combat_simulator sim(config);
+    sim.simulate(character, true);
+
+    const auto& dps = sim.get_dps_distribution();
+    const auto& sketch = sim.get_dps_sketch();
+    EXPECT_EQ(sketch.samples(), dps.samples());
+    EXPECT_LE(sketch.min(), sketch.quantile(0.05));
+    EXPECT_LT(sketch.quantile(0.05), sketch.quantile(0.5));
+    EXPECT_LT(sketch.quantile(0.5), sketch.quantile(0.95));
+    EXPECT_LE(sketch.quantile(0.95), sketch.max());
+    EXPECT_NEAR(sketch.quantile(0.5), dps.mean(), 2 * dps.std());
+}
+
+TEST(TestSuite, test_damage_sources_accumulate)
+{
+    Damage_sources a{};
+    a.add_damage(Damage_source::white_mh, 100);
+    a.add_damage(Damage_source::white_mh, 50);
+    a.add_damage(Damage_source::sweeping_strikes, 20);
+
+    Damage_sources b{};
+    b.add_damage(Damage_source::deep_wounds, 30);
+    b.add_damage(Damage_source::white_mh, 10);
+
+    a += b;
+    EXPECT_EQ(a.get_damage(Damage_source::white_mh), 160);
+    EXPECT_EQ(a.get_count(Damage_source::white_mh), 3);
+    EXPECT_EQ(a.get_damage(Damage_source::deep_wounds), 30);
+    EXPECT_EQ(a.get_count(Damage_source::sweeping_strikes), 1);
+    EXPECT_EQ(a.sum_damage_sources(), 210);
+    EXPECT_EQ(a.sum_counts(), 5);
+}
+
+TEST_F(Sim_fixture, test_fight_length_sweep)
+{
+    config.n_batches = 2000;
+    config.sim_time = 300;
+    config.execute_phase_percentage_ = 20;
+    config.combat.use_bloodthirst = true;
+    config.combat.use_whirlwind = true;
+    config.combat.use_heroic_strike = true;
+    config.fight_length_sweep = {120, 180, 300, 600};
+
+    Combat_simulator sim(config);
+    sim.simulate(character);
+
+    // 600 s doesn't fit into the simulated fight
+    ASSERT_EQ(sim.get_fight_lengths().size(), 3);
+    const auto& sweep = sim.get_fight_length_dps();
+    EXPECT_EQ(sweep[2].samples(), config.n_batches);
+    EXPECT_NEAR(sweep[2].mean(), sim.get_dps_distribution().mean(), 1e-6);
+
+    // the approximation should stay close to actually simulating the shorter fight
+    auto short_config = config;
+    short_config.sim_time = 120;
+    short_config.fight_length_sweep.clear();
+    Combat_simulator short_sim(short_config);
+    short_sim.simulate(character);
+    const auto& short_dps = short_sim.get_dps_distribution();
+    EXPECT_NEAR(sweep[0].mean(), short_dps.mean(), 0.02 * short_dps.mean());
+}
+
+TEST_F(Sim_fixture, test_fight_length_sweep_any_order)
+{
+    config.n_batches = 50;
+    config.sim_time = 300;
+    config.execute_phase_percentage_ = 20;
+    config.fight_length_sweep = {300, 120, 180, 120};
+
+    Combat_simulator sim(config);
+    sim.simulate(character);
+
+    EXPECT_EQ(sim.get_fight_lengths(), (std::vector<double>{120, 180, 300}));
+    EXPECT_NEAR(sim.get_fight_length_dps()[2].mean(), sim.get_dps_distribution().mean(), 1e-6);
+}
+
+TEST_F(Sim_fixture, test_schedule_search_gain_is_paired)
+{
+    config.n_batches = 200;
+    config.sim_time = 120;
+
+    // without use effects both schedules are empty, so every fight comes out the same
+    const auto gain = Combat_simulator::schedule_search_gain(config, character);
+    ASSERT_EQ(gain.samples(), config.n_batches);
+    EXPECT_EQ(gain.mean(), 0.0);
+    EXPECT_EQ(gain.std(), 0.0);
+
+    // bloodlust is never reversed, the search moves the trinket from the end of the fight next to it. the pairing keeps
+    //  the error small enough that the gain is significant
+    config.sim_time = 300;
+    config.reverse_cooldown = true;
+    config.n_batches = 1200; // more than one chunk per simulation, the fights have to be merged in batch order
+    config.n_threads = 2;
+    character.use_effects.push_back({"bloodlust", Use_effect::Effect_socket::unique, {}, {0, 0, 0, 0, .3}, 0, 40, 600, false});
+    character.use_effects.push_back({"trinket", Use_effect::Effect_socket::shared, {}, {0, 0, 300}, 0, 20, 300, true});
+    const auto trinket_gain = Combat_simulator::schedule_search_gain(config, character);
+    ASSERT_EQ(trinket_gain.samples(), config.n_batches);
+    EXPECT_GT(trinket_gain.std(), 0.0);
+    const double q95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
+    EXPECT_GT(trinket_gain.mean() - q95 * trinket_gain.std_of_the_mean(), 0.0);
+}
+
+TEST_F(Sim_fixture, test_encounter_windows)
+{
+    config.n_batches = 200;
+    config.sim_time = 60;
+    config.exposed_armor = true;
+    config.encounter_windows = {{Encounter_window::Type::downtime, 20, 50}, {Encounter_window::Type::adds, 10, 30, 2}};
+
+    const auto events = compile_encounter(config);
+    ASSERT_EQ(events.size(), 6);
+    EXPECT_TRUE(std::is_sorted(events.begin(), events.end(),
+                               [](const auto& a, const auto& b) { return a.time < b.time; }));
+    EXPECT_EQ(events[0].type, Encounter_event::Type::armor_reduction);
+    EXPECT_EQ(events[1].value, 2);
+
+    auto uptime_config = config;
+    uptime_config.encounter_windows.clear();
+    Combat_simulator full(uptime_config);
+    full.simulate(character);
+
+    // half of the fight without anything to attack
+    Combat_simulator with_downtime(config);
+    with_downtime.simulate(character);
+    const double ratio = double(with_downtime.get_damage_distribution().get_count(Damage_source::white_mh)) /
+                         full.get_damage_distribution().get_count(Damage_source::white_mh);
+    EXPECT_NEAR(ratio, 0.5, 0.05);
+}
+
+TEST_F(Sim_fixture, test_target_switch_windows)
+{
+    config.n_batches = 1;
+    config.sim_time = 60;
+    config.extra_target_initial_armor_ = 0;
+    config.display_combat_debug = true;
+    config.encounter_windows = {{Encounter_window::Type::target_switch, 20.25, 40.75}};
+
+    // the switches happen when the window says, not at the next swing or cooldown after it
+    Combat_simulator simulator(config);
+    simulator.simulate(character);
+    const auto log = simulator.get_debug_topic();
+    EXPECT_NE(log.find("Time: 20.250s. Switching to an add.<br>Time: 20.250s. Target armor: 0."), std::string::npos);
+    EXPECT_NE(log.find("Time: 40.750s. Switching back to the boss."), std::string::npos);
+
+    // a third of the fight against an add without armor
+    config.n_batches = 200;
+    config.display_combat_debug = false;
+    Combat_simulator with_switch(config);
+    with_switch.simulate(character);
+    auto boss_config = config;
+    boss_config.encounter_windows.clear();
+    Combat_simulator boss_only(boss_config);
+    boss_only.simulate(character);
+    EXPECT_GT(with_switch.get_dps_distribution().mean(), boss_only.get_dps_distribution().mean());
+}
+
+TEST_F(Sim_fixture, test_response_surface)
+{
+    config.n_batches = 500;
+    config.combat.use_bloodthirst = true;
+    config.combat.use_heroic_strike = true;
+
+    Response_surface surface{{{"hit", Stat_field::hit, 0, 9, 3}, {"crit", Stat_field::critical_strike, 10, 30, 3}}};
+    const auto design = surface.grid_design();
+    ASSERT_EQ(design.size(), 9);
+    surface.run(config, character, design);
+
+    ASSERT_EQ(surface.coefficients().size(), 6);
+    EXPECT_EQ(surface.term_names()[4], "hit*crit");
+    // both stats are worth something over the whole range
+    EXPECT_GT(surface.coefficients()[1], 0);
+    EXPECT_GT(surface.coefficients()[2], 0);
+    for (const auto& point : surface.points())
+    {
+        EXPECT_NEAR(surface.predict(point.x), point.dps, 0.02 * point.dps);
+    }
+}
+
+TEST(TestSuite, test_latin_hypercube_design)
+{
+    Response_surface surface{{{"hit", Stat_field::hit, 0, 10, 0}, {"arpen", Stat_field::gear_armor_pen, 0, 1000, 0}}};
+    const auto design = surface.latin_hypercube_design(10, 1);
+    ASSERT_EQ(design.size(), 10);
+
+    // every tenth of each axis holds exactly one point
+    std::vector<int> hit_strata(10);
+    std::vector<int> arpen_strata(10);
+    for (const auto& x : design)
+    {
+        hit_strata[static_cast<int>(x[0])]++;
+        arpen_strata[static_cast<int>(x[1] / 100)]++;
+    }
+    EXPECT_EQ(hit_strata, std::vector<int>(10, 1));
+    EXPECT_EQ(arpen_strata, std::vector<int>(10, 1));
+}
+
+TEST_F(Sim_fixture, test_control_variates_dps)
+{
+    config.n_batches = 2000;
+    config.combat.use_bloodthirst = true;
+    config.combat.use_whirlwind = true;
+    config.combat.use_heroic_strike = true;
+    character.weapons[0].hit_effects.push_back({"proc", Hit_effect::Type::stat_boost, {}, {0, 0, 300}, 0, 10, 0, 0.1});
+
+    Combat_simulator sim(config);
+    sim.simulate(character);
+
+    const auto& dps = sim.get_dps_distribution();
+    const auto& adjusted = sim.get_dps_control_variates();
+    EXPECT_EQ(adjusted.samples(), dps.samples());
+    EXPECT_LT(adjusted.std_of_the_mean(), dps.std_of_the_mean());
+    EXPECT_LT(adjusted.variance_ratio(), 0.9);
+    EXPECT_NEAR(adjusted.mean(), dps.mean(), 4 * dps.std_of_the_mean());
+}
+
+TEST_F(Sim_fixture, test_antithetic_batches)
+{
+    Random_generator rng(3, 5);
+    Random_generator twin;
+    twin.seed(3, 5, true);
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_NEAR(rng.uniform(100) + twin.uniform(100), 100, 1e-9);
+    }
+
+    // arms with 30% crit, once with a two-hander and once dual wielding. misses, dodges, glances and crits make up more
+    //  than half the white table, the monotone read of the table still puts the twin of a crit on a miss or a glance
+    character.total_special_stats.critical_strike = 30;
+    character.talents.mortal_strike = 1;
+    config.n_batches = 2000;
+    config.combat.use_mortal_strike = true;
+    config.combat.use_heroic_strike = true;
+
+    auto two_hander = character;
+    two_hander.equip_weapon(Weapon{"test_2h", {}, {}, 3.6, 400, 400, Weapon_socket::two_hand, Weapon_type::axe});
+    for (const auto& setup : {two_hander, character})
+    {
+        Combat_simulator plain(config);
+        plain.simulate(setup);
+
+        auto antithetic_config = config;
+        antithetic_config.antithetic_batches = true;
+        Combat_simulator antithetic(antithetic_config);
+        antithetic.simulate(setup);
+
+        EXPECT_EQ(antithetic.get_dps_distribution().samples(), config.n_batches);
+        // the control variates are fitted to the pair means
+        EXPECT_EQ(antithetic.get_dps_control_variates().samples(), config.n_batches / 2);
+        EXPECT_LT(antithetic.get_dps_std_of_the_mean(), plain.get_dps_std_of_the_mean()) << setup.is_dual_wield();
+        EXPECT_NEAR(antithetic.get_dps_distribution().mean(), plain.get_dps_distribution().mean(),
+                    4 * (antithetic.get_dps_std_of_the_mean() + plain.get_dps_std_of_the_mean()));
+    }
+}
+
+TEST_F(Sim_fixture, test_shards_merge_like_parallel)
+{
+    config.n_batches = 1500;
+    config.seed = 7;
+    config.combat.use_bloodthirst = true;
+    config.combat.use_whirlwind = true;
+    config.combat.use_heroic_strike = true;
+
+    Combat_simulator reference(config);
+    reference.simulate_parallel(character);
+
+    Combat_simulator merged(config);
+    for (int i = 0; i < 4; i++)
+    {
+        const auto shard = shard_range(config.seed, config.n_batches, i, 4);
+        const std::string path = "test_shard_" + std::to_string(i) + ".bin";
+        ASSERT_TRUE(run_shard(config, character, shard, path));
+
+        Combat_simulator part(Combat_simulator_config{});
+        auto header = read_shard(path, part);
+        std::remove(path.c_str());
+        ASSERT_TRUE(header);
+        EXPECT_EQ(header->first_batch, shard.first_batch);
+        EXPECT_EQ(header->n_batches, shard.n_batches);
+        merged.merge(part);
+    }
+
+    EXPECT_EQ(merged.get_dps_distribution().samples(), config.n_batches);
+    EXPECT_NEAR(merged.get_dps_distribution().mean(), reference.get_dps_distribution().mean(), 1e-9);
+    EXPECT_NEAR(merged.get_dps_distribution().std_of_the_mean(), reference.get_dps_distribution().std_of_the_mean(), 1e-9);
+    EXPECT_EQ(merged.get_dps_sketch().quantile(0.5), reference.get_dps_sketch().quantile(0.5));
+    EXPECT_NEAR(merged.get_dps_control_variates().mean(), reference.get_dps_control_variates().mean(), 1e-6);
+    EXPECT_EQ(merged.get_damage_distribution().counts, reference.get_damage_distribution().counts);
+    EXPECT_EQ(merged.get_proc_data(), reference.get_proc_data());
+
+    // the merged time lapse is the one of the parts, a fresh simulator takes it over from the first
+    ASSERT_EQ(merged.get_damage_time_lapse().size(), static_cast<size_t>(Damage_source::size));
+    double time_lapse_damage = 0;
+    for (const auto& source : merged.get_damage_time_lapse())
+    {
+        for (const auto& damage : source) time_lapse_damage += damage;
+    }
+    EXPECT_NEAR(time_lapse_damage, merged.get_damage_distribution().sum_damage_sources(), 1e-6 * time_lapse_damage);
+
+    // shards of another fight length don't fit into it
+    auto longer = config;
+    longer.sim_time = 2 * config.sim_time;
+    const auto shard = shard_range(longer.seed, longer.n_batches, 0, 4);
+    ASSERT_TRUE(run_shard(longer, character, shard, "test_shard_longer.bin"));
+    Combat_simulator longer_part(Combat_simulator_config{});
+    ASSERT_TRUE(read_shard("test_shard_longer.bin", longer_part));
+    std::remove("test_shard_longer.bin");
+    EXPECT_FALSE(merged.can_merge(longer_part));
+    EXPECT_TRUE(Combat_simulator(config).can_merge(longer_part));
+
+    Combat_simulator broken(Combat_simulator_config{});
+    EXPECT_FALSE(read_shard("no_such_shard.bin", broken));
+}
@@ -0,0 +1,90 @@
+#include "stat_accumulator.hpp"
+#include "gtest/gtest.h"
+
+TEST(TestSuite, test_stat_accumulator_matches_composition)
+{
+    Special_stats base{20, 5, 2000};
+    base.haste = 0.1;
+    base.ap_multiplier = 0.1;
+    base.attack_speed = 0.05;
+    base.damage_mod_physical = 0.02;
+
+    Special_stats flurry{};
+    flurry.attack_speed = 0.25;
+    Special_stats trinket{0, 0, 278};
+    Special_stats haste_rating{};
+    haste_rating.haste = 0.2;
+    Special_stats damage_mod{};
+    damage_mod.damage_mod_physical = 0.2;
+
+    Stat_accumulator acc{base};
+    acc.add(Stat_delta{flurry});
+    acc.add(Stat_delta{trinket}, 2);
+    acc.add(Stat_delta{haste_rating});
+    acc.add(Stat_delta{damage_mod});
+
+    auto composed = base + flurry + trinket + trinket + haste_rating + damage_mod;
+    EXPECT_NEAR(acc.get().attack_power, composed.attack_power, 1e-9);
+    EXPECT_NEAR(acc.get().haste, composed.haste, 1e-12);
+    EXPECT_NEAR(acc.get().attack_speed, composed.attack_speed, 1e-12);
+    EXPECT_NEAR(acc.get().damage_mod_physical, composed.damage_mod_physical, 1e-12);
+    EXPECT_EQ(acc.get().critical_strike, composed.critical_strike);
+}
+
+TEST(TestSuite, test_stat_accumulator_exact_on_removal)
+{
+    Special_stats base{23.7, 3.1, 2345.6};
+    base.haste = 0.13;
+    base.attack_speed = 0.07;
+    base.ap_multiplier = 0.1;
+
+    Special_stats flurry{};
+    flurry.attack_speed = 0.3;
+    Special_stats proc{1.7, 0, 123.4};
+    proc.haste = 0.0823;
+
+    const Stat_delta flurry_delta{flurry};
+    const Stat_delta proc_delta{proc};
+    EXPECT_EQ(flurry_delta.entries.size(), 1);
+    EXPECT_EQ(proc_delta.entries.size(), 3);
+
+    Stat_accumulator acc{base};
+    for (int i = 0; i < 100000; ++i)
+    {
+        acc.add(flurry_delta);
+        acc.add(proc_delta, 3);
+        acc.remove(flurry_delta);
+        acc.remove(proc_delta, 3);
+    }
+
+    EXPECT_EQ(acc.get().attack_power, base.attack_power);
+    EXPECT_EQ(acc.get().haste, base.haste);
+    EXPECT_EQ(acc.get().attack_speed, base.attack_speed);
+    EXPECT_EQ(acc.get().critical_strike, base.critical_strike);
+}
+
+TEST(TestSuite, test_stat_accumulator_dirty_fields)
+{
+    Stat_accumulator acc{Special_stats{20, 5, 2000}};
+    const auto hit_table_inputs = stat_mask(Stat_field::critical_strike, Stat_field::hit);
+    const auto mitigation_inputs = stat_mask(Stat_field::gear_armor_pen);
+
+    // everything is dirty after a reset
+    EXPECT_TRUE(acc.take_dirty(hit_table_inputs));
+    EXPECT_TRUE(acc.take_dirty(mitigation_inputs));
+    EXPECT_FALSE(acc.take_dirty(hit_table_inputs));
+
+    const Stat_delta ap_proc{Special_stats{0, 0, 300}};
+    acc.add(ap_proc);
+    EXPECT_FALSE(acc.take_dirty(hit_table_inputs));
+    EXPECT_FALSE(acc.take_dirty(mitigation_inputs));
+
+    const Stat_delta crit_proc{Special_stats{5, 0, 0}};
+    acc.add(crit_proc);
+    EXPECT_FALSE(acc.take_dirty(mitigation_inputs));
+    EXPECT_TRUE(acc.take_dirty(hit_table_inputs));
+
+    acc.remove(crit_proc);
+    EXPECT_TRUE(acc.take_dirty(hit_table_inputs));
+    EXPECT_EQ(acc.get().critical_strike, 20);
+}
@@ -0,0 +1,55 @@
+#include "simulation_fixture.cpp"
+#include "surrogate_model.hpp"
+
+#include <cstdio>
+
+TEST_F(Sim_fixture, test_surrogate_model_fit)
+{
+    config.n_batches = 4000;
+
+    const auto model = Surrogate_model::fit(config, character);
+    ASSERT_TRUE(model.fitted());
+    ASSERT_EQ(model.weights().size(), Surrogate_model::field_names().size());
+    ASSERT_EQ(model.errors().size(), model.weights().size());
+    EXPECT_GT(model.weights()[0], 0);
+    EXPECT_LT(model.errors()[0], model.weights()[0]);
+
+    // gains are counted at the low end of their interval and losses at the high end, either way not above the estimate
+    Special_stats gain{};
+    gain.attack_power = 100;
+    gain.critical_strike = 2;
+    gain.hit = 1;
+    EXPECT_LE(model.ap_diff_low({}, gain), model.ap_diff({}, gain));
+    EXPECT_LE(model.ap_diff_low(gain, {}), model.ap_diff(gain, {}));
+    EXPECT_NEAR(model.ap_diff({}, gain), -model.ap_diff(gain, {}), 1e-9);
+    EXPECT_NEAR(model.dps_diff({}, gain), model.weights()[0] * model.ap_diff({}, gain), 1e-9);
+}
+
+TEST_F(Sim_fixture, test_surrogate_model_save_load)
+{
+    config.n_batches = 1000;
+    const auto model = Surrogate_model::fit(config, character);
+    ASSERT_TRUE(model.fitted());
+
+    const std::string path = "test_surrogate_model.bin";
+    ASSERT_TRUE(model.save(path, 42));
+
+    // a model fitted for another character is not taken
+    Surrogate_model other{};
+    EXPECT_FALSE(other.load(path, 43));
+    EXPECT_FALSE(other.fitted());
+
+    Surrogate_model loaded{};
+    ASSERT_TRUE(loaded.load(path, 42));
+    EXPECT_EQ(loaded.weights(), model.weights());
+    EXPECT_EQ(loaded.errors(), model.errors());
+
+    // load_or_fit finds it too, and doesn't fit again
+    auto other_config = config;
+    other_config.n_batches = 10;
+    const auto cached = Surrogate_model::load_or_fit(path, 42, other_config, character);
+    EXPECT_EQ(cached.weights(), model.weights());
+
+    std::remove(path.c_str());
+    EXPECT_FALSE(Surrogate_model{}.load(path, 42));
+}
@@ -116,3 +116,50 @@ TEST(TestSuite, test_use_effects)
     EXPECT_EQ(bf, 3);
     EXPECT_EQ(bs, 2);
 }
+
+TEST(TestSuite, test_use_effect_schedule_search)
+{
+    // bloodlust is never reversed, so with reverse_cooldown the trinket starts out far away from it
+    Use_effect bloodlust{"bloodlust", Use_effect::Effect_socket::unique, {}, {0, 0, 0, 0, .3}, 0, 40, 600, false};
+    Use_effect trinket{"trinket", Use_effect::Effect_socket::shared, {}, {0, 0, 200}, 0, 20, 300, true};
+    Use_effect trinket2{"trinket2", Use_effect::Effect_socket::shared, {}, {0, 0, 150}, 0, 15, 60, true};
+
+    std::vector<Use_effect> use_effects{bloodlust, trinket, trinket2};
+    int sim_time = 300000;
+    auto schedule = Use_effects::compute_schedule(use_effects, Special_stats{}, sim_time, 1500, true);
+    Use_effects::optimize_schedule(schedule, Special_stats{}, sim_time, 1500);
+    EXPECT_TRUE(is_ascending(schedule));
+
+    std::vector<int> trinket2_times;
+    for (const auto& e : schedule)
+    {
+        const auto& ue = e.second.get();
+        if (ue.name == "bloodlust")
+        {
+            EXPECT_EQ(e.first, 260000);
+        }
+        if (ue.name == "trinket")
+        {
+            EXPECT_GE(e.first, 260000);
+            EXPECT_LE(e.first, 280000);
+        }
+        if (ue.name == "trinket2")
+        {
+            trinket2_times.push_back(e.first);
+        }
+
+        // shared effects never overlap
+        for (const auto& other : schedule)
+        {
+            const auto& oe = other.second.get();
+            if (&oe == &ue || oe.effect_socket != Use_effect::Effect_socket::shared || ue.effect_socket != Use_effect::Effect_socket::shared) continue;
+            EXPECT_TRUE(e.first + ue.duration <= other.first || other.first + oe.duration <= e.first);
+        }
+    }
+
+    EXPECT_GE(trinket2_times.size(), 3u);
+    for (size_t i = 1; i < trinket2_times.size(); i++)
+    {
+        EXPECT_GE(trinket2_times[i] - trinket2_times[i - 1], 60000);
+    }
+}
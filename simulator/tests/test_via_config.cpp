@@ -11,7 +11,7 @@
 TEST_F(Sim_fixture, test_via_config)
 {
     std::filesystem::path p;
-    for (auto pp = std::filesystem::current_path(); pp.has_parent_path(); pp = pp.parent_path())
+    for (auto pp = std::filesystem::current_path(); pp.has_relative_path(); pp = pp.parent_path())
     {
         if (pp.filename() == "TBC_DPS_Warrior_Sim")
         {
@@ -0,0 +1,138 @@
+// Combines the partial results of shards (cp. shard.hpp) that ran in separate processes.
+//
+//   merge_shards [-o merged.bin] shard_0.bin shard_1.bin ...
+//
+// Shards are merged in batch order, so the result doesn't depend on the order of the arguments. If batches of the job
+// are missing, they're listed so that only those shards have to be rerun. With -o the merged partial result is
+// written as a shard again, so merges can be done in stages.
+
+#include "Statistics.hpp"
+#include "shard.hpp"
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+    std::string output_path{};
+    std::vector<std::string> paths{};
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+        if (arg == "-o" && i + 1 < argc)
+        {
+            output_path = argv[++i];
+        }
+        else
+        {
+            paths.emplace_back(arg);
+        }
+    }
+    if (paths.empty())
+    {
+        std::cout << "usage: merge_shards [-o merged.bin] shard_0.bin shard_1.bin ..." << std::endl;
+        return 2;
+    }
+
+    struct Part
+    {
+        std::string path;
+        Shard_header shard;
+        Combat_simulator results;
+    };
+    std::vector<Part> parts{};
+    parts.reserve(paths.size());
+    for (const auto& path : paths)
+    {
+        Combat_simulator results{Combat_simulator_config{}};
+        auto shard = read_shard(path, results);
+        if (!shard)
+        {
+            std::cout << "'" << path << "' is not a readable shard file" << std::endl;
+            return 1;
+        }
+        if (!parts.empty() && (shard->seed != parts.front().shard.seed || shard->total_batches != parts.front().shard.total_batches))
+        {
+            std::cout << "'" << path << "' belongs to a different job (seed or number of batches differ)" << std::endl;
+            return 1;
+        }
+        parts.push_back({path, *shard, std::move(results)});
+    }
+    // simulators can't be assigned, so the order is kept aside
+    std::vector<const Part*> ordered{};
+    for (const auto& part : parts)
+    {
+        ordered.push_back(&part);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const Part* a, const Part* b) { return a->shard.first_batch < b->shard.first_batch; });
+
+    bool complete = true;
+    int next_batch = 0;
+    for (const auto* part : ordered)
+    {
+        if (part->shard.first_batch < next_batch)
+        {
+            std::cout << "shards overlap at batch " << part->shard.first_batch << std::endl;
+            return 1;
+        }
+        if (part->shard.first_batch > next_batch)
+        {
+            std::cout << "missing batches [" << next_batch << ", " << part->shard.first_batch << ")" << std::endl;
+            complete = false;
+        }
+        next_batch = part->shard.first_batch + part->shard.n_batches;
+    }
+    if (next_batch < parts.front().shard.total_batches)
+    {
+        std::cout << "missing batches [" << next_batch << ", " << parts.front().shard.total_batches << ")" << std::endl;
+        complete = false;
+    }
+
+    // the first part is the base, so its time lapse buckets are kept
+    Combat_simulator merged = ordered.front()->results;
+    for (size_t i = 1; i < ordered.size(); i++)
+    {
+        if (!merged.can_merge(ordered[i]->results))
+        {
+            std::cout << "'" << ordered[i]->path << "' belongs to a different job (fight length differs)" << std::endl;
+            return 1;
+        }
+        merged.merge(ordered[i]->results);
+    }
+
+    if (!output_path.empty())
+    {
+        Shard_header shard = ordered.front()->shard;
+        shard.n_batches = next_batch - shard.first_batch;
+        if (!complete)
+        {
+            std::cout << "not writing '" << output_path << "', batches are missing" << std::endl;
+            return 1;
+        }
+        if (!write_shard(output_path, shard, merged))
+        {
+            std::cout << "could not write '" << output_path << "'" << std::endl;
+            return 1;
+        }
+    }
+
+    static const double q95 = Statistics::find_cdf_quantile(Statistics::get_two_sided_p_value(0.95), 0.01);
+    const auto& dps = merged.get_dps_distribution();
+    const auto& sketch = merged.get_dps_sketch();
+    std::cout << "batches: " << dps.samples() << " of " << parts.front().shard.total_batches << std::endl;
+    std::cout << "dps: " << dps.mean() << " +- " << q95 * dps.std_of_the_mean() << std::endl;
+    std::cout << "dps percentiles (5/50/95): " << sketch.quantile(0.05) << " / " << sketch.quantile(0.5) << " / "
+              << sketch.quantile(0.95) << std::endl;
+
+    const auto& damage = merged.get_damage_distribution();
+    const double total_damage = damage.sum_damage_sources();
+    for (size_t i = 0; i < n_damage_sources; i++)
+    {
+        if (damage.counts[i] == 0) continue;
+        std::cout << damage_source_names[i] << ": " << 100 * damage.damage[i] / total_damage << "% ("
+                  << damage.counts[i] << " hits)" << std::endl;
+    }
+    return complete ? 0 : 1;
+}
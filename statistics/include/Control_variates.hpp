@@ -0,0 +1,54 @@
+#ifndef WOW_SIMULATOR_CONTROL_VARIATES_HPP
+#define WOW_SIMULATOR_CONTROL_VARIATES_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Binary_reader;
+class Binary_writer;
+
+// Mean of samples that come with covariates of known mean zero (control variates). The part of the samples' noise
+// that is explained by the covariates is regressed out, which leaves the same mean with a smaller standard error.
+// Only sums are kept, so two of them merge by adding those up.
+class Control_variates
+{
+public:
+    explicit Control_variates(size_t n_covariates);
+
+    void add_sample(double sample, const std::vector<double>& covariates);
+
+    void add(const Control_variates& other);
+
+    [[nodiscard]] int64_t samples() const { return n_samples_; }
+    [[nodiscard]] size_t n_covariates() const { return n_; }
+
+    // regression coefficients of the samples on the covariates; covariates that never moved get 0
+    [[nodiscard]] std::vector<double> coefficients() const;
+
+    // plain mean minus the part the covariates explain
+    [[nodiscard]] double mean() const;
+    [[nodiscard]] double std_of_the_mean() const;
+
+    // what's left of the variance of the samples after the adjustment, in [0, 1]
+    [[nodiscard]] double variance_ratio() const;
+
+    void save(Binary_writer& writer) const;
+    void load(Binary_reader& reader);
+
+private:
+    [[nodiscard]] double covariance_xx(size_t i, size_t j) const;
+    [[nodiscard]] double covariance_xy(size_t i) const;
+    [[nodiscard]] double variance_y() const;
+    [[nodiscard]] double residual_variance() const;
+
+    size_t n_;
+    int64_t n_samples_{};
+    double sum_y_{};
+    double sum_yy_{};
+    std::vector<double> sum_x_;
+    std::vector<double> sum_xx_; // n x n, row major
+    std::vector<double> sum_xy_;
+};
+
+#endif // WOW_SIMULATOR_CONTROL_VARIATES_HPP
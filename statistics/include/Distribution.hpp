@@ -5,6 +5,9 @@
 #include <ostream>
 #include <cmath>
 
+class Binary_reader;
+class Binary_writer;
+
 class Distribution
 {
 public:
@@ -25,12 +28,15 @@ public:
 
     [[nodiscard]] std::pair<double, double> confidence_interval(double quantile) const;
     [[nodiscard]] std::pair<double, double> confidence_interval_of_the_mean(double quantile) const;
+
+    void save(Binary_writer& writer) const;
+    void load(Binary_reader& reader);
 private:
-    int n_samples_;
-    double mean_;
-    double m2_;
+    int n_samples_{};
+    double mean_{};
+    double m2_{};
 
-    double last_sample_;
+    double last_sample_{};
 };
 
 std::ostream& operator<<(std::ostream& os, const Distribution& d);
@@ -0,0 +1,37 @@
+#ifndef WOW_SIMULATOR_LINEAR_REGRESSION_HPP
+#define WOW_SIMULATOR_LINEAR_REGRESSION_HPP
+
+#include <cstddef>
+#include <vector>
+
+// Ordinary least squares through the origin, y = sum_j b_j * x_j + noise. Only the normal equations (X'X, X'y, y'y)
+// are kept, so samples can be streamed in and two regressions over the same coefficients merge by adding them up.
+class Linear_regression
+{
+public:
+    explicit Linear_regression(size_t n_coefficients);
+
+    void add_sample(const std::vector<double>& x, double y);
+
+    void add(const Linear_regression& other);
+
+    // needs more samples than coefficients and a design that actually moves every coefficient
+    [[nodiscard]] std::vector<double> coefficients() const;
+
+    // standard error of each coefficient, from the residual variance and (X'X)^-1
+    [[nodiscard]] std::vector<double> standard_errors() const;
+
+    [[nodiscard]] size_t samples() const { return n_samples_; }
+    [[nodiscard]] size_t n_coefficients() const { return n_; }
+
+private:
+    [[nodiscard]] std::vector<double> inverse_xtx() const;
+
+    size_t n_;
+    std::vector<double> xtx_; // n x n, row major
+    std::vector<double> xty_;
+    double yty_{};
+    size_t n_samples_{};
+};
+
+#endif // WOW_SIMULATOR_LINEAR_REGRESSION_HPP
@@ -0,0 +1,56 @@
+#ifndef WOW_SIMULATOR_QUANTILE_SKETCH_HPP
+#define WOW_SIMULATOR_QUANTILE_SKETCH_HPP
+
+#include <cstdint>
+#include <vector>
+
+class Binary_reader;
+class Binary_writer;
+
+// Relative-error quantile sketch (DDSketch). Samples are counted in logarithmically sized buckets, so any quantile
+// is accurate to within relative_accuracy, the covered range grows with the data, and two sketches merge exactly by
+// adding up their bucket counts (which makes them safe to combine across threads and processes).
+// Only meant for non-negative samples, anything below min_positive_value ends up in a dedicated zero bucket.
+class Quantile_sketch
+{
+public:
+    explicit Quantile_sketch(double relative_accuracy = 0.005);
+
+    void add_sample(double sample);
+
+    void add(const Quantile_sketch& other);
+
+    // q in [0, 1], e.g. 0.05 for the 5th percentile
+    [[nodiscard]] double quantile(double q) const;
+
+    [[nodiscard]] int64_t samples() const { return n_samples_; }
+    [[nodiscard]] double min() const { return min_; }
+    [[nodiscard]] double max() const { return max_; }
+    [[nodiscard]] double relative_accuracy() const { return relative_accuracy_; }
+
+    // the relative accuracy is part of the state, a loaded sketch only merges with sketches of the same accuracy
+    void save(Binary_writer& writer) const;
+    void load(Binary_reader& reader);
+
+    static constexpr double min_positive_value = 1e-6;
+
+private:
+    [[nodiscard]] int bucket_index(double value) const;
+    [[nodiscard]] double bucket_value(int index) const;
+
+    void extend_range(int index_min, int index_max);
+
+    double relative_accuracy_;
+    double gamma_;
+    double inv_log_gamma_;
+
+    int offset_{}; // bucket index of counts_[0]
+    std::vector<int64_t> counts_{};
+    int64_t zero_count_{};
+
+    int64_t n_samples_{};
+    double min_{};
+    double max_{};
+};
+
+#endif // WOW_SIMULATOR_QUANTILE_SKETCH_HPP
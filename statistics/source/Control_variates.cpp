@@ -0,0 +1,185 @@
+#include "Control_variates.hpp"
+
+#include "binary_io.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+Control_variates::Control_variates(size_t n_covariates)
+    : n_(n_covariates), sum_x_(n_covariates), sum_xx_(n_covariates * n_covariates), sum_xy_(n_covariates)
+{
+}
+
+void Control_variates::add_sample(double sample, const std::vector<double>& covariates)
+{
+    assert(covariates.size() == n_);
+    for (size_t i = 0; i < n_; i++)
+    {
+        sum_x_[i] += covariates[i];
+        for (size_t j = 0; j < n_; j++)
+        {
+            sum_xx_[i * n_ + j] += covariates[i] * covariates[j];
+        }
+        sum_xy_[i] += covariates[i] * sample;
+    }
+    sum_y_ += sample;
+    sum_yy_ += sample * sample;
+    n_samples_++;
+}
+
+void Control_variates::add(const Control_variates& other)
+{
+    assert(other.n_ == n_);
+    for (size_t i = 0; i < n_; i++)
+    {
+        sum_x_[i] += other.sum_x_[i];
+        sum_xy_[i] += other.sum_xy_[i];
+    }
+    for (size_t i = 0; i < sum_xx_.size(); i++)
+    {
+        sum_xx_[i] += other.sum_xx_[i];
+    }
+    sum_y_ += other.sum_y_;
+    sum_yy_ += other.sum_yy_;
+    n_samples_ += other.n_samples_;
+}
+
+double Control_variates::covariance_xx(size_t i, size_t j) const
+{
+    const auto n = static_cast<double>(n_samples_);
+    return (sum_xx_[i * n_ + j] - sum_x_[i] * sum_x_[j] / n) / (n - 1);
+}
+
+double Control_variates::covariance_xy(size_t i) const
+{
+    const auto n = static_cast<double>(n_samples_);
+    return (sum_xy_[i] - sum_x_[i] * sum_y_ / n) / (n - 1);
+}
+
+double Control_variates::variance_y() const
+{
+    const auto n = static_cast<double>(n_samples_);
+    return std::max((sum_yy_ - sum_y_ * sum_y_ / n) / (n - 1), 0.0);
+}
+
+std::vector<double> Control_variates::coefficients() const
+{
+    std::vector<double> beta(n_);
+    if (n_samples_ <= static_cast<int64_t>(n_) + 1) return beta;
+
+    // covariance matrix | covariances with the samples, solved by Gauss-Jordan with partial pivoting. n is tiny
+    const size_t width = n_ + 1;
+    std::vector<double> a(n_ * width);
+    for (size_t i = 0; i < n_; i++)
+    {
+        for (size_t j = 0; j < n_; j++)
+        {
+            a[i * width + j] = covariance_xx(i, j);
+        }
+        a[i * width + n_] = covariance_xy(i);
+    }
+
+    std::vector<bool> used(n_);
+    std::vector<size_t> pivot_rows(n_, n_);
+    for (size_t col = 0; col < n_; col++)
+    {
+        size_t pivot = n_;
+        for (size_t row = 0; row < n_; row++)
+        {
+            if (used[row]) continue;
+            if (pivot == n_ || std::abs(a[row * width + col]) > std::abs(a[pivot * width + col])) pivot = row;
+        }
+        // a covariate that never moved (or just repeats the others) explains nothing, leave it out
+        if (pivot == n_ || std::abs(a[pivot * width + col]) <= 1e-12 * (1 + std::abs(covariance_xx(col, col))))
+        {
+            continue;
+        }
+        used[pivot] = true;
+        pivot_rows[col] = pivot;
+
+        const double scale = 1 / a[pivot * width + col];
+        for (size_t j = 0; j < width; j++)
+        {
+            a[pivot * width + j] *= scale;
+        }
+        for (size_t row = 0; row < n_; row++)
+        {
+            const double factor = a[row * width + col];
+            if (row == pivot || factor == 0) continue;
+            for (size_t j = 0; j < width; j++)
+            {
+                a[row * width + j] -= factor * a[pivot * width + j];
+            }
+        }
+    }
+
+    for (size_t col = 0; col < n_; col++)
+    {
+        if (pivot_rows[col] < n_) beta[col] = a[pivot_rows[col] * width + n_];
+    }
+    return beta;
+}
+
+double Control_variates::mean() const
+{
+    if (n_samples_ == 0) return 0;
+
+    const auto n = static_cast<double>(n_samples_);
+    double mean = sum_y_ / n;
+    const auto beta = coefficients();
+    for (size_t i = 0; i < n_; i++)
+    {
+        mean -= beta[i] * sum_x_[i] / n;
+    }
+    return mean;
+}
+
+double Control_variates::residual_variance() const
+{
+    const auto beta = coefficients();
+    double explained{};
+    size_t n_used{};
+    for (size_t i = 0; i < n_; i++)
+    {
+        explained += beta[i] * covariance_xy(i);
+        if (beta[i] != 0) n_used++;
+    }
+    const auto n = static_cast<double>(n_samples_);
+    // one degree of freedom per estimated coefficient
+    return std::max(variance_y() - explained, 0.0) * (n - 1) / std::max(n - 1 - static_cast<double>(n_used), 1.0);
+}
+
+double Control_variates::std_of_the_mean() const
+{
+    if (n_samples_ < 2) return 0;
+    return std::sqrt(residual_variance() / static_cast<double>(n_samples_));
+}
+
+double Control_variates::variance_ratio() const
+{
+    if (n_samples_ < 2) return 1;
+    const double variance = variance_y();
+    return variance > 0 ? std::min(residual_variance() / variance, 1.0) : 1;
+}
+
+void Control_variates::save(Binary_writer& writer) const
+{
+    writer.write(n_samples_);
+    writer.write(sum_y_);
+    writer.write(sum_yy_);
+    writer.write(sum_x_);
+    writer.write(sum_xx_);
+    writer.write(sum_xy_);
+}
+
+void Control_variates::load(Binary_reader& reader)
+{
+    reader.read(n_samples_);
+    reader.read(sum_y_);
+    reader.read(sum_yy_);
+    reader.read(sum_x_);
+    reader.read(sum_xx_);
+    reader.read(sum_xy_);
+    n_ = sum_x_.size();
+}
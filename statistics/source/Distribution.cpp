@@ -1,6 +1,7 @@
 #include "Distribution.hpp"
 
 #include "Statistics.hpp"
+#include "binary_io.hpp"
 
 
 void Distribution::add_sample(const double sample)
@@ -16,6 +17,13 @@ void Distribution::add_sample(const double sample)
 
 void Distribution::add(const Distribution& other)
 {
+    if (other.n_samples_ == 0) return;
+    if (n_samples_ == 0)
+    {
+        *this = other;
+        return;
+    }
+
     auto n = n_samples_ + other.n_samples_;
     auto mean = (mean_ * n_samples_ + other.mean_ * other.n_samples_) / n;
     auto delta = mean_ - other.mean_;
@@ -23,6 +31,7 @@ void Distribution::add(const Distribution& other)
     n_samples_ = n;
     mean_ = mean;
     m2_ = m2;
+    last_sample_ = other.last_sample_;
 }
 
 std::pair<double, double> Distribution::confidence_interval(double p_value) const
@@ -38,6 +47,22 @@ std::pair<double, double> Distribution::confidence_interval_of_the_mean(double p
     return std::pair<double, double>{mean_ - val * std_, mean_ + val * std_};
 }
 
+void Distribution::save(Binary_writer& writer) const
+{
+    writer.write(n_samples_);
+    writer.write(mean_);
+    writer.write(m2_);
+    writer.write(last_sample_);
+}
+
+void Distribution::load(Binary_reader& reader)
+{
+    reader.read(n_samples_);
+    reader.read(mean_);
+    reader.read(m2_);
+    reader.read(last_sample_);
+}
+
 std::ostream& operator<<(std::ostream& os, const Distribution& d)
 {
     return os << "mean = " << d.mean() << ", std_of_the_mean = " << d.std_of_the_mean() << ", samples = " << d.samples();
@@ -0,0 +1,124 @@
+#include "Linear_regression.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+Linear_regression::Linear_regression(size_t n_coefficients)
+    : n_(n_coefficients), xtx_(n_coefficients * n_coefficients), xty_(n_coefficients)
+{
+}
+
+void Linear_regression::add_sample(const std::vector<double>& x, double y)
+{
+    assert(x.size() == n_);
+    for (size_t i = 0; i < n_; i++)
+    {
+        for (size_t j = 0; j < n_; j++)
+        {
+            xtx_[i * n_ + j] += x[i] * x[j];
+        }
+        xty_[i] += x[i] * y;
+    }
+    yty_ += y * y;
+    n_samples_++;
+}
+
+void Linear_regression::add(const Linear_regression& other)
+{
+    assert(other.n_ == n_);
+    for (size_t i = 0; i < xtx_.size(); i++)
+    {
+        xtx_[i] += other.xtx_[i];
+    }
+    for (size_t i = 0; i < n_; i++)
+    {
+        xty_[i] += other.xty_[i];
+    }
+    yty_ += other.yty_;
+    n_samples_ += other.n_samples_;
+}
+
+std::vector<double> Linear_regression::inverse_xtx() const
+{
+    // Gauss-Jordan with partial pivoting, n is the number of stats so this is tiny
+    std::vector<double> a = xtx_;
+    std::vector<double> inv(n_ * n_);
+    for (size_t i = 0; i < n_; i++)
+    {
+        inv[i * n_ + i] = 1;
+    }
+    for (size_t col = 0; col < n_; col++)
+    {
+        size_t pivot = col;
+        for (size_t row = col + 1; row < n_; row++)
+        {
+            if (std::abs(a[row * n_ + col]) > std::abs(a[pivot * n_ + col]))
+            {
+                pivot = row;
+            }
+        }
+        assert(a[pivot * n_ + col] != 0);
+        if (pivot != col)
+        {
+            std::swap_ranges(a.begin() + pivot * n_, a.begin() + (pivot + 1) * n_, a.begin() + col * n_);
+            std::swap_ranges(inv.begin() + pivot * n_, inv.begin() + (pivot + 1) * n_, inv.begin() + col * n_);
+        }
+        const double scale = 1 / a[col * n_ + col];
+        for (size_t j = 0; j < n_; j++)
+        {
+            a[col * n_ + j] *= scale;
+            inv[col * n_ + j] *= scale;
+        }
+        for (size_t row = 0; row < n_; row++)
+        {
+            const double factor = a[row * n_ + col];
+            if (row == col || factor == 0)
+            {
+                continue;
+            }
+            for (size_t j = 0; j < n_; j++)
+            {
+                a[row * n_ + j] -= factor * a[col * n_ + j];
+                inv[row * n_ + j] -= factor * inv[col * n_ + j];
+            }
+        }
+    }
+    return inv;
+}
+
+std::vector<double> Linear_regression::coefficients() const
+{
+    const auto inv = inverse_xtx();
+    std::vector<double> b(n_);
+    for (size_t i = 0; i < n_; i++)
+    {
+        for (size_t j = 0; j < n_; j++)
+        {
+            b[i] += inv[i * n_ + j] * xty_[j];
+        }
+    }
+    return b;
+}
+
+std::vector<double> Linear_regression::standard_errors() const
+{
+    assert(n_samples_ > n_);
+    const auto inv = inverse_xtx();
+    const auto b = coefficients();
+
+    // residual sum of squares = y'y - b'X'y at the least squares solution
+    double rss = yty_;
+    for (size_t i = 0; i < n_; i++)
+    {
+        rss -= b[i] * xty_[i];
+    }
+    const double sigma2 = std::max(rss, 0.0) / static_cast<double>(n_samples_ - n_);
+
+    std::vector<double> se(n_);
+    for (size_t i = 0; i < n_; i++)
+    {
+        se[i] = std::sqrt(sigma2 * inv[i * n_ + i]);
+    }
+    return se;
+}
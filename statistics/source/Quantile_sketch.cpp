@@ -0,0 +1,130 @@
+#include "Quantile_sketch.hpp"
+
+#include "binary_io.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+Quantile_sketch::Quantile_sketch(double relative_accuracy)
+    : relative_accuracy_(relative_accuracy)
+    , gamma_((1 + relative_accuracy) / (1 - relative_accuracy))
+    , inv_log_gamma_(1 / std::log(gamma_))
+{
+    assert(relative_accuracy > 0 && relative_accuracy < 1);
+}
+
+int Quantile_sketch::bucket_index(double value) const
+{
+    return static_cast<int>(std::ceil(std::log(value) * inv_log_gamma_));
+}
+
+double Quantile_sketch::bucket_value(int index) const
+{
+    // bucket i covers (gamma^(i-1), gamma^i], this is the point with equal relative distance to both ends
+    return 2 * std::pow(gamma_, index) / (gamma_ + 1);
+}
+
+void Quantile_sketch::extend_range(int index_min, int index_max)
+{
+    if (counts_.empty())
+    {
+        offset_ = index_min;
+        counts_.assign(index_max - index_min + 1, 0);
+        return;
+    }
+
+    if (index_min < offset_)
+    {
+        counts_.insert(counts_.begin(), offset_ - index_min, 0);
+        offset_ = index_min;
+    }
+    if (index_max >= offset_ + static_cast<int>(counts_.size()))
+    {
+        counts_.resize(index_max - offset_ + 1, 0);
+    }
+}
+
+void Quantile_sketch::add_sample(double sample)
+{
+    min_ = n_samples_ == 0 ? sample : std::min(min_, sample);
+    max_ = n_samples_ == 0 ? sample : std::max(max_, sample);
+    n_samples_ += 1;
+
+    if (sample < min_positive_value)
+    {
+        zero_count_ += 1;
+        return;
+    }
+
+    int index = bucket_index(sample);
+    extend_range(index, index);
+    counts_[index - offset_] += 1;
+}
+
+void Quantile_sketch::add(const Quantile_sketch& other)
+{
+    assert(relative_accuracy_ == other.relative_accuracy_);
+    if (other.n_samples_ == 0) return;
+
+    min_ = n_samples_ == 0 ? other.min_ : std::min(min_, other.min_);
+    max_ = n_samples_ == 0 ? other.max_ : std::max(max_, other.max_);
+    n_samples_ += other.n_samples_;
+    zero_count_ += other.zero_count_;
+
+    if (other.counts_.empty()) return;
+
+    extend_range(other.offset_, other.offset_ + static_cast<int>(other.counts_.size()) - 1);
+    for (size_t i = 0; i < other.counts_.size(); i++)
+    {
+        counts_[other.offset_ - offset_ + i] += other.counts_[i];
+    }
+}
+
+double Quantile_sketch::quantile(double q) const
+{
+    if (n_samples_ == 0) return 0;
+
+    q = std::min(std::max(q, 0.0), 1.0);
+    auto rank = static_cast<int64_t>(q * static_cast<double>(n_samples_ - 1));
+
+    if (rank < zero_count_) return min_;
+
+    int64_t count = zero_count_;
+    for (size_t i = 0; i < counts_.size(); i++)
+    {
+        count += counts_[i];
+        if (count > rank)
+        {
+            return std::min(std::max(bucket_value(offset_ + static_cast<int>(i)), min_), max_);
+        }
+    }
+    return max_;
+}
+
+void Quantile_sketch::save(Binary_writer& writer) const
+{
+    writer.write(relative_accuracy_);
+    writer.write(offset_);
+    writer.write(counts_);
+    writer.write(zero_count_);
+    writer.write(n_samples_);
+    writer.write(min_);
+    writer.write(max_);
+}
+
+void Quantile_sketch::load(Binary_reader& reader)
+{
+    double relative_accuracy{};
+    reader.read(relative_accuracy);
+    if (relative_accuracy > 0 && relative_accuracy < 1)
+    {
+        *this = Quantile_sketch{relative_accuracy};
+    }
+    reader.read(offset_);
+    reader.read(counts_);
+    reader.read(zero_count_);
+    reader.read(n_samples_);
+    reader.read(min_);
+    reader.read(max_);
+}
@@ -0,0 +1,48 @@
+#include "Control_variates.hpp"
+
+#include "gtest/gtest.h"
+#include <random>
+
+TEST(TestSuite, test_control_variates)
+{
+    // y = 10 + 3 * x + noise, with x zero-mean; a constant covariate never moves and has to be left out
+    std::default_random_engine generator{};
+    std::normal_distribution<double> noise(0.0, 1.0);
+    std::normal_distribution<double> covariate(0.0, 4.0);
+
+    Control_variates first{2};
+    Control_variates second{2};
+    for (int i = 0; i < 10000; ++i)
+    {
+        const double x = covariate(generator);
+        const double y = 10 + 3 * x + noise(generator);
+        (i % 2 ? first : second).add_sample(y, {x, 0.0});
+    }
+    first.add(second);
+    EXPECT_EQ(first.samples(), 10000);
+
+    const auto beta = first.coefficients();
+    EXPECT_NEAR(beta[0], 3, 0.05);
+    EXPECT_EQ(beta[1], 0);
+
+    // the plain mean scatters with sqrt(9 * 16 + 1) / sqrt(n) ~ 0.12, the adjusted one with 1 / sqrt(n)
+    EXPECT_NEAR(first.std_of_the_mean(), 0.01, 0.001);
+    EXPECT_NEAR(first.mean(), 10, 4 * 0.01);
+    EXPECT_LT(first.variance_ratio(), 0.01);
+}
+
+TEST(TestSuite, test_control_variates_uncorrelated)
+{
+    std::default_random_engine generator{};
+    std::normal_distribution<double> noise(0.0, 1.0);
+
+    Control_variates cv{1};
+    for (int i = 0; i < 10000; ++i)
+    {
+        cv.add_sample(5 + noise(generator), {noise(generator)});
+    }
+    EXPECT_NEAR(cv.coefficients()[0], 0, 0.05);
+    EXPECT_NEAR(cv.std_of_the_mean(), 0.01, 0.001);
+    EXPECT_NEAR(cv.mean(), 5, 0.04);
+    EXPECT_NEAR(cv.variance_ratio(), 1, 0.01);
+}
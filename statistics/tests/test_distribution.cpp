@@ -49,3 +49,24 @@ TEST(TestSuite, test_distribution_confidence_interval)
     double expected_oob_samples = n_namples * (1 - p_value);
     EXPECT_NEAR(n_samples_out_of_bound, expected_oob_samples, .05 * expected_oob_samples);
 }
+
+TEST(TestSuite, test_distribution_add)
+{
+    Distribution all{};
+    Distribution first{};
+    Distribution second{};
+    for (int i = 0; i < 10; ++i)
+    {
+        all.add_sample(i * i);
+        (i < 4 ? first : second).add_sample(i * i);
+    }
+
+    Distribution merged{};
+    merged.add(Distribution{}); // merging empty distributions is a no-op
+    merged.add(first);
+    merged.add(second);
+
+    EXPECT_EQ(merged.samples(), all.samples());
+    EXPECT_DOUBLE_EQ(merged.mean(), all.mean());
+    EXPECT_NEAR(merged.variance(), all.variance(), 1e-9);
+}
@@ -0,0 +1,54 @@
+#include "Linear_regression.hpp"
+
+#include "gtest/gtest.h"
+#include <random>
+
+TEST(TestSuite, test_linear_regression_exact)
+{
+    Linear_regression regression{2};
+    regression.add_sample({1, 0}, 3);
+    regression.add_sample({0, 1}, -2);
+    regression.add_sample({1, 1}, 1);
+    regression.add_sample({1, -1}, 5);
+
+    auto b = regression.coefficients();
+    EXPECT_NEAR(b[0], 3, 1e-12);
+    EXPECT_NEAR(b[1], -2, 1e-12);
+    for (double se : regression.standard_errors())
+    {
+        EXPECT_NEAR(se, 0, 1e-6);
+    }
+}
+
+TEST(TestSuite, test_linear_regression_noise)
+{
+    std::default_random_engine generator{};
+    std::normal_distribution<double> noise(0.0, 2.0);
+    std::bernoulli_distribution sign{};
+    const std::vector<double> truth{1.5, -0.5, 4.0};
+
+    Linear_regression first{3};
+    Linear_regression second{3};
+    for (int i = 0; i < 20000; ++i)
+    {
+        std::vector<double> x(3);
+        double y = noise(generator);
+        for (size_t j = 0; j < 3; j++)
+        {
+            x[j] = sign(generator) ? 1.0 : -1.0;
+            y += truth[j] * x[j];
+        }
+        (i % 2 ? first : second).add_sample(x, y);
+    }
+    first.add(second);
+    EXPECT_EQ(first.samples(), 20000u);
+
+    auto b = first.coefficients();
+    auto se = first.standard_errors();
+    for (size_t j = 0; j < 3; j++)
+    {
+        // rademacher design: X'X ~ n * I, so the standard error is ~ sigma / sqrt(n)
+        EXPECT_NEAR(se[j], 2.0 / std::sqrt(20000.0), 0.002);
+        EXPECT_NEAR(b[j], truth[j], 4 * se[j]);
+    }
+}
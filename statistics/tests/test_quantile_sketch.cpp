@@ -0,0 +1,56 @@
+#include "Quantile_sketch.hpp"
+
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <random>
+
+TEST(TestSuite, test_quantile_sketch)
+{
+    std::default_random_engine generator{};
+    std::normal_distribution<double> nd(3000.0, 300.0);
+
+    Quantile_sketch sketch{};
+    std::vector<double> samples;
+    for (int i = 0; i < 100000; ++i)
+    {
+        double sample = nd(generator);
+        sketch.add_sample(sample);
+        samples.push_back(sample);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    for (double q : {0.01, 0.05, 0.5, 0.95, 0.99})
+    {
+        double exact = samples[static_cast<size_t>(q * (samples.size() - 1))];
+        EXPECT_NEAR(sketch.quantile(q), exact, sketch.relative_accuracy() * exact);
+    }
+    EXPECT_DOUBLE_EQ(sketch.quantile(0), samples.front());
+    EXPECT_DOUBLE_EQ(sketch.quantile(1), samples.back());
+}
+
+TEST(TestSuite, test_quantile_sketch_merge)
+{
+    std::default_random_engine generator{};
+    std::exponential_distribution<double> ed(1 / 5000.0);
+
+    Quantile_sketch all{};
+    Quantile_sketch low{};
+    Quantile_sketch high{};
+    for (int i = 0; i < 10000; ++i)
+    {
+        double sample = i % 100 == 0 ? 0 : ed(generator);
+        all.add_sample(sample);
+        // differently sized ranges, so merging has to extend the buckets on both sides
+        (sample < 5000 ? low : high).add_sample(sample);
+    }
+
+    Quantile_sketch merged{};
+    merged.add(high);
+    merged.add(low);
+
+    EXPECT_EQ(merged.samples(), all.samples());
+    for (double q : {0.0, 0.005, 0.05, 0.5, 0.95, 1.0})
+    {
+        EXPECT_DOUBLE_EQ(merged.quantile(q), all.quantile(q));
+    }
+}
@@ -14,6 +14,12 @@ EMSCRIPTEN_BINDINGS(module)
     register_vector<std::vector<double>>("vector<vector<double>>");
     register_vector<std::vector<std::string>>("StringListList");
     register_vector<std::string>("StringList");
+    register_vector<Named_value>("NamedValueList");
+    register_vector<Estimate>("EstimateList");
+    register_vector<Use_effect_timing>("UseEffectTimingList");
+    register_vector<Item_upgrade_result>("ItemUpgradeResultList");
+    register_vector<Dpr_result>("DprResultList");
+    register_vector<Notable_fight>("NotableFightList");
 
     value_object<Sim_input>("Sim_input")
         .field("race", &Sim_input::race)
@@ -45,5 +51,94 @@ EMSCRIPTEN_BINDINGS(module)
         .field("histogram_details", &Sim_output::histogram_details)
         .field("mean_dps", &Sim_output::mean_dps)
         .field("std_dps", &Sim_output::std_dps)
-        .field("messages", &Sim_output::messages);
+        .field("messages", &Sim_output::messages)
+        .field("dps_percentiles", &Sim_output::dps_percentiles)
+        .field("fight_lengths", &Sim_output::fight_lengths)
+        .field("fight_length_dps", &Sim_output::fight_length_dps)
+        .field("response_surface", &Sim_output::response_surface)
+        .field("results", &Sim_output::results);
+
+    value_object<Named_value>("Named_value")
+        .field("name", &Named_value::name)
+        .field("value", &Named_value::value);
+
+    value_object<Estimate>("Estimate")
+        .field("name", &Estimate::name)
+        .field("mean", &Estimate::mean)
+        .field("error", &Estimate::error);
+
+    value_object<Use_effect_timing>("Use_effect_timing")
+        .field("name", &Use_effect_timing::name)
+        .field("time", &Use_effect_timing::time)
+        .field("duration", &Use_effect_timing::duration);
+
+    enum_<Socket>("Socket")
+        .value("none", Socket::none)
+        .value("head", Socket::head)
+        .value("neck", Socket::neck)
+        .value("shoulder", Socket::shoulder)
+        .value("back", Socket::back)
+        .value("chest", Socket::chest)
+        .value("wrist", Socket::wrist)
+        .value("hands", Socket::hands)
+        .value("belt", Socket::belt)
+        .value("legs", Socket::legs)
+        .value("boots", Socket::boots)
+        .value("ring", Socket::ring)
+        .value("trinket", Socket::trinket)
+        .value("main_hand", Socket::main_hand)
+        .value("off_hand", Socket::off_hand)
+        .value("ranged", Socket::ranged);
+
+    value_object<Item_upgrade_result>("Item_upgrade_result")
+        .field("socket", &Item_upgrade_result::socket)
+        .field("first_item", &Item_upgrade_result::first_item)
+        .field("current_item", &Item_upgrade_result::current_item)
+        .field("item", &Item_upgrade_result::item)
+        .field("dps_diff", &Item_upgrade_result::dps_diff)
+        .field("error", &Item_upgrade_result::error);
+
+    value_object<Dpr_result>("Dpr_result")
+        .field("ability", &Dpr_result::ability)
+        .field("damage_per_cast", &Dpr_result::damage_per_cast)
+        .field("rage_cost", &Dpr_result::rage_cost);
+
+    value_object<Notable_fight>("Notable_fight")
+        .field("name", &Notable_fight::name)
+        .field("batch", &Notable_fight::batch)
+        .field("dps", &Notable_fight::dps);
+
+    value_object<Surrogate_validation>("Surrogate_validation")
+        .field("n_items", &Surrogate_validation::n_items)
+        .field("mean_error", &Surrogate_validation::mean_error)
+        .field("rms_error", &Surrogate_validation::rms_error)
+        .field("rms_dps_diff", &Surrogate_validation::rms_dps_diff)
+        .field("n_pruned", &Surrogate_validation::n_pruned)
+        .field("pruned_mean_error", &Surrogate_validation::pruned_mean_error)
+        .field("pruned_rms_error", &Surrogate_validation::pruned_rms_error)
+        .field("n_pruned_better", &Surrogate_validation::n_pruned_better);
+
+    value_object<Sim_results>("Sim_results")
+        .field("unknown_options", &Sim_results::unknown_options)
+        .field("dual_wield", &Sim_results::dual_wield)
+        .field("dps_std", &Sim_results::dps_std)
+        .field("adjusted_dps", &Sim_results::adjusted_dps)
+        .field("adjusted_dps_variance_ratio", &Sim_results::adjusted_dps_variance_ratio)
+        .field("character_stats", &Sim_results::character_stats)
+        .field("set_bonuses", &Sim_results::set_bonuses)
+        .field("fight_stats", &Sim_results::fight_stats)
+        .field("rage_lost_capped", &Sim_results::rage_lost_capped)
+        .field("rage_lost_stance", &Sim_results::rage_lost_stance)
+        .field("aura_uptimes", &Sim_results::aura_uptimes)
+        .field("procs", &Sim_results::procs)
+        .field("use_effects", &Sim_results::use_effects)
+        .field("schedule_search_gain", &Sim_results::schedule_search_gain)
+        .field("stat_weights", &Sim_results::stat_weights)
+        .field("talent_weights", &Sim_results::talent_weights)
+        .field("item_upgrades", &Sim_results::item_upgrades)
+        .field("uneven_weapon_specializations", &Sim_results::uneven_weapon_specializations)
+        .field("surrogate_weights", &Sim_results::surrogate_weights)
+        .field("surrogate_validation", &Sim_results::surrogate_validation)
+        .field("dpr", &Sim_results::dpr)
+        .field("notable_fights", &Sim_results::notable_fights);
 };
\ No newline at end of file
@@ -243,10 +243,6 @@ public:
     bool affects_both_weapons{}; // unused
     int max_stacks{1};
 
-    int time_counter{}; // "next_ready", aka cooldown end
-
-    int procs{}; // statistics
-
     int combat_buff_idx{-1}; // "link" to combat buff
 };
 